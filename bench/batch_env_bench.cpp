@@ -0,0 +1,68 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <game_server/batch_env.hpp>
+
+/*
+    Steps per second of the batched environment, over a growing number of threads.
+    Every instance holds a different arrow combination that changes every few ticks,
+    and a game that is over is reset with a new seed, so all instances keep playing.
+*/
+namespace {
+    constexpr size_t   BENCH_INSTANCES  = 2048;
+    constexpr uint64_t BENCH_TICKS      = 600;
+
+    double run(size_t worker_count) {
+        WorkerPool worker_pool(worker_count);
+        BatchEnv env(BENCH_INSTANCES, worker_pool);
+
+        std::vector<uint8_t> actions(BENCH_INSTANCES);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (uint64_t tick = 0; tick < BENCH_TICKS; tick++)
+        {
+            for (size_t i = 0; i < BENCH_INSTANCES; i++)
+            {
+                actions[i] = static_cast<uint8_t>((i + tick / 10) % 16);
+            }
+
+            env.step(actions.data());
+
+            for (size_t i = 0; i < BENCH_INSTANCES; i++)
+            {
+                if (env.get_infos()[i].done)
+                {
+                    env.reset(i, static_cast<uint32_t>(tick * BENCH_INSTANCES + i));
+                }
+            }
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return BENCH_INSTANCES * BENCH_TICKS / std::chrono::duration<double>(elapsed).count();
+    }
+}
+
+int main() {
+    const size_t max_workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    for (size_t worker_count = 0; ; worker_count = std::min(worker_count * 2 + 1, max_workers))
+    {
+        const auto steps_per_sec = run(worker_count);
+
+        std::cout << "[batch_env_bench] "
+                  << std::setw(2) << worker_count + 1 << " threads: "
+                  << std::fixed << std::setprecision(0) << steps_per_sec << " steps/s, "
+                  << std::setprecision(1) << steps_per_sec / game_constants::TARGET_FPS << "x real time" << "\n";
+
+        if (worker_count == max_workers)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
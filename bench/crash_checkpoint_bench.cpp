@@ -0,0 +1,184 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <game_server/crash_checkpoint.hpp>
+#include <game_server/diag_logger.hpp>
+
+/*
+    Cost of the crash-recovery checkpoints for a growing number of live sessions.
+
+    One thread ticks every session in turn for BENCH_MSEC, holding its slot for
+    the tick like an instance thread does, while the checkpointer forks a
+    snapshot every CHECKPOINT_MSEC in the background. The tick times are
+    compared with a run without checkpoints: the pause is the time the sessions
+    were held for the fork, the tick impact what the wait for the fork and the
+    copy on write faults add to the ticks.
+
+    The last run writes the diagnostics to a reader that takes SLOW_LOG_MSEC
+    for every write, like a stalled terminal or log pipe, while the ticks log.
+    The fork must not wait for it.
+*/
+namespace {
+    constexpr int64_t  CHECKPOINT_MSEC  = 100;
+    constexpr uint64_t WARMUP_TICKS     = 600;
+    constexpr int64_t  BENCH_MSEC       = 1000;
+    constexpr int64_t  SLOW_LOG_MSEC    = 200;
+
+    // Stands in for a reader that does not keep up
+    class SlowStreamBuf : public std::stringbuf {
+    protected:
+        std::streamsize xsputn(const char* data, std::streamsize size) override {
+            std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_LOG_MSEC));
+
+            return std::stringbuf::xsputn(data, size);
+        }
+    };
+
+    struct TickTimes {
+        double  mean_usec;
+        double  p99_usec;
+        double  max_usec;
+    };
+
+    TickTimes summarize(std::vector<double>& tick_usec) {
+        std::sort(tick_usec.begin(), tick_usec.end());
+
+        double total = 0.0;
+
+        for (const auto usec : tick_usec)
+        {
+            total += usec;
+        }
+
+        return {
+            total / tick_usec.size(),
+            tick_usec[tick_usec.size() * 99 / 100],
+            tick_usec.back()
+        };
+    }
+
+    TickTimes run(size_t session_count, CrashCheckpointer* checkpointer, bool log_ticks) {
+        BulletUpdater bullet_updater;
+        std::vector<std::unique_ptr<GameSession>> sessions;
+        std::vector<std::shared_ptr<CrashCheckpointer::Slot>> slots;
+
+        for (size_t i = 0; i < session_count; i++)
+        {
+            sessions.push_back(std::make_unique<GameSession>(static_cast<uint32_t>(i + 1)));
+
+            // Into the patterns, with bullets on screen
+            for (uint64_t tick = 0; tick < WARMUP_TICKS; tick++)
+            {
+                sessions.back()->step(bullet_updater);
+            }
+
+            if (checkpointer)
+            {
+                slots.push_back(checkpointer->add_session(i, *sessions.back()));
+            }
+        }
+
+        if (checkpointer)
+        {
+            checkpointer->start();
+        }
+
+        std::vector<double> tick_usec;
+        const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(BENCH_MSEC);
+
+        while (std::chrono::steady_clock::now() < end)
+        {
+            for (size_t i = 0; i < session_count; i++)
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                if (checkpointer)
+                {
+                    std::lock_guard<std::mutex> lock(slots[i]->mutex);
+                    sessions[i]->step(bullet_updater);
+                }
+                else
+                {
+                    sessions[i]->step(bullet_updater);
+                }
+
+                tick_usec.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            if (log_ticks)
+            {
+                DIAG_ERROR("crash_checkpoint_bench", "Round of " << session_count << " ticks done");
+            }
+        }
+
+        if (checkpointer)
+        {
+            checkpointer->stop();
+
+            for (const auto& slot : slots)
+            {
+                checkpointer->remove_session(slot);
+            }
+        }
+
+        return summarize(tick_usec);
+    }
+}
+
+void report(const char* label, size_t session_count, const TickTimes& baseline, const TickTimes& checkpointed, const CheckpointStats& stats) {
+    std::cout << "[crash_checkpoint_bench] " << std::setw(3) << session_count << " sessions" << label << ": "
+              << stats.checkpoints << " checkpoints of " << stats.last_bytes / 1024 << " KB, "
+              << "pause " << stats.last_pause_usec << " usec (max " << stats.max_pause_usec << ", "
+              << "fork " << stats.last_fork_usec << "), "
+              << "written in " << stats.last_write_usec / 1000 << " ms" << "\n"
+              << std::fixed << std::setprecision(1)
+              << "                          tick mean " << baseline.mean_usec << " -> " << checkpointed.mean_usec << " usec, "
+              << "p99 " << baseline.p99_usec << " -> " << checkpointed.p99_usec << " usec, "
+              << "max " << baseline.max_usec << " -> " << checkpointed.max_usec << " usec" << "\n";
+}
+
+int main() {
+    const auto path = "/tmp/crash_checkpoint_bench_" + std::to_string(getpid());
+
+    for (const size_t session_count : { 16, 64, 256 })
+    {
+        const auto baseline = run(session_count, nullptr, false);
+
+        CrashCheckpointer checkpointer(path, CHECKPOINT_MSEC);
+        const auto checkpointed = run(session_count, &checkpointer, false);
+
+        report("", session_count, baseline, checkpointed, checkpointer.get_stats());
+    }
+
+    // Diagnostics to a stalled reader
+    {
+        constexpr size_t session_count = 64;
+
+        SlowStreamBuf slow_buf;
+        std::ostream slow_stream(&slow_buf);
+
+        DiagLogger::instance().flush();
+        DiagLogger::instance().set_output(slow_stream, slow_stream);
+
+        const auto baseline = run(session_count, nullptr, true);
+
+        CrashCheckpointer checkpointer(path, CHECKPOINT_MSEC);
+        const auto checkpointed = run(session_count, &checkpointer, true);
+
+        DiagLogger::instance().set_output(std::cout, std::cerr);
+
+        report(", slow log reader", session_count, baseline, checkpointed, checkpointer.get_stats());
+    }
+
+    std::remove(path.c_str());
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <game_server/game_server_constants.hpp>
+#include <game_server/enemy_world.hpp>
+
+/*
+    Cost of the enemy tick (motion, follow, emitters, snapshot) for a growing number of enemies.
+    The bullets are dropped every tick so that only the enemy systems are measured.
+*/
+namespace {
+    constexpr uint64_t BENCH_TICKS = 3600;
+
+    double run(size_t enemy_count) {
+        EnemyWorld world;
+        FrameSnapshot frame = {};
+        PlayerSnapshot player = {};
+        player.pos = { 0.0f, -120.0f };
+        frame.player_vector.push_back(player);
+
+        for (size_t i = 0; i < enemy_count; i++)
+        {
+            const float x = -game_constants::GAME_WIDTH_HALF + game_constants::GAME_WIDTH * (i + 0.5f) / enemy_count;
+            spawn_default_enemy(world, static_cast<uint32_t>(i), { x, 120.0f });
+        }
+
+        std::mt19937 gen(0);
+        uint32_t bullet_id = 0;
+        size_t bullets = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (uint64_t tick = 1; tick <= BENCH_TICKS; tick++)
+        {
+            frame.timestamp = tick;
+            update_enemies(world, frame, gen, bullet_id);
+
+            bullets += frame.bullet_vector.size();
+            frame.bullet_vector.clear();
+            frame.bullet_count = 0;
+        }
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto nsec = std::chrono::duration<double, std::nano>(elapsed).count();
+
+        // Keep the result alive
+        if (bullets == 0)
+        {
+            std::cerr << "[enemy_world_bench] ERROR: No bullet has been fired" << "\n";
+        }
+
+        return nsec / BENCH_TICKS;
+    }
+}
+
+int main() {
+    for (const size_t enemy_count : { 1, 50, 500 })
+    {
+        const auto nsec_per_tick = run(enemy_count);
+
+        std::cout << "[enemy_world_bench] "
+                  << std::setw(4) << enemy_count << " enemies: "
+                  << std::fixed << std::setprecision(1) << nsec_per_tick << " ns/tick, "
+                  << std::setprecision(3) << nsec_per_tick / enemy_count << " ns/enemy" << "\n";
+    }
+
+    return 0;
+}
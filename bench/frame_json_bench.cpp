@@ -0,0 +1,131 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <game_server/game_session.hpp>
+#include <game_server/frame_json_writer.hpp>
+
+/*
+    Playlog encoding: frame_to_json_str() plus the copy async_log used to make,
+    against FrameJsonWriter writing into a reused buffer and a recycled line.
+    Allocations are counted by replacing the global operator new.
+*/
+namespace {
+    std::atomic<uint64_t> g_allocations{0};
+}
+
+// GCC takes the free() below for a mismatch once it inlines the replaced operators
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    g_allocations++;
+
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+namespace {
+    constexpr int WARMUP_TICKS = 600;
+    constexpr int BENCH_ROUNDS = 200;
+
+    struct Result {
+        double mb_per_sec;
+        double allocations_per_frame;
+    };
+
+    // A frame per tick of a running game, so the bullet counts vary like in a real log
+    std::vector<FrameSnapshot> record_frames() {
+        BulletUpdater bullet_updater;
+        GameSession session(7);
+        std::vector<FrameSnapshot> frames;
+
+        for (int tick = 0; tick < WARMUP_TICKS; tick++)
+        {
+            session.step(bullet_updater);
+            frames.push_back(session.get_frame());
+        }
+
+        return frames;
+    }
+
+    template <typename Encode>
+    Result run(const std::vector<FrameSnapshot>& frames, Encode encode) {
+        size_t bytes = 0;
+
+        // One pass to let the reused buffers grow
+        for (const auto& frame : frames)
+        {
+            encode(frame);
+        }
+
+        const auto allocations_before = g_allocations.load();
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int round = 0; round < BENCH_ROUNDS; round++)
+        {
+            for (const auto& frame : frames)
+            {
+                bytes += encode(frame);
+            }
+        }
+
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const auto allocations = g_allocations.load() - allocations_before;
+        const auto frame_count = static_cast<double>(frames.size()) * BENCH_ROUNDS;
+
+        return { bytes / elapsed / (1024.0 * 1024.0), allocations / frame_count };
+    }
+
+    void print(const char* name, const Result& result) {
+        std::cout << std::left << std::setw(24) << name << std::right
+                  << std::fixed << std::setprecision(1) << std::setw(10) << result.mb_per_sec << " MB/s"
+                  << std::setprecision(2) << std::setw(10) << result.allocations_per_frame << " allocs/frame" << "\n";
+    }
+}
+
+int main() {
+    const auto frames = record_frames();
+
+    // What the game loop did: a fresh string, then a copy into the log queue
+    std::string queued;
+
+    const auto current = run(frames, [&](const FrameSnapshot& frame) {
+        const auto log_message = frame_to_json_str(frame);
+        queued = std::string(log_message);
+
+        return queued.size();
+    });
+
+    // Encoded in place, copied into a line that keeps its capacity
+    FrameJsonWriter writer;
+    std::string line;
+
+    const auto streaming = run(frames, [&](const FrameSnapshot& frame) {
+        line.assign(writer.write(frame));
+
+        return line.size();
+    });
+
+    print("frame_to_json_str", current);
+    print("FrameJsonWriter", streaming);
+
+    return 0;
+}
@@ -1,12 +1,69 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 #include <string_view>
 
 namespace socket_constants {
     constexpr std::string_view      SERVER_ADDR             = "127.0.0.1";
     constexpr uint16_t              SERVER_PORT             = 22222;
-    constexpr size_t                SERVER_MAX_INSTANCES    = 100;
+    constexpr size_t                SERVER_MAX_INSTANCES    = 1000;    // Hard ceiling, admission follows the CPU budget
 
     constexpr uint32_t  SERVER_MAX_PACKET_SIZE  = 10 * 1024 * 1024; // 10MB
-}
\ No newline at end of file
+}
+
+namespace simulation_constants {
+    // The bullet pass of an instance is split across the shared worker pool above this bullet count
+    constexpr size_t    PARALLEL_BULLET_THRESHOLD   = 20000;
+    constexpr bool      PARALLEL_BULLET_ENABLED     = true;
+    constexpr size_t    PARALLEL_BULLET_WORKERS     = 0;    // 0: one per hardware thread
+}
+
+namespace admission_constants {
+    // New instances are admitted while the projected load stays under this fraction of the cores
+    constexpr double    TARGET_CPU_UTILIZATION  = 0.75;
+    constexpr uint32_t  UTILIZATION_WINDOW_MSEC = 1000;
+    constexpr double    DEFAULT_INSTANCE_LOAD   = 0.05;     // Cores, until an instance has been measured
+}
+
+namespace supervisor_constants {
+    constexpr uint32_t  WORKER_RESTART_DELAY_MSEC   = 1000;
+    constexpr uint32_t  POLL_INTERVAL_MSEC          = 200;
+    constexpr size_t    MAX_WORKERS                 = 256;
+}
+
+namespace handoff_constants {
+    // Unix domain socket a successor process connects to, to take the live sessions over.
+    // Its directory is created private to the user, the listener refuses a directory others may enter
+    constexpr std::string_view  HANDOFF_SOCKET_PATH     = "/tmp/bullet_hell_server/handoff.sock";
+
+    // A successor proves it was started by the same operator with the token stored next to the socket
+    constexpr size_t            TOKEN_SIZE              = 16;
+    constexpr uint32_t          TOKEN_TIMEOUT_MSEC      = 1000;
+
+    // The successor retries to bind the server port until the predecessor has released it
+    constexpr uint32_t          BIND_RETRY_MSEC         = 50;
+    constexpr uint32_t          BIND_MAX_ATTEMPTS       = 100;
+
+    // How long the predecessor waits for its instances to be handed over before it gives up on the rest
+    constexpr uint32_t          DRAIN_TIMEOUT_MSEC      = 5000;
+
+    // Steps a handshake waits in, so a drain ends it right away
+    constexpr uint32_t          HANDSHAKE_POLL_MSEC     = 10;
+}
+
+namespace stage_file_constants {
+    // Relative to the working directory, the Docker image ships it next to the binary
+    constexpr std::string_view  DEFAULT_STAGE_PATH  = "stages/default.lua";
+}
+
+namespace analytics_constants {
+    // Where GameLogger moves the finished playlogs
+    constexpr std::string_view  DEFAULT_PLAYLOG_DIR     = "/mnt/data";
+
+    // Segments of the columnar store per scan thread, so a few large playlogs do not leave threads idle
+    constexpr size_t            SEGMENTS_PER_THREAD     = 4;
+
+    constexpr float             HEATMAP_CELL_SIZE       = 32.0f;
+    constexpr uint32_t          DENSITY_BUCKET_TICKS    = 60;
+}
@@ -8,6 +8,8 @@
 #include <fstream>
 
 namespace {
+    constexpr size_t MAX_FREE_LINES = 64;
+
     std::string default_hostname() {
         if (const char* env = std::getenv("HOSTNAME"))
         {
@@ -111,6 +113,11 @@ GameLogger::~GameLogger() noexcept {
 
     if (src && dst)
     {
+        if (!m_header.empty())
+        {
+            dst << m_header << "\n";
+        }
+
         dst << src.rdbuf();
     }
 
@@ -127,7 +134,7 @@ GameLogger::~GameLogger() noexcept {
     }
 }
 
-void GameLogger::async_log(const std::string& log_message) {
+void GameLogger::async_log(std::string_view log_message) {
     if (!m_running.load())
     {
         return;
@@ -135,12 +142,27 @@ void GameLogger::async_log(const std::string& log_message) {
 
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_log_queue.push(log_message);
+
+        std::string line;
+
+        if (!m_free_lines.empty())
+        {
+            line = std::move(m_free_lines.back());
+            m_free_lines.pop_back();
+        }
+
+        line.assign(log_message);
+        m_log_queue.push(std::move(line));
     }
 
     m_cv.notify_one();
 }
 
+void GameLogger::set_header(const std::string& header) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_header = header;
+}
+
 void GameLogger::writing_worker() {
     while (m_running.load() || !m_log_queue.empty())
     {
@@ -167,6 +189,11 @@ void GameLogger::writing_worker() {
             }
 
             lock.lock();
+
+            if (m_free_lines.size() < MAX_FREE_LINES)
+            {
+                m_free_lines.push_back(std::move(log));
+            }
         }
     }
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <fstream>
 #include <filesystem>
 #include <queue>
@@ -20,7 +22,10 @@ public:
 
     ~GameLogger() noexcept;
 
-    void async_log(const std::string& log_message);
+    void async_log(std::string_view log_message);   // Copied into a recycled line buffer
+
+    // First line of the playlog, written when the log is finalized
+    void set_header(const std::string& header);
 
 private:
     // File / Directory
@@ -35,6 +40,7 @@ private:
     fs::path      m_data_dir;
     std::ofstream m_cache_file;
     std::ofstream m_data_file;
+    std::string   m_header;
 
     // Variables for Async Logging
     std::atomic<bool>       m_running{false};
@@ -42,6 +48,7 @@ private:
     std::mutex              m_mutex;
     std::condition_variable m_cv;
     std::queue<std::string> m_log_queue;
+    std::vector<std::string> m_free_lines;  // Written lines, their capacity is reused
 
     // Worker thread
     void writing_worker();
@@ -0,0 +1,112 @@
+#include "admission_controller.hpp"
+
+#include <algorithm>    // std::max
+
+const char* admission_result_str(AdmissionResult result) {
+    switch (result)
+    {
+        case AdmissionResult::Accepted:         return "Accepted";
+        case AdmissionResult::InstanceLimit:    return "InstanceLimit";
+        case AdmissionResult::CpuBudget:        return "CpuBudget";
+    }
+
+    return "Unknown";
+}
+
+AdmissionController::AdmissionController(
+    double      cpu_capacity,
+    double      target_utilization,
+    size_t      max_instances,
+    Duration    window,
+    double      default_instance_load
+)
+    : m_cpu_capacity(cpu_capacity)
+    , m_target_utilization(target_utilization)
+    , m_max_instances(max_instances)
+    , m_window(window)
+    , m_default_instance_load(default_instance_load)
+{}
+
+AdmissionResult AdmissionController::try_admit() const {
+    if (m_instances.size() >= m_max_instances)
+    {
+        return AdmissionResult::InstanceLimit;
+    }
+
+    if (get_projected_utilization() > get_budget())
+    {
+        return AdmissionResult::CpuBudget;
+    }
+
+    return AdmissionResult::Accepted;
+}
+
+void AdmissionController::add_instance(uint64_t instance_id, TimePoint now) {
+    m_instances[instance_id] = { now, Duration::zero(), 0.0, false };
+}
+
+void AdmissionController::remove_instance(uint64_t instance_id) {
+    m_instances.erase(instance_id);
+}
+
+void AdmissionController::record_busy(uint64_t instance_id, Duration busy, TimePoint now) {
+    auto it = m_instances.find(instance_id);
+
+    if (it == m_instances.end())
+    {
+        return;
+    }
+
+    auto& load = it->second;
+    load.busy += busy;
+
+    // Close the window
+    const auto elapsed = now - load.window_start;
+
+    if (elapsed >= m_window)
+    {
+        load.utilization = std::chrono::duration<double>(load.busy).count()
+                         / std::chrono::duration<double>(elapsed).count();
+        load.busy = Duration::zero();
+        load.window_start = now;
+        load.measured = true;
+    }
+}
+
+double AdmissionController::get_utilization() const {
+    double total = 0.0;
+    const auto estimate = get_instance_estimate();
+
+    for (const auto& [instance_id, load] : m_instances)
+    {
+        total += load.measured ? load.utilization : estimate;
+    }
+
+    return total;
+}
+
+double AdmissionController::get_projected_utilization() const {
+    return get_utilization() + get_instance_estimate();
+}
+
+// Mean load of the measured instances, never below the default
+double AdmissionController::get_instance_estimate() const {
+    double total = 0.0;
+    size_t measured = 0;
+
+    for (const auto& [instance_id, load] : m_instances)
+    {
+        if (load.measured)
+        {
+            total += load.utilization;
+            measured++;
+        }
+    }
+
+    if (measured == 0)
+    {
+        return m_default_instance_load;
+    }
+
+    return std::max(total / measured, m_default_instance_load);
+}
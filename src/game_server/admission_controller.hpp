@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <unordered_map>
+
+enum class AdmissionResult : uint8_t {
+    Accepted,
+    InstanceLimit,      // Hard cap on the number of instances reached
+    CpuBudget,          // One more instance would push the projected utilization over the target
+};
+
+const char* admission_result_str(AdmissionResult result);
+
+/*
+    Decides whether a new game instance can be started, based on measured headroom.
+
+    Every instance reports the time its ticks keep a thread busy. Over a rolling
+    window this gives the number of cores each instance uses. A new instance is
+    admitted only while the projected total, including the newcomer, stays
+    under `target_utilization` of the available cores.
+
+    The clock is passed in by the caller, the class is not thread safe.
+*/
+class AdmissionController {
+public:
+    using Clock     = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    using Duration  = Clock::duration;
+
+    AdmissionController(
+        double      cpu_capacity,           // Number of cores
+        double      target_utilization,     // Fraction of cpu_capacity
+        size_t      max_instances,
+        Duration    window,
+        double      default_instance_load   // Cores assumed for an instance not measured yet
+    );
+
+    AdmissionResult try_admit() const;
+
+    void add_instance(uint64_t instance_id, TimePoint now);
+    void remove_instance(uint64_t instance_id);
+    void record_busy(uint64_t instance_id, Duration busy, TimePoint now);
+
+    // In cores
+    double get_utilization() const;
+    double get_projected_utilization() const;
+    double get_instance_estimate() const;
+
+    void set_cpu_capacity(double cpu_capacity) { m_cpu_capacity = cpu_capacity; }
+
+    size_t get_instance_count() const { return m_instances.size(); }
+    double get_budget() const { return m_cpu_capacity * m_target_utilization; }
+
+private:
+    struct InstanceLoad {
+        TimePoint   window_start;
+        Duration    busy;
+        double      utilization;    // Of the last complete window
+        bool        measured;
+    };
+
+    double      m_cpu_capacity;
+    double      m_target_utilization;
+    size_t      m_max_instances;
+    Duration    m_window;
+    double      m_default_instance_load;
+
+    std::unordered_map<uint64_t, InstanceLoad> m_instances;
+};
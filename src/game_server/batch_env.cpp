@@ -0,0 +1,179 @@
+#include "batch_env.hpp"
+
+#include <algorithm>    // std::min, std::nth_element, std::sort
+#include "diag_logger.hpp"
+
+template <typename Fn>
+void BatchEnv::for_each_chunk(Fn&& fn) {
+    const auto instance_count = m_sessions.size();
+
+    m_worker_pool.parallel_for(m_chunks.size(), [&](size_t chunk_index) {
+        const auto first = chunk_index * batch_env_constants::INSTANCES_PER_CHUNK;
+        const auto last = std::min(first + batch_env_constants::INSTANCES_PER_CHUNK, instance_count);
+
+        for (size_t instance = first; instance < last; instance++)
+        {
+            fn(instance, m_chunks[chunk_index]);
+        }
+    });
+}
+
+BatchEnv::BatchEnv(
+    size_t instance_count,
+    WorkerPool& worker_pool,
+    std::shared_ptr<const StageTimeline> timeline,
+    size_t max_enemies,
+    size_t max_bullets
+)
+    : m_worker_pool(worker_pool)
+    , m_timeline(timeline ? std::move(timeline) : default_stage_timeline())
+    , m_max_enemies(max_enemies)
+    , m_max_bullets(max_bullets)
+    , m_sessions(instance_count)
+    , m_chunks((instance_count + batch_env_constants::INSTANCES_PER_CHUNK - 1) / batch_env_constants::INSTANCES_PER_CHUNK)
+    , m_infos(instance_count)
+    , m_players(instance_count)
+    , m_enemies(instance_count * max_enemies)
+    , m_bullets(instance_count * max_bullets)
+{
+    // Seeded by the index until the first reset
+    for_each_chunk([&](size_t instance, Chunk& chunk) {
+        m_sessions[instance] = std::make_unique<GameSession>(static_cast<uint32_t>(instance), m_timeline);
+        observe(instance, chunk);
+    });
+}
+
+void BatchEnv::reset(size_t instance, uint32_t seed) {
+    m_sessions[instance] = std::make_unique<GameSession>(seed, m_timeline);
+    observe(instance, m_chunks[instance / batch_env_constants::INSTANCES_PER_CHUNK]);
+}
+
+void BatchEnv::reset_all(const uint32_t* seeds) {
+    for_each_chunk([&](size_t instance, Chunk& chunk) {
+        m_sessions[instance] = std::make_unique<GameSession>(seeds[instance], m_timeline);
+        observe(instance, chunk);
+    });
+}
+
+void BatchEnv::step(const uint8_t* actions) {
+    for_each_chunk([&](size_t instance, Chunk& chunk) {
+        step_instance(instance, actions[instance], chunk);
+    });
+}
+
+void BatchEnv::set_collision_mode(CollisionMode mode) {
+    for (auto& chunk : m_chunks)
+    {
+        chunk.bullet_updater.set_collision_mode(mode);
+    }
+}
+
+void BatchEnv::step_instance(size_t instance, uint8_t action, Chunk& chunk) {
+    if (m_infos[instance].done)
+    {
+        return;
+    }
+
+    auto& session = *m_sessions[instance];
+
+    // Held arrows as a press of everything held and a release of the rest
+    ClientInput input = {};
+    input.game_input.arrows.pressed = action;
+    input.game_input.arrows.released = static_cast<uint8_t>(~action);
+
+    try
+    {
+        session.apply_input(input);
+        session.step(chunk.bullet_updater);
+    }
+    catch (const SessionMemoryExceeded& e)
+    {
+        DIAG_ERROR("BatchEnv", "Instance " << instance << ": " << e.what());
+
+        observe(instance, chunk);
+        m_infos[instance].done = 1;
+
+        return;
+    }
+
+    observe(instance, chunk);
+}
+
+void BatchEnv::observe(size_t instance, Chunk& chunk) {
+    const auto& frame = m_sessions[instance]->get_frame();
+    const auto& player = frame.player_vector[0];
+
+    auto& info = m_infos[instance];
+    info.tick = frame.timestamp;
+    info.done = (static_cast<uint32_t>(frame.state) & static_cast<uint32_t>(GameState::GameOver)) != 0;
+
+    m_players[instance] = { player.pos.x, player.pos.y, player.radius, player.lives };
+
+    // Enemies
+    const auto enemy_count = std::min(frame.enemy_vector.size(), m_max_enemies);
+    auto* enemies = m_enemies.data() + instance * m_max_enemies;
+
+    for (size_t i = 0; i < enemy_count; i++)
+    {
+        const auto& enemy = frame.enemy_vector[i];
+        enemies[i] = { enemy.pos.x, enemy.pos.y, enemy.vel.x, enemy.vel.y, enemy.radius };
+    }
+
+    info.enemy_count = static_cast<uint32_t>(enemy_count);
+
+    // Bullets, the closest ones if they do not all fit
+    const auto& bullets = frame.bullet_vector;
+    auto* rows = m_bullets.data() + instance * m_max_bullets;
+
+    auto write_row = [&](size_t row, const BulletSnapshot& bullet) {
+        rows[row] = { bullet.pos.x, bullet.pos.y, bullet.vel.x, bullet.vel.y, bullet.radius, static_cast<uint32_t>(bullet.name) };
+    };
+
+    if (bullets.size() <= m_max_bullets)
+    {
+        for (size_t i = 0; i < bullets.size(); i++)
+        {
+            write_row(i, bullets[i]);
+        }
+
+        info.bullet_count = static_cast<uint32_t>(bullets.size());
+    }
+    else
+    {
+        auto distance = [&](uint32_t index) {
+            const auto dx = bullets[index].pos.x - player.pos.x;
+            const auto dy = bullets[index].pos.y - player.pos.y;
+
+            return dx * dx + dy * dy;
+        };
+
+        auto& order = chunk.bullet_order;
+        order.resize(bullets.size());
+
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            order[i] = static_cast<uint32_t>(i);
+        }
+
+        std::nth_element(
+            order.begin(),
+            order.begin() + m_max_bullets,
+            order.end(),
+            [&](uint32_t a, uint32_t b) {
+                return distance(a) < distance(b);
+            }
+        );
+
+        // Kept in bullet order
+        std::sort(order.begin(), order.begin() + m_max_bullets);
+
+        for (size_t i = 0; i < m_max_bullets; i++)
+        {
+            write_row(i, bullets[order[i]]);
+        }
+
+        info.bullet_count = static_cast<uint32_t>(m_max_bullets);
+    }
+
+    info.bullets_total = static_cast<uint32_t>(bullets.size());
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "game_session.hpp"
+#include "bullet_updater.hpp"
+#include "stage_timeline.hpp"
+#include "worker_pool.hpp"
+#include "game_server_constants.hpp"
+
+// Observation rows, one layout for every instance
+struct EnvInfo {
+    uint64_t    tick;
+    uint32_t    done;           // Hit, or out of memory. Not stepped until reset
+    uint32_t    enemy_count;    // Valid rows of its enemy block
+    uint32_t    bullet_count;   // Valid rows of its bullet block
+    uint32_t    bullets_total;  // Bullets in the game, more than bullet_count if they did not fit
+};
+
+struct EnvPlayer {
+    float       x;
+    float       y;
+    float       radius;
+    uint32_t    lives;
+};
+
+struct EnvEnemy {
+    float       x;
+    float       y;
+    float       vx;
+    float       vy;
+    float       radius;
+};
+
+struct EnvBullet {
+    float       x;
+    float       y;
+    float       vx;
+    float       vy;
+    float       radius;
+    uint32_t    name;           // BulletName
+};
+
+/*
+    Many game instances in one process, stepped in lockstep for bot training.
+
+    There is no connection, no pacing and no serialization: step() takes the
+    held arrows of every instance from one contiguous buffer, advances all of
+    them by a tick on the worker pool and writes the observations to
+    contiguous buffers. Instance i owns row i of the info and player buffers
+    and the block of rows starting at i * max_enemies (max_bullets) of the
+    enemy (bullet) buffer. When an instance has more bullets than rows, the
+    ones closest to the player are kept.
+
+    An instance is a GameSession, so the same seed and actions give the same
+    game as on the server, regardless of the number of threads.
+*/
+class BatchEnv {
+public:
+    BatchEnv(
+        size_t instance_count,
+        WorkerPool& worker_pool,
+        std::shared_ptr<const StageTimeline> timeline = nullptr,
+        size_t max_enemies = batch_env_constants::MAX_OBSERVED_ENEMIES,
+        size_t max_bullets = batch_env_constants::MAX_OBSERVED_BULLETS
+    );
+
+    BatchEnv(const BatchEnv&) = delete;
+    BatchEnv& operator=(const BatchEnv&) = delete;
+
+    // Starts a new game, the observation is written right away
+    void reset(size_t instance, uint32_t seed);
+    void reset_all(const uint32_t* seeds);              // One seed per instance
+
+    // One byte of held arrows per instance, instances that are done are skipped
+    void step(const uint8_t* actions);
+
+    // Of every instance, discrete by default
+    void set_collision_mode(CollisionMode mode);
+
+    size_t get_instance_count() const { return m_sessions.size(); }
+    size_t get_max_enemies() const { return m_max_enemies; }
+    size_t get_max_bullets() const { return m_max_bullets; }
+
+    const EnvInfo* get_infos() const { return m_infos.data(); }
+    const EnvPlayer* get_players() const { return m_players.data(); }
+    const EnvEnemy* get_enemies() const { return m_enemies.data(); }
+    const EnvBullet* get_bullets() const { return m_bullets.data(); }
+
+    const GameSession& get_session(size_t instance) const { return *m_sessions[instance]; }
+
+private:
+    // Scratch of one task, a chunk is only ever run by one thread at a time
+    struct Chunk {
+        BulletUpdater           bullet_updater;
+        std::vector<uint32_t>   bullet_order;
+    };
+
+    void step_instance(size_t instance, uint8_t action, Chunk& chunk);
+    void observe(size_t instance, Chunk& chunk);
+
+    template <typename Fn>
+    void for_each_chunk(Fn&& fn);
+
+    WorkerPool&                             m_worker_pool;
+    std::shared_ptr<const StageTimeline>    m_timeline;
+    size_t                                  m_max_enemies;
+    size_t                                  m_max_bullets;
+
+    std::vector<std::unique_ptr<GameSession>>   m_sessions;
+    std::vector<Chunk>                          m_chunks;
+
+    // Observations
+    std::vector<EnvInfo>    m_infos;
+    std::vector<EnvPlayer>  m_players;
+    std::vector<EnvEnemy>   m_enemies;
+    std::vector<EnvBullet>  m_bullets;
+};
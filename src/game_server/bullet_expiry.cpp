@@ -0,0 +1,222 @@
+#include "bullet_expiry.hpp"
+
+#include <cmath>        // std::floor, std::abs
+#include <limits>
+#include <algorithm>    // std::min, std::clamp, std::sort
+#include <utility>      // std::swap
+#include "game_server_constants.hpp"
+#include "game_server_utils.hpp"
+
+namespace {
+    constexpr uint64_t NEVER_DUE = std::numeric_limits<uint64_t>::max();
+    constexpr uint32_t NO_SLOT   = std::numeric_limits<uint32_t>::max();
+
+    // outside() truncates to int, a bullet is out from one unit past the edge
+    constexpr double EXIT_X = game_constants::GAME_WIDTH_HALF + 1.0;
+    constexpr double EXIT_Y = game_constants::GAME_HEIGHT_HALF + 1.0;
+
+    // Moves until the axis crosses its exit, made early by the worst rounding the moves can add up
+    double axis_exit_ticks(double pos, double vel, double exit) {
+        if (vel == 0.0)
+        {
+            return std::numeric_limits<double>::infinity();
+        }
+
+        const auto ticks = ((vel > 0.0 ? exit : -exit) - pos) / vel;
+        const auto slack = ticks * bullet_constants::EXPIRY_POSITION_ERROR / std::abs(vel);
+
+        return ticks - slack - 1e-9;
+    }
+}
+
+uint64_t estimate_exit_ticks(const BulletSnapshot& bullet) {
+    // Out after the next move, also the ones fired outside that are still on their way in
+    if (outside(bullet.pos.x + bullet.vel.x, bullet.pos.y + bullet.vel.y))
+    {
+        return 1;
+    }
+
+    if (bullet.vel.x == 0.0f && bullet.vel.y == 0.0f)
+    {
+        return NEVER_DUE;
+    }
+
+    const auto ticks = std::min(
+        axis_exit_ticks(bullet.pos.x, bullet.vel.x, EXIT_X),
+        axis_exit_ticks(bullet.pos.y, bullet.vel.y, EXIT_Y)
+    );
+
+    // Capped, far ones are estimated again at the end of the wheel
+    const auto wheel_max = static_cast<double>(bullet_constants::EXPIRY_WHEEL_TICKS - 1);
+
+    return static_cast<uint64_t>(std::floor(std::clamp(ticks, 1.0, wheel_max)));
+}
+
+BulletExpiry::BulletExpiry(std::pmr::memory_resource* resource)
+    : m_tick(0)
+    , m_last_checked_count(0)
+    , m_slots(resource)
+    , m_dead(resource)
+{
+    m_heads.fill(NO_SLOT);
+    m_slots.reserve(bullet_constants::EXPIRY_RESERVED_SLOTS);
+}
+
+void BulletExpiry::file_new(const FrameSnapshot& frame) {
+    const auto& bullets = frame.bullet_vector;
+
+    for (size_t i = m_slots.size(); i < bullets.size(); i++)
+    {
+        m_slots.push_back({ NEVER_DUE, NO_SLOT, NO_SLOT });
+        file(static_cast<uint32_t>(i), bullets[i]);
+    }
+}
+
+void BulletExpiry::refile(const FrameSnapshot& frame, size_t index) {
+    // Not filed yet otherwise, file_new() will
+    if (index < m_slots.size())
+    {
+        file(static_cast<uint32_t>(index), frame.bullet_vector[index]);
+    }
+}
+
+void BulletExpiry::file(uint32_t index, const BulletSnapshot& bullet) {
+    unlink(index);
+
+    const auto ticks = estimate_exit_ticks(bullet);
+
+    if (ticks != NEVER_DUE)
+    {
+        link(index, m_tick + ticks);
+    }
+}
+
+void BulletExpiry::link(uint32_t index, uint64_t due) {
+    auto& head = m_heads[due % bullet_constants::EXPIRY_WHEEL_TICKS];
+    auto& slot = m_slots[index];
+
+    slot = { due, NO_SLOT, head };
+
+    if (head != NO_SLOT)
+    {
+        m_slots[head].prev = index;
+    }
+
+    head = index;
+}
+
+void BulletExpiry::unlink(uint32_t index) {
+    auto& slot = m_slots[index];
+
+    if (slot.due == NEVER_DUE)
+    {
+        return;
+    }
+
+    if (slot.prev != NO_SLOT)
+    {
+        m_slots[slot.prev].next = slot.next;
+    }
+    else
+    {
+        m_heads[slot.due % bullet_constants::EXPIRY_WHEEL_TICKS] = slot.next;
+    }
+
+    if (slot.next != NO_SLOT)
+    {
+        m_slots[slot.next].prev = slot.prev;
+    }
+
+    slot = { NEVER_DUE, NO_SLOT, NO_SLOT };
+}
+
+void BulletExpiry::move_slot(uint32_t from, uint32_t to) {
+    const auto slot = m_slots[from];
+    m_slots[to] = slot;
+
+    if (slot.due == NEVER_DUE)
+    {
+        return;
+    }
+
+    // Its neighbours point to the new index
+    if (slot.prev != NO_SLOT)
+    {
+        m_slots[slot.prev].next = to;
+    }
+    else
+    {
+        m_heads[slot.due % bullet_constants::EXPIRY_WHEEL_TICKS] = to;
+    }
+
+    if (slot.next != NO_SLOT)
+    {
+        m_slots[slot.next].prev = to;
+    }
+}
+
+void BulletExpiry::cull(FrameSnapshot& frame) {
+    auto& vec = frame.bullet_vector;
+
+    m_tick++;
+    m_dead.clear();
+    m_last_checked_count = 0;
+
+    // Due this tick: out, or filed again (into a later bucket)
+    auto index = m_heads[m_tick % bullet_constants::EXPIRY_WHEEL_TICKS];
+
+    while (index != NO_SLOT)
+    {
+        const auto next = m_slots[index].next;
+
+        if (outside(vec[index].pos.x, vec[index].pos.y))
+        {
+            unlink(index);
+            m_dead.push_back(index);
+        }
+        else
+        {
+            file(index, vec[index]);
+        }
+
+        m_last_checked_count++;
+        index = next;
+    }
+
+    // Same removal as the full scan: in index order, each dead bullet swapped with the last one
+    std::sort(m_dead.begin(), m_dead.end());
+
+    size_t front = 0;
+    size_t back = m_dead.size();
+
+    while (front < back)
+    {
+        const auto index = m_dead[front];
+        const auto last = static_cast<uint32_t>(vec.size() - 1);
+
+        if (index != last)
+        {
+            std::swap(vec[index], vec.back());
+            move_slot(last, index);
+        }
+
+        vec.pop_back();
+        m_slots.pop_back();
+        frame.bullet_count--;
+
+        if (back - 1 > front && m_dead[back - 1] == last)
+        {
+            // The last bullet was dead too, it is removed from its new index next
+            back--;
+        }
+        else
+        {
+            front++;
+        }
+    }
+}
+
+void BulletExpiry::clear() {
+    m_heads.fill(NO_SLOT);
+    m_slots.clear();
+}
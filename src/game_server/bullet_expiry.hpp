@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <vector>
+#include <memory_resource>
+#include <packet_template/packet_template.hpp>
+#include "game_server_constants.hpp"
+
+/*
+    Expiry wheel of the bullets of one game.
+
+    A bullet moves in a straight line, so the tick it leaves the playfield
+    is known when it is fired. It is filed in the wheel bucket of that tick,
+    and cull() only looks at the bullets of the current bucket instead of
+    testing every bullet. The estimate errs on the early side, a bullet
+    that is still inside when its bucket comes up is filed again from where
+    it is. So every bullet is removed on exactly the tick it leaves, and
+    the removal order is the one of the full scan (swap with the last
+    bullet, in index order).
+
+    The buckets are lists linked through a slot per bullet, kept parallel to
+    the bullet vector. The frame's bullets may only be appended to between
+    two culls, and a bullet whose velocity changes must be refiled.
+*/
+class BulletExpiry {
+public:
+    explicit BulletExpiry(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    // Files the bullets appended to the frame since the last cull, before they move
+    void file_new(const FrameSnapshot& frame);
+
+    // The motion of the bullet at `index` changed, files it again from where it is
+    void refile(const FrameSnapshot& frame, size_t index);
+
+    // After the bullets have moved, removes the ones that left the playfield
+    void cull(FrameSnapshot& frame);
+
+    // Forgets every bullet, the next file_new() files all of them again
+    void clear();
+
+    size_t get_tracked_count() const { return m_slots.size(); }
+    size_t get_last_checked_count() const { return m_last_checked_count; }
+
+private:
+    struct Slot {
+        uint64_t    due;        // Tick of its bucket, NEVER_DUE if in none
+        uint32_t    prev;       // NO_SLOT at the head of the bucket
+        uint32_t    next;
+    };
+
+    void file(uint32_t index, const BulletSnapshot& bullet);
+    void link(uint32_t index, uint64_t due);
+    void unlink(uint32_t index);
+    void move_slot(uint32_t from, uint32_t to);
+
+    uint64_t    m_tick;                 // Culls done
+    size_t      m_last_checked_count;
+
+    std::array<uint32_t, bullet_constants::EXPIRY_WHEEL_TICKS>  m_heads;
+    std::pmr::vector<Slot>                                      m_slots;    // Parallel to the bullets
+
+    // Scratch reused across ticks
+    std::pmr::vector<uint32_t>  m_dead;
+};
+
+// Moves a bullet needs to leave the playfield, at least 1 and never more than it really needs
+uint64_t estimate_exit_ticks(const BulletSnapshot& bullet);
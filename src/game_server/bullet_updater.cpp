@@ -0,0 +1,197 @@
+#include "bullet_updater.hpp"
+
+#include <algorithm>    // std::min
+#include <utility>      // std::swap
+#include "game_server_constants.hpp"
+#include "game_server_utils.hpp"
+
+namespace {
+    // The bullet moved from `bullet_from` to its position
+    bool collides(CollisionMode mode, const PlayerSnapshot& player, const Vec2& player_from, const BulletSnapshot& bullet, const Vec2& bullet_from) {
+        if (detect_collision(player, bullet))
+        {
+            return true;
+        }
+
+        float contact_time = 0.0f;
+
+        return mode == CollisionMode::Swept && detect_swept_collision(player, player_from, bullet, bullet_from, contact_time);
+    }
+}
+
+BulletUpdater::BulletUpdater(WorkerPool* worker_pool, size_t parallel_threshold, std::pmr::memory_resource* resource)
+    : m_worker_pool(worker_pool)
+    , m_parallel_threshold(parallel_threshold)
+    , m_collision_mode(CollisionMode::Discrete)
+    , m_dead(resource)
+    , m_chunk_hits(resource)
+{}
+
+void BulletUpdater::update(FrameSnapshot& frame) {
+    if (is_parallel(frame.bullet_vector.size()))
+    {
+        update_parallel(frame);
+    }
+    else
+    {
+        update_bullets_serial(frame);
+    }
+}
+
+bool BulletUpdater::is_parallel(size_t bullet_count) const {
+    return m_worker_pool != nullptr && bullet_count >= m_parallel_threshold;
+}
+
+void BulletUpdater::update(FrameSnapshot& frame, BulletExpiry& expiry) {
+    const auto player_from = frame.player_vector[0].pos;
+
+    update(frame, expiry, player_from);
+}
+
+void BulletUpdater::update(FrameSnapshot& frame, BulletExpiry& expiry, const Vec2& player_from) {
+    expiry.file_new(frame);
+
+    auto& player = frame.player_vector[0];
+    bool hit = false;
+
+    if (is_parallel(frame.bullet_vector.size()))
+    {
+        hit = move_parallel(frame, player_from, m_collision_mode, false);
+    }
+    else
+    {
+        for (auto& bullet : frame.bullet_vector)
+        {
+            const auto bullet_from = bullet.pos;
+
+            bullet.pos.x += bullet.vel.x;
+            bullet.pos.y += bullet.vel.y;
+
+            hit |= collides(m_collision_mode, player, player_from, bullet, bullet_from);
+        }
+    }
+
+    if (hit)
+    {
+        player.lives = 0;
+        frame.state = frame.state | GameState::GameOver;
+    }
+
+    expiry.cull(frame);
+}
+
+bool BulletUpdater::move_parallel(FrameSnapshot& frame, const Vec2& player_from, CollisionMode mode, bool flag_dead) {
+    auto& vec = frame.bullet_vector;
+    const auto& player = frame.player_vector[0];
+
+    const auto bullet_count = vec.size();
+    const auto chunk_size = bullet_constants::PARALLEL_CHUNK_SIZE;
+    const auto chunk_count = (bullet_count + chunk_size - 1) / chunk_size;
+
+    if (flag_dead)
+    {
+        m_dead.assign(bullet_count, 0);
+    }
+
+    m_chunk_hits.assign(chunk_count, 0);
+
+    // Integrate, collide and, if asked, flag the dead bullets chunk by chunk
+    m_worker_pool->parallel_for(chunk_count, [&](size_t chunk) {
+        const auto begin = chunk * chunk_size;
+        const auto end = std::min(begin + chunk_size, bullet_count);
+
+        uint8_t hit = 0;
+
+        for (size_t i = begin; i < end; i++)
+        {
+            auto& bullet = vec[i];
+            const auto bullet_from = bullet.pos;
+
+            bullet.pos.x += bullet.vel.x;
+            bullet.pos.y += bullet.vel.y;
+
+            hit |= collides(mode, player, player_from, bullet, bullet_from);
+
+            if (flag_dead)
+            {
+                m_dead[i] = outside(bullet.pos.x, bullet.pos.y);
+            }
+        }
+
+        m_chunk_hits[chunk] = hit;
+    });
+
+    // Merge the hits
+    for (const auto hit : m_chunk_hits)
+    {
+        if (hit)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BulletUpdater::update_parallel(FrameSnapshot& frame) {
+    auto& vec = frame.bullet_vector;
+
+    if (move_parallel(frame, frame.player_vector[0].pos, CollisionMode::Discrete, true))
+    {
+        frame.player_vector[0].lives = 0;
+        frame.state = frame.state | GameState::GameOver;
+    }
+
+    // Replay the removal of the serial pass with the precomputed flags
+    for (size_t i = 0; i < vec.size(); )
+    {
+        if (m_dead[i])
+        {
+            std::swap(vec[i], vec.back());
+            vec.pop_back();
+            m_dead[i] = m_dead.back();
+            m_dead.pop_back();
+            frame.bullet_count--;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void update_bullets_serial(FrameSnapshot& frame) {
+    // Update and detect collision of bullets
+    for (auto& bullet : frame.bullet_vector)
+    {
+        bullet.pos.x += bullet.vel.x;
+        bullet.pos.y += bullet.vel.y;
+
+        const auto collided = detect_collision(
+            frame.player_vector[0],
+            bullet
+        );
+
+        if (collided)
+        {
+            frame.player_vector[0].lives = 0;
+            frame.state = frame.state | GameState::GameOver;
+        }
+    }
+
+    // Remove the dead bullets
+    auto& vec = frame.bullet_vector;
+    for (size_t i = 0; i < vec.size(); )
+    {
+        if (outside(vec[i].pos.x, vec[i].pos.y))
+        {
+            std::swap(vec[i], vec.back());
+            vec.pop_back();
+            frame.bullet_count--;
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
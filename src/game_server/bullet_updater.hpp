@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <memory_resource>
+#include <packet_template/packet_template.hpp>
+#include "worker_pool.hpp"
+#include "bullet_expiry.hpp"
+
+/*
+    Integrate, collide and cull pass over the bullets of one frame.
+
+    Above `parallel_threshold` bullets the pass is split into chunks that run
+    on the shared worker pool. Hits and removals are merged afterwards in
+    bullet order, so the frame comes out exactly as the serial pass leaves it.
+
+    With the expiry wheel of the game, the cull only looks at the bullets due
+    to leave this tick instead of testing all of them, with the same result.
+    That pass also collides in the configured mode: Discrete tests overlap at
+    the end of the tick only, Swept tests the whole way the player and every
+    bullet moved over the tick, so a fast bullet can not pass through the
+    player between two ticks.
+*/
+enum class CollisionMode {
+    Discrete,
+    Swept
+};
+
+class BulletUpdater {
+public:
+    BulletUpdater(
+        WorkerPool* worker_pool = nullptr,
+        size_t parallel_threshold = SIZE_MAX,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    );
+
+    // Full scan with discrete collision, the reference for the pass below
+    void update(FrameSnapshot& frame);
+
+    // The player moved from `player_from` to its position this tick
+    void update(FrameSnapshot& frame, BulletExpiry& expiry, const Vec2& player_from);
+    void update(FrameSnapshot& frame, BulletExpiry& expiry);                          // Player did not move
+
+    bool is_parallel(size_t bullet_count) const;
+
+    void set_collision_mode(CollisionMode mode) { m_collision_mode = mode; }
+    CollisionMode get_collision_mode() const { return m_collision_mode; }
+
+private:
+    void update_parallel(FrameSnapshot& frame);
+
+    // Integrates and collides on the worker pool, flags the dead bullets in m_dead if asked to
+    bool move_parallel(FrameSnapshot& frame, const Vec2& player_from, CollisionMode mode, bool flag_dead);
+
+    WorkerPool*             m_worker_pool;
+    size_t                  m_parallel_threshold;
+    CollisionMode           m_collision_mode;
+
+    // Scratch reused across ticks
+    std::pmr::vector<uint8_t>   m_dead;
+    std::pmr::vector<uint8_t>   m_chunk_hits;
+};
+
+// Reference pass, single threaded
+void update_bullets_serial(FrameSnapshot& frame);
@@ -0,0 +1,305 @@
+#include "crash_checkpoint.hpp"
+
+#include <algorithm>    // std::max, std::find
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "state_codec.hpp"
+#include "diag_logger.hpp"
+
+namespace {
+    int64_t usec_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool write_all(int fd, const uint8_t* data, size_t size) {
+        while (size > 0)
+        {
+            const auto written = write(fd, data, size);
+
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (written <= 0)
+            {
+                return false;
+            }
+
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+
+        return true;
+    }
+
+    // Runs in the snapshot process, only this thread exists there and nothing changes the sessions
+    bool write_checkpoint_file(const std::string& path, const std::vector<std::shared_ptr<CrashCheckpointer::Slot>>& slots, uint64_t unix_msec) {
+        StateWriter writer;
+
+        writer.write(checkpoint_constants::FILE_MAGIC);
+        writer.write(checkpoint_constants::FILE_VERSION);
+        writer.write(unix_msec);
+        writer.write(static_cast<uint32_t>(slots.size()));
+
+        for (const auto& slot : slots)
+        {
+            writer.write(slot->instance_id);
+
+            // Size prefixed like a vector of bytes, filled in once the session is written
+            auto& buffer = writer.get_buffer();
+            const auto size_offset = buffer.size();
+
+            writer.write(static_cast<uint32_t>(0));
+            slot->session->serialize(writer);
+
+            const auto size = static_cast<uint32_t>(buffer.size() - size_offset - sizeof(uint32_t));
+            std::memcpy(buffer.data() + size_offset, &size, sizeof(size));
+        }
+
+        // The previous checkpoint stays in place until this one is complete
+        const auto temp_path = path + ".tmp";
+        const int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        const auto& buffer = writer.get_buffer();
+        const auto written = write_all(fd, buffer.data(), buffer.size()) && fsync(fd) == 0;
+
+        close(fd);
+
+        return written && rename(temp_path.c_str(), path.c_str()) == 0;
+    }
+}
+
+CrashCheckpointer::CrashCheckpointer(std::string path, int64_t interval_msec)
+    : m_path(std::move(path))
+    , m_interval_msec(interval_msec)
+    , m_stats()
+    , m_stopping(false)
+{}
+
+CrashCheckpointer::~CrashCheckpointer() {
+    stop();
+}
+
+void CrashCheckpointer::start() {
+    std::lock_guard<std::mutex> lock(m_thread_mutex);
+
+    if (!m_thread.joinable())
+    {
+        m_stopping = false;
+        m_thread = std::thread(&CrashCheckpointer::checkpoint_loop, this);
+    }
+}
+
+void CrashCheckpointer::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_thread_mutex);
+        m_stopping = true;
+    }
+
+    m_cv.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+std::shared_ptr<CrashCheckpointer::Slot> CrashCheckpointer::add_session(uint64_t instance_id, const GameSession& session) {
+    auto slot = std::make_shared<Slot>();
+    slot->instance_id = instance_id;
+    slot->session = &session;
+
+    std::lock_guard<std::mutex> lock(m_slots_mutex);
+    m_slots.push_back(slot);
+
+    return slot;
+}
+
+void CrashCheckpointer::remove_session(const std::shared_ptr<Slot>& slot) {
+    std::lock_guard<std::mutex> lock(m_slots_mutex);
+
+    const auto it = std::find(m_slots.begin(), m_slots.end(), slot);
+
+    if (it != m_slots.end())
+    {
+        m_slots.erase(it);
+    }
+}
+
+bool CrashCheckpointer::checkpoint() {
+    std::lock_guard<std::mutex> checkpoint_lock(m_checkpoint_mutex);
+
+    const auto unix_msec = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count());
+
+    pid_t pid = -1;
+    size_t session_count = 0;
+    int64_t fork_usec = 0;
+    int64_t pause_usec = 0;
+
+    // Every session between two ticks for the fork, then the instances go on
+    {
+        const auto pause_start = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> slots_lock(m_slots_mutex);
+
+        for (const auto& slot : m_slots)
+        {
+            slot->mutex.lock();
+        }
+
+        session_count = m_slots.size();
+
+        const auto fork_start = std::chrono::steady_clock::now();
+
+        pid = fork();
+
+        if (pid == 0)
+        {
+            // Snapshot process
+            _exit(write_checkpoint_file(m_path, m_slots, unix_msec) ? 0 : 1);
+        }
+
+        fork_usec = usec_since(fork_start);
+
+        for (const auto& slot : m_slots)
+        {
+            slot->mutex.unlock();
+        }
+
+        pause_usec = usec_since(pause_start);
+    }
+
+    const auto write_start = std::chrono::steady_clock::now();
+    auto written = false;
+
+    if (pid > 0)
+    {
+        int status = 0;
+        pid_t waited = -1;
+
+        do
+        {
+            waited = waitpid(pid, &status, 0);
+        } while (waited < 0 && errno == EINTR);
+
+        written = waited == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+
+    const auto write_usec = usec_since(write_start);
+
+    struct stat file_stat = {};
+    const auto bytes = written && stat(m_path.c_str(), &file_stat) == 0 ? static_cast<uint64_t>(file_stat.st_size) : 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+        if (written)
+        {
+            m_stats.checkpoints++;
+            m_stats.last_sessions = static_cast<uint32_t>(session_count);
+            m_stats.last_bytes = bytes;
+            m_stats.last_pause_usec = pause_usec;
+            m_stats.max_pause_usec = std::max(m_stats.max_pause_usec, pause_usec);
+            m_stats.last_fork_usec = fork_usec;
+            m_stats.last_write_usec = write_usec;
+        }
+        else
+        {
+            m_stats.failures++;
+        }
+    }
+
+    if (written)
+    {
+        DIAG_DEBUG("CrashCheckpointer", session_count << " sessions checkpointed, " << bytes << " bytes, "
+                                        << "paused " << pause_usec << " usec (fork " << fork_usec << " usec), "
+                                        << "written in " << write_usec << " usec");
+    }
+    else
+    {
+        DIAG_ERROR("CrashCheckpointer", "Failed to write the checkpoint to " << m_path);
+    }
+
+    return written;
+}
+
+CheckpointStats CrashCheckpointer::get_stats() {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+    return m_stats;
+}
+
+void CrashCheckpointer::checkpoint_loop() {
+    std::unique_lock<std::mutex> lock(m_thread_mutex);
+
+    while (!m_stopping)
+    {
+        m_cv.wait_for(lock, std::chrono::milliseconds(m_interval_msec), [this]() { return m_stopping; });
+
+        if (m_stopping)
+        {
+            break;
+        }
+
+        lock.unlock();
+        checkpoint();
+        lock.lock();
+    }
+}
+
+bool read_checkpoint(const std::string& path, std::vector<CheckpointEntry>& entries, uint64_t& written_unix_msec) {
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    StateReader reader(data);
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    uint32_t count = 0;
+
+    reader.read(magic);
+    reader.read(version);
+    reader.read(written_unix_msec);
+    reader.read(count);
+
+    if (reader.failed() || magic != checkpoint_constants::FILE_MAGIC || version != checkpoint_constants::FILE_VERSION)
+    {
+        return false;
+    }
+
+    entries.clear();
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        CheckpointEntry entry;
+
+        if (!reader.read(entry.instance_id) || !reader.read_vector(entry.state))
+        {
+            return false;
+        }
+
+        entries.push_back(std::move(entry));
+    }
+
+    return true;
+}
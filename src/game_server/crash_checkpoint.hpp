@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "game_session.hpp"
+#include "game_server_constants.hpp"
+
+// Cost of the checkpoints, the last one and the worst so far
+struct CheckpointStats {
+    uint64_t    checkpoints;        // Written
+    uint64_t    failures;
+    uint32_t    last_sessions;
+    uint64_t    last_bytes;
+    int64_t     last_pause_usec;    // Sessions held between two ticks, the fork included
+    int64_t     max_pause_usec;
+    int64_t     last_fork_usec;
+    int64_t     last_write_usec;    // Snapshot process, from the fork until the file is in place
+};
+
+// One session of a checkpoint file
+struct CheckpointEntry {
+    uint64_t                instance_id;
+    std::vector<uint8_t>    state;          // As GameSession::serialize() wrote it
+};
+
+/*
+    Periodic crash-recovery checkpoints of the live sessions of this process.
+
+    Every instance thread holds the mutex of its slot only while it changes
+    its session, for a step or a queued input, never while it sends, waits
+    or hands the session over. A checkpoint takes the mutexes of all slots,
+    so every session is between two ticks, forks and lets go of them right
+    away. The forked snapshot process sees the memory of that moment (copy
+    on write), serializes every session from it and replaces the checkpoint
+    file with an atomic rename. The instances only wait for the fork itself;
+    afterwards they pay for the pages they write first, see CheckpointStats
+    and bench/crash_checkpoint_bench.cpp.
+
+    The file keeps the sessions as the session handoff sends them, so a
+    checkpoint can only be restored by a build with the same state layout
+    and the same stage. The next run restores them and a client resumes its
+    game with the ResumeToken in the session state (see
+    GameServerMaster::enable_crash_checkpoints()).
+*/
+class CrashCheckpointer {
+public:
+    // A registered session
+    struct Slot {
+        std::mutex          mutex;          // Held by the instance thread while it changes the session
+        uint64_t            instance_id;
+        const GameSession*  session;
+    };
+
+    explicit CrashCheckpointer(std::string path, int64_t interval_msec = checkpoint_constants::INTERVAL_MSEC);
+    ~CrashCheckpointer();
+
+    CrashCheckpointer(const CrashCheckpointer&) = delete;
+    CrashCheckpointer& operator=(const CrashCheckpointer&) = delete;
+
+    // Checkpoints every interval on a thread of its own until stop()
+    void start();
+    void stop();
+
+    // By the instance thread, before its first and after its last tick
+    std::shared_ptr<Slot> add_session(uint64_t instance_id, const GameSession& session);
+    void remove_session(const std::shared_ptr<Slot>& slot);
+
+    // Takes a checkpoint right away, false if the file could not be written
+    bool checkpoint();
+
+    CheckpointStats get_stats();
+    const std::string& get_path() const { return m_path; }
+
+private:
+    void checkpoint_loop();
+
+    std::string     m_path;
+    int64_t         m_interval_msec;
+
+    std::mutex                          m_slots_mutex;
+    std::vector<std::shared_ptr<Slot>>  m_slots;
+
+    // One checkpoint at a time
+    std::mutex      m_checkpoint_mutex;
+
+    std::mutex      m_stats_mutex;
+    CheckpointStats m_stats;
+
+    std::mutex                  m_thread_mutex;
+    std::condition_variable     m_cv;
+    std::thread                 m_thread;
+    bool                        m_stopping;
+};
+
+// The sessions of the checkpoint at `path`, false if there is none or it is damaged
+bool read_checkpoint(const std::string& path, std::vector<CheckpointEntry>& entries, uint64_t& written_unix_msec);
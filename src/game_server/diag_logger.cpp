@@ -0,0 +1,361 @@
+#include "diag_logger.hpp"
+
+#include <pthread.h>
+#include <algorithm>    // std::remove_if
+#include <chrono>
+#include <cstdlib>      // std::atexit
+#include <iostream>
+#include <limits>
+#include <new>
+#include <thread>
+#include "game_server_constants.hpp"
+
+namespace {
+    thread_local std::ostringstream t_line;
+
+    int64_t now_msec() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+}
+
+const char* log_level_str(LogLevel level) {
+    switch (level)
+    {
+        case LogLevel::Debug:   return "DEBUG";
+        case LogLevel::Info:    return "INFO";
+        case LogLevel::Error:   return "ERROR";
+    }
+
+    return "UNKNOWN";
+}
+
+/***** DiagSite ****/
+
+DiagSite::DiagSite(const char* tag, LogLevel level)
+    : m_tag(tag)
+    , m_level(level)
+    , m_window_start(std::numeric_limits<int64_t>::min() / 2)
+    , m_window_count(0)
+    , m_suppressed(0)
+{
+    DiagLogger::instance().register_site(this);
+}
+
+bool DiagSite::admit() {
+    const auto now = now_msec();
+    auto window_start = m_window_start.load(std::memory_order_relaxed);
+
+    // The first thread to see the window over starts the next one
+    if (now - window_start >= diag_log_constants::RATE_WINDOW_MSEC
+        && m_window_start.compare_exchange_strong(window_start, now, std::memory_order_relaxed))
+    {
+        m_window_count.store(0, std::memory_order_relaxed);
+    }
+
+    if (m_window_count.fetch_add(1, std::memory_order_relaxed) < diag_log_constants::RATE_LIMIT_PER_WINDOW)
+    {
+        return true;
+    }
+
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+
+    return false;
+}
+
+/***** DiagLogger ****/
+
+thread_local DiagLogger::ThreadBufferHolder DiagLogger::t_buffer;
+
+DiagLogger::ThreadBufferHolder::~ThreadBufferHolder() {
+    if (buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffer->mutex);
+
+        buffer->exited = true;
+    }
+}
+
+DiagLogger& DiagLogger::instance() {
+    static DiagLogger* logger = new DiagLogger();
+
+    return *logger;
+}
+
+DiagLogger::DiagLogger()
+    : m_out(&std::cout)
+    , m_err(&std::cerr)
+    , m_last_summary_msec(now_msec())
+    , m_next_batch(0)
+    , m_written_batch(0)
+    , m_started(false)
+    , m_dropped_total(0)
+{
+    pthread_atfork(&DiagLogger::prepare_fork, &DiagLogger::parent_after_fork, &DiagLogger::child_after_fork);
+
+    // What is still queued at a normal exit
+    std::atexit([]() { DiagLogger::instance().flush(); });
+}
+
+std::ostringstream& DiagLogger::begin_line() {
+    t_line.str(std::string());
+    t_line.clear();
+
+    return t_line;
+}
+
+void DiagLogger::end_line(const DiagSite& site) {
+    const auto message = t_line.str();
+
+    auto& buffer = get_thread_buffer();
+
+    {
+        std::lock_guard<std::mutex> lock(buffer.mutex);
+
+        const auto size = buffer.out.size() + buffer.err.size()
+                        + std::char_traits<char>::length(site.get_tag()) + message.size() + 16;
+
+        if (size > diag_log_constants::THREAD_BUFFER_BYTES)
+        {
+            buffer.dropped++;
+            m_dropped_total++;
+        }
+        else
+        {
+            auto& text = site.get_level() == LogLevel::Error ? buffer.err : buffer.out;
+
+            text += "[";
+            text += site.get_tag();
+            text += "] ";
+            text += log_level_str(site.get_level());
+            text += ": ";
+            text += message;
+            text += "\n";
+        }
+    }
+
+    ensure_started();
+}
+
+void DiagLogger::flush() {
+    drain(true);
+}
+
+void DiagLogger::set_output(std::ostream& out, std::ostream& err) {
+    std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+
+    // Nothing is written to the previous streams once this returns
+    std::unique_lock<std::mutex> write_lock(m_write_mutex);
+    wait_for_turn(write_lock, m_next_batch);
+
+    m_out = &out;
+    m_err = &err;
+}
+
+void DiagLogger::register_site(DiagSite* site) {
+    std::lock_guard<std::mutex> lock(m_registry_mutex);
+
+    m_sites.push_back(site);
+}
+
+DiagLogger::ThreadBuffer& DiagLogger::get_thread_buffer() {
+    if (!t_buffer.buffer)
+    {
+        auto buffer = std::make_shared<ThreadBuffer>();
+
+        {
+            std::lock_guard<std::mutex> lock(m_registry_mutex);
+
+            m_buffers.push_back(buffer);
+        }
+
+        t_buffer.buffer = std::move(buffer);
+    }
+
+    return *t_buffer.buffer;
+}
+
+void DiagLogger::ensure_started() {
+    if (m_started.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_thread_mutex);
+
+    if (!m_started.load(std::memory_order_relaxed))
+    {
+        std::thread(&DiagLogger::drain_loop, this).detach();
+
+        m_started.store(true, std::memory_order_release);
+    }
+}
+
+void DiagLogger::drain_loop() {
+    while (true)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(diag_log_constants::FLUSH_INTERVAL_MSEC));
+
+        drain(false);
+    }
+}
+
+void DiagLogger::drain(bool summaries_due) {
+    std::string out_batch;
+    std::string err_batch;
+    std::ostream* out = nullptr;
+    std::ostream* err = nullptr;
+    uint64_t batch = 0;
+
+    {
+        std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+
+        uint64_t dropped = 0;
+
+        {
+            std::lock_guard<std::mutex> registry_lock(m_registry_mutex);
+
+            // Takes the lines of every buffer, the ones of threads that are gone are removed once empty
+            const auto take = [&](const std::shared_ptr<ThreadBuffer>& buffer) {
+                std::lock_guard<std::mutex> lock(buffer->mutex);
+
+                out_batch += buffer->out;
+                err_batch += buffer->err;
+                dropped += buffer->dropped;
+
+                buffer->out.clear();
+                buffer->err.clear();
+                buffer->dropped = 0;
+
+                return buffer->exited;
+            };
+
+            m_buffers.erase(std::remove_if(m_buffers.begin(), m_buffers.end(), take), m_buffers.end());
+        }
+
+        if (dropped > 0)
+        {
+            err_batch += "[DiagLogger] ERROR: " + std::to_string(dropped) + " lines dropped, the buffer was full\n";
+        }
+
+        const auto now = now_msec();
+
+        if (summaries_due || now - m_last_summary_msec >= diag_log_constants::RATE_WINDOW_MSEC)
+        {
+            m_last_summary_msec = now;
+
+            write_summaries(out_batch, err_batch);
+        }
+
+        out = m_out;
+        err = m_err;
+        batch = m_next_batch++;
+    }
+
+    // Written without the drain mutex, a slow reader only holds up the writers
+    std::unique_lock<std::mutex> write_lock(m_write_mutex);
+    wait_for_turn(write_lock, batch);
+
+    if (!out_batch.empty())
+    {
+        *out << out_batch;
+        out->flush();
+    }
+
+    if (!err_batch.empty())
+    {
+        *err << err_batch;
+        err->flush();
+    }
+
+    m_written_batch++;
+    m_write_cv.notify_all();
+}
+
+void DiagLogger::wait_for_turn(std::unique_lock<std::mutex>& lock, uint64_t batch) {
+    m_write_cv.wait(lock, [&]() { return m_written_batch == batch; });
+}
+
+void DiagLogger::write_summaries(std::string& out, std::string& err) {
+    std::lock_guard<std::mutex> lock(m_registry_mutex);
+
+    for (const auto site : m_sites)
+    {
+        const auto suppressed = site->take_suppressed();
+
+        if (suppressed == 0)
+        {
+            continue;
+        }
+
+        auto& text = site->get_level() == LogLevel::Error ? err : out;
+
+        text += "[";
+        text += site->get_tag();
+        text += "] ";
+        text += log_level_str(site->get_level());
+        text += ": ";
+        text += std::to_string(suppressed);
+        text += " messages suppressed\n";
+    }
+}
+
+void DiagLogger::prepare_fork() {
+    auto& logger = instance();
+
+    logger.m_drain_mutex.lock();
+    logger.m_registry_mutex.lock();
+
+    for (const auto& buffer : logger.m_buffers)
+    {
+        buffer->mutex.lock();
+    }
+
+    logger.m_thread_mutex.lock();
+}
+
+void DiagLogger::parent_after_fork() {
+    auto& logger = instance();
+
+    logger.m_thread_mutex.unlock();
+
+    for (const auto& buffer : logger.m_buffers)
+    {
+        buffer->mutex.unlock();
+    }
+
+    logger.m_registry_mutex.unlock();
+    logger.m_drain_mutex.unlock();
+}
+
+void DiagLogger::child_after_fork() {
+    auto& logger = instance();
+
+    // The parent writes what was queued before the fork, and only this thread came along
+    for (const auto& buffer : logger.m_buffers)
+    {
+        buffer->out.clear();
+        buffer->err.clear();
+        buffer->dropped = 0;
+        buffer->exited = buffer != t_buffer.buffer;
+    }
+
+    logger.m_started.store(false, std::memory_order_relaxed);
+
+    // The parent's batch in writing, if any, is not ours to finish. Its writer did not come
+    // along, so the write mutex is reset instead of unlocked
+    new (&logger.m_write_mutex) std::mutex();
+    new (&logger.m_write_cv) std::condition_variable();
+    logger.m_written_batch = logger.m_next_batch;
+
+    logger.m_thread_mutex.unlock();
+
+    for (const auto& buffer : logger.m_buffers)
+    {
+        buffer->mutex.unlock();
+    }
+
+    logger.m_registry_mutex.unlock();
+    logger.m_drain_mutex.unlock();
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <ostream>
+
+// Levels below are compiled out, 0 keeps everything (set by CMake)
+#ifndef DIAG_LOG_LEVEL
+#define DIAG_LOG_LEVEL 0
+#endif
+
+enum class LogLevel : int {
+    Debug = 0,
+    Info  = 1,
+    Error = 2
+};
+
+const char* log_level_str(LogLevel level);
+
+/*
+    One logging statement, with its own rate limit: a few lines per window
+    are written, the rest only counted. The logger writes the count as a
+    "N messages suppressed" line once per window.
+*/
+class DiagSite {
+public:
+    DiagSite(const char* tag, LogLevel level);
+
+    // False if the statement is over its limit, the line is counted as suppressed
+    bool admit();
+
+    uint32_t take_suppressed() { return m_suppressed.exchange(0); }
+
+    const char* get_tag() const { return m_tag; }
+    LogLevel get_level() const { return m_level; }
+
+private:
+    const char*             m_tag;
+    LogLevel                m_level;
+    std::atomic<int64_t>    m_window_start;
+    std::atomic<uint32_t>   m_window_count;
+    std::atomic<uint32_t>   m_suppressed;
+};
+
+/*
+    Diagnostic output of the server, off the threads that produce it.
+
+    A line is formatted on the calling thread and appended to that thread's
+    own buffer; a background thread writes the buffers out every few
+    milliseconds. Only the background thread ever waits on the terminal or
+    the log pipe. A thread whose buffer is full drops the line and counts it
+    instead of waiting, and the drop count is written out with the next
+    batch. Debug and info lines go to the standard output, errors to the
+    standard error, as before.
+
+    fork() only waits for a batch to be taken from the buffers, not for it
+    to be written, and a forked child starts its own background thread on
+    its first line.
+*/
+class DiagLogger {
+public:
+    static DiagLogger& instance();
+
+    DiagLogger(const DiagLogger&) = delete;
+    DiagLogger& operator=(const DiagLogger&) = delete;
+
+    // The calling thread's line buffer, cleared
+    static std::ostringstream& begin_line();
+
+    // Queues the line begun by begin_line()
+    void end_line(const DiagSite& site);
+
+    // Writes everything queued so far, from the calling thread
+    void flush();
+
+    // Where the lines go, the standard streams by default
+    void set_output(std::ostream& out, std::ostream& err);
+
+    void register_site(DiagSite* site);
+
+    uint64_t get_dropped_count() const { return m_dropped_total; }
+
+private:
+    struct ThreadBuffer {
+        std::mutex      mutex;
+        std::string     out;
+        std::string     err;
+        uint64_t        dropped = 0;
+        bool            exited = false;     // Its thread is gone, removed once empty
+    };
+
+    // Marks the buffer of the thread as exited when the thread ends
+    struct ThreadBufferHolder {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~ThreadBufferHolder();
+    };
+
+    DiagLogger();     // Never destroyed, detached threads may log until the process exits
+
+    ThreadBuffer& get_thread_buffer();
+    void ensure_started();
+    void drain_loop();
+    void drain(bool summaries_due);
+    void wait_for_turn(std::unique_lock<std::mutex>& lock, uint64_t batch);
+    void write_summaries(std::string& out, std::string& err);
+
+    // Keeps the mutexes consistent across fork()
+    static void prepare_fork();
+    static void parent_after_fork();
+    static void child_after_fork();
+
+    static thread_local ThreadBufferHolder  t_buffer;
+
+    std::mutex                                  m_registry_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>>  m_buffers;
+    std::vector<DiagSite*>                      m_sites;
+
+    // Held while a batch is taken from the buffers, never while it is written out.
+    // fork() waits for it, and the streams may block for as long as the reader lets them
+    std::mutex                  m_drain_mutex;
+    std::ostream*               m_out;
+    std::ostream*               m_err;
+    int64_t                     m_last_summary_msec;
+    uint64_t                    m_next_batch;
+
+    // The batches are written in the order they were taken
+    std::mutex                  m_write_mutex;
+    std::condition_variable     m_write_cv;
+    uint64_t                    m_written_batch;
+
+    // Background thread of this process, detached
+    std::mutex                  m_thread_mutex;
+    std::atomic<bool>           m_started;
+
+    std::atomic<uint64_t>       m_dropped_total;
+};
+
+#define DIAG_LOG(level, tag, message)                                   \
+    do                                                                  \
+    {                                                                   \
+        static DiagSite diag_site(tag, level);                          \
+                                                                        \
+        if (diag_site.admit())                                          \
+        {                                                               \
+            DiagLogger::begin_line() << message;                        \
+            DiagLogger::instance().end_line(diag_site);                 \
+        }                                                               \
+    } while (false)
+
+// Still type checked, so that a variable only logged is used in every build, but never run
+#define DIAG_DISABLED(message)                                          \
+    do                                                                  \
+    {                                                                   \
+        if (false)                                                      \
+        {                                                               \
+            DiagLogger::begin_line() << message;                        \
+        }                                                               \
+    } while (false)
+
+#if DIAG_LOG_LEVEL <= 0
+#define DIAG_DEBUG(tag, message) DIAG_LOG(LogLevel::Debug, tag, message)
+#else
+#define DIAG_DEBUG(tag, message) DIAG_DISABLED(message)
+#endif
+
+#if DIAG_LOG_LEVEL <= 1
+#define DIAG_INFO(tag, message) DIAG_LOG(LogLevel::Info, tag, message)
+#else
+#define DIAG_INFO(tag, message) DIAG_DISABLED(message)
+#endif
+
+#define DIAG_ERROR(tag, message) DIAG_LOG(LogLevel::Error, tag, message)
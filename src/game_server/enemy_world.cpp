@@ -0,0 +1,527 @@
+#include "enemy_world.hpp"
+
+#include <cmath>
+#include "game_server_constants.hpp"
+#include "game_server_utils.hpp"
+#include "stage_timeline.hpp"
+
+namespace {
+    void push_bullet(FrameSnapshot& frame, BulletSnapshot& bullet, uint32_t& bullet_id) {
+        bullet.id = bullet_id++;
+        bullet.angle = std::atan2(bullet.vel.y, bullet.vel.x) - math_constants::HALF_PI;
+        frame.bullet_vector.push_back(bullet);
+        frame.bullet_count++;
+    }
+
+    void fire_circle(const Emitter& emitter, Vec2 origin, FrameSnapshot& frame, uint32_t& bullet_id) {
+        constexpr double two_pi = 2*math_constants::PI;
+        const double step = two_pi / emitter.count;
+
+        const float rad_offset = static_cast<float>(deg_to_rad(frame.timestamp % 360));
+
+        for (double r = 0; r < two_pi; r += step)
+        {
+            auto bullet = BulletSnapshot{};
+
+            bullet.name = emitter.bullet_name;
+            bullet.pos = origin;
+            bullet.vel = {
+                emitter.speed * std::cos(rad_offset + static_cast<float>(r)),
+                emitter.speed * std::sin(rad_offset + static_cast<float>(r))
+            };
+            bullet.radius = emitter.bullet_radius;
+            push_bullet(frame, bullet, bullet_id);
+        }
+    }
+
+    void fire_homing(const Emitter& emitter, Vec2 origin, FrameSnapshot& frame, uint32_t& bullet_id) {
+        float vx = frame.player_vector[0].pos.x - origin.x;
+        float vy = frame.player_vector[0].pos.y - origin.y;
+
+        float length = std::sqrt(vx * vx + vy * vy);
+
+        float dx = 1.0f;
+        float dy = 1.0f;
+
+        if (length != 0.0f)
+        {
+            dx = vx / length * emitter.speed;
+            dy = vy / length * emitter.speed;
+        }
+
+        auto bullet = BulletSnapshot{};
+
+        bullet.name = emitter.bullet_name;
+        bullet.pos = origin;
+        bullet.vel = { dx, dy };
+        bullet.radius = emitter.bullet_radius;
+        push_bullet(frame, bullet, bullet_id);
+    }
+
+    void fire_spiral(const Emitter& emitter, Vec2 origin, FrameSnapshot& frame, uint32_t& bullet_id) {
+        constexpr double two_pi = 2*math_constants::PI;
+        const double step = two_pi / emitter.count;
+
+        const float rad_offset = static_cast<float>(deg_to_rad(frame.timestamp % 360));
+        size_t sprite_index = 0;
+
+        for (double r = 0; r < two_pi; r += step)
+        {
+            sprite_index++;
+
+            const float dx = cos(rad_offset + r) * emitter.speed;
+            const float dy = sin(rad_offset + r) * emitter.speed;
+
+            auto bullet = BulletSnapshot{};
+
+            bullet.name = static_cast<BulletName>(
+                static_cast<size_t>(emitter.bullet_name) + (sprite_index % 8)
+            );
+            bullet.pos = origin;
+            bullet.vel = { dx, dy };
+            bullet.radius = emitter.bullet_radius;
+            push_bullet(frame, bullet, bullet_id);
+        }
+    }
+
+    void fire_random(const Emitter& emitter, Vec2 origin, FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id) {
+        // Create a distribution in the range [0, 359]
+        std::uniform_int_distribution<> dist(0, 359);
+
+        for (size_t i = 0; i < emitter.count; i++)
+        {
+            const double rand_1 = dist(gen);
+            const double rand_2 = dist(gen);
+            const float rad_1 = static_cast<float>(deg_to_rad(rand_1));
+            const float rad_2 = static_cast<float>(deg_to_rad(rand_2));
+            const float dx = cos(rad_1) * emitter.speed;
+            const float dy = sin(rad_2) * emitter.speed;
+
+            auto bullet = BulletSnapshot{};
+
+            // Cycles through every normal bullet color
+            bullet.name = static_cast<BulletName>(i % 8 + 1);
+            bullet.pos = origin;
+            bullet.vel = { dx, dy };
+            bullet.radius = emitter.bullet_radius;
+            push_bullet(frame, bullet, bullet_id);
+        }
+    }
+
+    void fire_pattern(const Emitter& emitter, Vec2 origin, FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id) {
+        switch (emitter.pattern)
+        {
+            case EmitterPattern::Circle: { fire_circle(emitter, origin, frame, bullet_id);        break; }
+            case EmitterPattern::Homing: { fire_homing(emitter, origin, frame, bullet_id);        break; }
+            case EmitterPattern::Spiral: { fire_spiral(emitter, origin, frame, bullet_id);        break; }
+            case EmitterPattern::Random: { fire_random(emitter, origin, frame, gen, bullet_id);   break; }
+        }
+    }
+
+    bool is_emitter_due(const Emitter& emitter, uint64_t tick) {
+        const auto expr_1 = tick % emitter.interval == 0;
+        const auto expr_2 = emitter.cycle == 0 || (tick % emitter.cycle) > emitter.cycle_phase;
+        const auto expr_3 = tick > emitter.start_tick;
+
+        return expr_1 && expr_2 && expr_3;
+    }
+}
+
+Archetype::Archetype(uint32_t mask, std::pmr::memory_resource* resource)
+    : mask(mask)
+    , entities(resource)
+    , transforms(resource)
+    , bodies(resource)
+    , bounces(resource)
+    , emitters(resource)
+    , follows(resource)
+{}
+
+EnemyWorld::EnemyWorld(std::pmr::memory_resource* resource)
+    : m_resource(resource)
+    , m_archetypes(resource)
+    , m_locations(resource)
+    , m_free_ids(resource)
+{}
+
+EntityId EnemyWorld::spawn(const EntityDesc& desc) {
+    uint32_t index = 0;
+
+    if (!m_free_ids.empty())
+    {
+        index = m_free_ids.back();
+        m_free_ids.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_locations.size());
+        m_locations.push_back({ DEAD, DEAD, 0 });
+    }
+
+    const EntityId entity = { index, m_locations[index].generation };
+
+    auto& archetype = find_or_create_archetype(desc.mask);
+    const auto archetype_index = static_cast<uint32_t>(&archetype - m_archetypes.data());
+
+    m_locations[index] = { archetype_index, static_cast<uint32_t>(archetype.size()), entity.generation };
+    archetype.entities.push_back(entity);
+
+    if (archetype.has(component::TRANSFORM))    { archetype.transforms.push_back(desc.transform); }
+    if (archetype.has(component::BODY))         { archetype.bodies.push_back(desc.body); }
+    if (archetype.has(component::BOUNCE))       { archetype.bounces.push_back(desc.bounce); }
+    if (archetype.has(component::EMITTER))      { archetype.emitters.push_back(desc.emitter); }
+    if (archetype.has(component::FOLLOW))       { archetype.follows.push_back(desc.follow); }
+
+    return entity;
+}
+
+void EnemyWorld::destroy(EntityId entity) {
+    if (!alive(entity))
+    {
+        return;
+    }
+
+    const auto location = m_locations[entity.index];
+    auto& archetype = m_archetypes[location.archetype];
+
+    // Swap with the last row to keep the columns packed
+    auto swap_remove = [&](auto& column) {
+        if (!column.empty())
+        {
+            column[location.row] = column.back();
+            column.pop_back();
+        }
+    };
+
+    const auto moved = archetype.entities.back();
+
+    swap_remove(archetype.entities);
+    swap_remove(archetype.transforms);
+    swap_remove(archetype.bodies);
+    swap_remove(archetype.bounces);
+    swap_remove(archetype.emitters);
+    swap_remove(archetype.follows);
+
+    if (moved != entity)
+    {
+        m_locations[moved.index].row = location.row;
+    }
+
+    // Handles to this entity no longer resolve once the slot is reused
+    m_locations[entity.index] = { DEAD, DEAD, location.generation + 1 };
+    m_free_ids.push_back(entity.index);
+}
+
+bool EnemyWorld::alive(EntityId entity) const {
+    if (entity.index >= m_locations.size())
+    {
+        return false;
+    }
+
+    const auto& location = m_locations[entity.index];
+
+    return location.archetype != DEAD && location.generation == entity.generation;
+}
+
+size_t EnemyWorld::size() const {
+    return m_locations.size() - m_free_ids.size();
+}
+
+void EnemyWorld::update_motion(uint64_t tick) {
+    for (auto& archetype : m_archetypes)
+    {
+        if (!archetype.has(component::TRANSFORM | component::BOUNCE))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < archetype.size(); i++)
+        {
+            auto& transform = archetype.transforms[i];
+            const auto& bounce = archetype.bounces[i];
+
+            // Update direction
+            if (transform.pos.x > bounce.max_x)
+            {
+                transform.vel.x = -bounce.speed;
+            }
+            else if (transform.pos.x < bounce.min_x)
+            {
+                transform.vel.x = bounce.speed;
+            }
+
+            if (transform.pos.y > bounce.max_y)
+            {
+                transform.vel.y = -bounce.speed;
+            }
+            else if (transform.pos.y < bounce.min_y)
+            {
+                transform.vel.y = bounce.speed;
+            }
+
+            // Move
+            if ((tick % bounce.cycle) < bounce.active_ticks)
+            {
+                transform.pos.x += transform.vel.x;
+                transform.pos.y += transform.vel.y;
+            }
+        }
+    }
+}
+
+void EnemyWorld::update_follow(std::pmr::memory_resource* scratch) {
+    std::pmr::vector<EntityId> orphans(scratch);
+
+    for (auto& archetype : m_archetypes)
+    {
+        if (!archetype.has(component::TRANSFORM | component::FOLLOW))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < archetype.size(); i++)
+        {
+            const auto parent = archetype.follows[i].parent;
+
+            if (!alive(parent))
+            {
+                orphans.push_back(archetype.entities[i]);
+
+                continue;
+            }
+
+            const auto location = m_locations[parent.index];
+            const auto& parent_archetype = m_archetypes[location.archetype];
+
+            if (parent_archetype.has(component::TRANSFORM))
+            {
+                archetype.transforms[i].pos = parent_archetype.transforms[location.row].pos;
+            }
+        }
+    }
+
+    for (const auto entity : orphans)
+    {
+        destroy(entity);
+    }
+}
+
+void EnemyWorld::fire_emitters(FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id) {
+    for (const auto& archetype : m_archetypes)
+    {
+        if (!archetype.has(component::TRANSFORM | component::EMITTER))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < archetype.size(); i++)
+        {
+            const auto& emitter = archetype.emitters[i];
+
+            if (!is_emitter_due(emitter, frame.timestamp))
+            {
+                continue;
+            }
+
+            fire_pattern(emitter, archetype.transforms[i].pos, frame, gen, bullet_id);
+        }
+    }
+}
+
+void EnemyWorld::fire_emitter(EntityId entity, FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id) {
+    if (!alive(entity))
+    {
+        return;
+    }
+
+    const auto location = m_locations[entity.index];
+    const auto& archetype = m_archetypes[location.archetype];
+
+    if (archetype.has(component::TRANSFORM | component::EMITTER))
+    {
+        fire_pattern(archetype.emitters[location.row], archetype.transforms[location.row].pos, frame, gen, bullet_id);
+    }
+}
+
+void EnemyWorld::write_enemies(FrameSnapshot& frame) const {
+    frame.enemy_vector.clear();
+
+    for (const auto& archetype : m_archetypes)
+    {
+        if (!archetype.has(component::TRANSFORM | component::BODY))
+        {
+            continue;
+        }
+
+        for (size_t i = 0; i < archetype.size(); i++)
+        {
+            const auto& transform = archetype.transforms[i];
+            const auto& body = archetype.bodies[i];
+
+            EnemySnapshot enemy = {};
+            enemy.id = body.id;
+            enemy.name = body.name;
+            enemy.pos = transform.pos;
+            enemy.vel = transform.vel;
+            enemy.radius = body.radius;
+            frame.enemy_vector.push_back(enemy);
+        }
+    }
+
+    frame.enemy_count = frame.enemy_vector.size();
+}
+
+void EnemyWorld::serialize(StateWriter& writer) const {
+    writer.write(static_cast<uint32_t>(m_archetypes.size()));
+
+    for (const auto& archetype : m_archetypes)
+    {
+        writer.write(archetype.mask);
+        writer.write_vector(archetype.entities);
+        writer.write_vector(archetype.transforms);
+        writer.write_vector(archetype.bodies);
+        writer.write_vector(archetype.bounces);
+        writer.write_vector(archetype.emitters);
+        writer.write_vector(archetype.follows);
+    }
+
+    writer.write_vector(m_locations);
+    writer.write_vector(m_free_ids);
+}
+
+bool EnemyWorld::deserialize(StateReader& reader) {
+    uint32_t archetype_count = 0;
+
+    if (!reader.read(archetype_count))
+    {
+        return false;
+    }
+
+    m_archetypes.clear();
+
+    for (uint32_t i = 0; i < archetype_count && !reader.failed(); i++)
+    {
+        auto& archetype = m_archetypes.emplace_back(0, m_resource);
+
+        reader.read(archetype.mask);
+        reader.read_vector(archetype.entities);
+        reader.read_vector(archetype.transforms);
+        reader.read_vector(archetype.bodies);
+        reader.read_vector(archetype.bounces);
+        reader.read_vector(archetype.emitters);
+        reader.read_vector(archetype.follows);
+    }
+
+    reader.read_vector(m_locations);
+    reader.read_vector(m_free_ids);
+
+    return !reader.failed() && is_consistent();
+}
+
+// The systems index columns and locations without checks, a state from outside has to hold up to that first
+bool EnemyWorld::is_consistent() const {
+    const auto column_fits = [](const Archetype& archetype, uint32_t component, size_t column_size) {
+        return column_size == (archetype.has(component) ? archetype.size() : 0);
+    };
+
+    size_t live_count = 0;
+
+    for (uint32_t a = 0; a < m_archetypes.size(); a++)
+    {
+        const auto& archetype = m_archetypes[a];
+
+        if (!column_fits(archetype, component::TRANSFORM, archetype.transforms.size())
+            || !column_fits(archetype, component::BODY, archetype.bodies.size())
+            || !column_fits(archetype, component::BOUNCE, archetype.bounces.size())
+            || !column_fits(archetype, component::EMITTER, archetype.emitters.size())
+            || !column_fits(archetype, component::FOLLOW, archetype.follows.size()))
+        {
+            return false;
+        }
+
+        // Every row is named by its slot
+        for (uint32_t row = 0; row < archetype.size(); row++)
+        {
+            const auto entity = archetype.entities[row];
+
+            if (entity.index >= m_locations.size())
+            {
+                return false;
+            }
+
+            const auto& location = m_locations[entity.index];
+
+            if (location.archetype != a || location.row != row || location.generation != entity.generation)
+            {
+                return false;
+            }
+        }
+
+        // Divisors of the motion and emitter systems
+        for (const auto& bounce : archetype.bounces)
+        {
+            if (bounce.cycle == 0)
+            {
+                return false;
+            }
+        }
+
+        for (const auto& emitter : archetype.emitters)
+        {
+            if (emitter.interval == 0)
+            {
+                return false;
+            }
+        }
+
+        live_count += archetype.size();
+    }
+
+    // Every other slot is free, and listed once
+    std::vector<bool> listed(m_locations.size(), false);
+
+    for (const auto index : m_free_ids)
+    {
+        if (index >= m_locations.size() || m_locations[index].archetype != DEAD || listed[index])
+        {
+            return false;
+        }
+
+        listed[index] = true;
+    }
+
+    return live_count + m_free_ids.size() == m_locations.size();
+}
+
+Archetype& EnemyWorld::find_or_create_archetype(uint32_t mask) {
+    for (auto& archetype : m_archetypes)
+    {
+        if (archetype.mask == mask)
+        {
+            return archetype;
+        }
+    }
+
+    return m_archetypes.emplace_back(mask, m_resource);
+}
+
+EntityId spawn_default_enemy(EnemyWorld& world, uint32_t enemy_id, Vec2 pos) {
+    auto enemy = default_stage_desc().enemies[0];
+    enemy.body.id = enemy_id;
+    enemy.transform.pos = pos;
+
+    return spawn_stage_enemy(world, enemy);
+}
+
+void update_enemies(
+    EnemyWorld& world,
+    FrameSnapshot& frame,
+    std::mt19937& gen,
+    uint32_t& bullet_id,
+    std::pmr::memory_resource* scratch
+) {
+    world.update_motion(frame.timestamp);
+    world.update_follow(scratch);
+    world.fire_emitters(frame, gen, bullet_id);
+    world.write_enemies(frame);
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <memory_resource>
+#include <packet_template/packet_template.hpp>
+#include "state_codec.hpp"
+
+/*
+    Archetype based entity/component store for enemies and bullet emitters.
+
+    Entities that own the same set of components share an archetype, which
+    keeps every component in its own tightly packed array. Systems walk those
+    arrays and dispatch on plain data, there is no per-entity virtual call.
+*/
+
+// Slot and generation. A slot is reused with the next generation once its entity is destroyed,
+// so handles kept by other entities or the session stop resolving instead of naming the new entity
+struct EntityId {
+    uint32_t    index;
+    uint32_t    generation;
+
+    bool operator==(const EntityId& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const EntityId& other) const { return !(*this == other); }
+};
+
+// Vector type used by the snapshots
+using Vec2 = decltype(EnemySnapshot::pos);
+
+constexpr EntityId INVALID_ENTITY = { UINT32_MAX, UINT32_MAX };
+
+// Component masks
+namespace component {
+    constexpr uint32_t TRANSFORM    = 1 << 0;
+    constexpr uint32_t BODY         = 1 << 1;
+    constexpr uint32_t BOUNCE       = 1 << 2;
+    constexpr uint32_t EMITTER      = 1 << 3;
+    constexpr uint32_t FOLLOW       = 1 << 4;
+}
+
+/*
+    Components
+*/
+struct Transform {
+    Vec2 pos;
+    Vec2 vel;
+};
+
+// Makes an entity show up as an enemy in the frame
+struct EnemyBody {
+    uint32_t    id;
+    EnemyName   name;
+    float       radius;
+};
+
+// Moves inside a box and turns around at its edges, during the first `active_ticks` of every `cycle` ticks
+struct BounceMotion {
+    float       speed;
+    float       min_x;
+    float       max_x;
+    float       min_y;
+    float       max_y;
+    uint32_t    cycle;
+    uint32_t    active_ticks;
+};
+
+enum class EmitterPattern : uint8_t {
+    Circle,     // `count` bullets evenly spread, rotating with the tick
+    Homing,     // One bullet aimed at the player
+    Spiral,     // Like circle, sprite color cycles per bullet
+    Random,     // `count` bullets in random directions
+};
+
+// Fires every `interval` ticks, while `tick % cycle > cycle_phase` (if cycle != 0) and after `start_tick`
+struct Emitter {
+    EmitterPattern  pattern;
+    uint32_t        interval;
+    uint32_t        cycle;
+    uint32_t        cycle_phase;
+    uint32_t        start_tick;
+    uint32_t        count;
+    float           speed;
+    BulletName      bullet_name;
+    float           bullet_radius;
+};
+
+// Sticks to the position of another entity, emitters die with their parent
+struct Follow {
+    EntityId    parent;
+};
+
+// Components of an entity to be spawned, only the ones in `mask` are used
+struct EntityDesc {
+    uint32_t        mask        = 0;
+    Transform       transform   = {};
+    EnemyBody       body        = {};
+    BounceMotion    bounce      = {};
+    Emitter         emitter     = {};
+    Follow          follow      = {};
+};
+
+struct Archetype {
+    Archetype(uint32_t mask, std::pmr::memory_resource* resource);
+
+    uint32_t                        mask;
+    std::pmr::vector<EntityId>      entities;
+
+    // Columns, empty unless the component is in the mask
+    std::pmr::vector<Transform>     transforms;
+    std::pmr::vector<EnemyBody>     bodies;
+    std::pmr::vector<BounceMotion>  bounces;
+    std::pmr::vector<Emitter>       emitters;
+    std::pmr::vector<Follow>        follows;
+
+    bool has(uint32_t required) const { return (mask & required) == required; }
+    size_t size() const { return entities.size(); }
+};
+
+class EnemyWorld {
+public:
+    explicit EnemyWorld(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    EntityId spawn(const EntityDesc& desc);
+    void destroy(EntityId entity);
+    bool alive(EntityId entity) const;
+    size_t size() const;
+
+    /*
+        Systems, run in this order once per tick
+    */
+    void update_motion(uint64_t tick);
+    void update_follow(std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+    void fire_emitters(FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id);
+    void fire_emitter(EntityId entity, FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id);    // Scheduled by a stage timeline
+    void write_enemies(FrameSnapshot& frame) const;
+
+    const std::pmr::vector<Archetype>& get_archetypes() const { return m_archetypes; }
+
+    // Session migration
+    void serialize(StateWriter& writer) const;
+    bool deserialize(StateReader& reader);
+
+private:
+    struct Location {
+        uint32_t archetype;
+        uint32_t row;
+        uint32_t generation;    // Of the entity in the slot, or of the next one while it is free
+    };
+
+    static constexpr uint32_t DEAD = UINT32_MAX;
+
+    Archetype& find_or_create_archetype(uint32_t mask);
+    bool is_consistent() const;
+
+    std::pmr::memory_resource*      m_resource;
+    std::pmr::vector<Archetype>     m_archetypes;
+    std::pmr::vector<Location>      m_locations;    // Indexed by EntityId::index
+    std::pmr::vector<uint32_t>      m_free_ids;     // Free slots
+};
+
+// The boss of the default stage: bounces around the upper half and fires circle, homing, spiral and random shots
+EntityId spawn_default_enemy(EnemyWorld& world, uint32_t enemy_id, Vec2 pos);
+
+// Applies the whole enemy tick to the frame, `scratch` holds what is needed within the tick only
+void update_enemies(
+    EnemyWorld& world,
+    FrameSnapshot& frame,
+    std::mt19937& gen,
+    uint32_t& bullet_id,
+    std::pmr::memory_resource* scratch = std::pmr::get_default_resource()
+);
@@ -0,0 +1,147 @@
+#include "frame_json_writer.hpp"
+
+#include <charconv>     // std::to_chars
+#include <cstring>      // std::memcpy
+#include <algorithm>    // std::max
+
+namespace {
+    // Longest std::to_chars output of a float or a 64 bit integer
+    constexpr size_t MAX_NUMBER_CHARS = 32;
+}
+
+FrameJsonWriter::FrameJsonWriter(size_t initial_capacity, std::pmr::memory_resource* resource)
+    : m_buffer(initial_capacity, resource)
+    , m_size(0)
+{}
+
+std::string_view FrameJsonWriter::write(const FrameSnapshot& frame) {
+    m_size = 0;
+
+    put('{');
+    put_key("timestamp");       put_uint(frame.timestamp);          put(',');
+    put_key("state");           put_enum(frame.state);              put(',');
+    put_key("stage");           write_stage(frame.stage);           put(',');
+    put_key("player_count");    put_uint(frame.player_count);       put(',');
+    write_array("player_vector", frame.player_vector, [this](const auto& player) { write_player(player); });
+    put(',');
+    put_key("enemy_count");     put_uint(frame.enemy_count);        put(',');
+    write_array("enemy_vector", frame.enemy_vector, [this](const auto& enemy) { write_enemy(enemy); });
+    put(',');
+    put_key("bullet_count");    put_uint(frame.bullet_count);       put(',');
+    write_array("bullet_vector", frame.bullet_vector, [this](const auto& bullet) { write_bullet(bullet); });
+    put('}');
+
+    return std::string_view(m_buffer.data(), m_size);
+}
+
+void FrameJsonWriter::write_stage(const StageSnapshot& stage) {
+    put('{');
+    put_key("id");      put_uint(stage.id);     put(',');
+    put_key("name");    put_enum(stage.name);
+    put('}');
+}
+
+void FrameJsonWriter::write_player(const PlayerSnapshot& player) {
+    put('{');
+    put_key("id");      put_uint(player.id);        put(',');
+    put_key("name");    put_enum(player.name);      put(',');
+    put_key("pos");     put_vec2(player.pos);       put(',');
+    put_key("vel");     put_vec2(player.vel);       put(',');
+    put_key("radius");  put_float(player.radius);   put(',');
+    put_key("lives");   put_uint(player.lives);
+    put('}');
+}
+
+void FrameJsonWriter::write_enemy(const EnemySnapshot& enemy) {
+    put('{');
+    put_key("id");      put_uint(enemy.id);         put(',');
+    put_key("name");    put_enum(enemy.name);       put(',');
+    put_key("pos");     put_vec2(enemy.pos);        put(',');
+    put_key("vel");     put_vec2(enemy.vel);        put(',');
+    put_key("radius");  put_float(enemy.radius);
+    put('}');
+}
+
+void FrameJsonWriter::write_bullet(const BulletSnapshot& bullet) {
+    put('{');
+    put_key("id");      put_uint(bullet.id);        put(',');
+    put_key("name");    put_enum(bullet.name);      put(',');
+    put_key("pos");     put_vec2(bullet.pos);       put(',');
+    put_key("vel");     put_vec2(bullet.vel);       put(',');
+    put_key("radius");  put_float(bullet.radius);   put(',');
+    put_key("angle");   put_float(bullet.angle);
+    put('}');
+}
+
+template <typename T, typename WriteItem>
+void FrameJsonWriter::write_array(std::string_view key, const std::vector<T>& items, WriteItem write_item) {
+    put_key(key);
+    put('[');
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (i > 0)
+        {
+            put(',');
+        }
+
+        write_item(items[i]);
+    }
+
+    put(']');
+}
+
+void FrameJsonWriter::reserve(size_t extra) {
+    if (m_size + extra > m_buffer.size())
+    {
+        // Only while the frames keep getting larger
+        m_buffer.resize(std::max(m_buffer.size() * 2, m_size + extra));
+    }
+}
+
+void FrameJsonWriter::put(char c) {
+    reserve(1);
+    m_buffer[m_size++] = c;
+}
+
+void FrameJsonWriter::put(std::string_view text) {
+    reserve(text.size());
+    std::memcpy(m_buffer.data() + m_size, text.data(), text.size());
+    m_size += text.size();
+}
+
+void FrameJsonWriter::put_key(std::string_view key) {
+    reserve(key.size() + 3);
+
+    m_buffer[m_size++] = '"';
+    std::memcpy(m_buffer.data() + m_size, key.data(), key.size());
+    m_size += key.size();
+    m_buffer[m_size++] = '"';
+    m_buffer[m_size++] = ':';
+}
+
+void FrameJsonWriter::put_uint(uint64_t value) {
+    reserve(MAX_NUMBER_CHARS);
+
+    auto* begin = m_buffer.data() + m_size;
+    const auto result = std::to_chars(begin, begin + MAX_NUMBER_CHARS, value);
+
+    m_size += static_cast<size_t>(result.ptr - begin);
+}
+
+void FrameJsonWriter::put_float(float value) {
+    reserve(MAX_NUMBER_CHARS);
+
+    // Shortest representation that reads back as the same float
+    auto* begin = m_buffer.data() + m_size;
+    const auto result = std::to_chars(begin, begin + MAX_NUMBER_CHARS, value);
+
+    m_size += static_cast<size_t>(result.ptr - begin);
+}
+
+void FrameJsonWriter::put_vec2(const decltype(PlayerSnapshot::pos)& value) {
+    put('{');
+    put_key("x");   put_float(value.x);     put(',');
+    put_key("y");   put_float(value.y);
+    put('}');
+}
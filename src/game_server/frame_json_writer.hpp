@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <memory_resource>
+#include <string_view>
+#include <type_traits>
+#include <packet_template/packet_template.hpp>
+
+/*
+    Encodes a frame as one playlog line, the same bytes frame_to_json_str()
+    produces, straight into a buffer that is reused from frame to frame.
+    Numbers are formatted with std::to_chars, so once the buffer has grown
+    to the largest frame of the session nothing is allocated any more.
+*/
+class FrameJsonWriter {
+public:
+    explicit FrameJsonWriter(
+        size_t initial_capacity = 64 * 1024,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    );
+
+    // Valid until the next call
+    std::string_view write(const FrameSnapshot& frame);
+
+private:
+    void write_stage(const StageSnapshot& stage);
+    void write_player(const PlayerSnapshot& player);
+    void write_enemy(const EnemySnapshot& enemy);
+    void write_bullet(const BulletSnapshot& bullet);
+
+    template <typename T, typename WriteItem>
+    void write_array(std::string_view key, const std::vector<T>& items, WriteItem write_item);
+
+    void reserve(size_t extra);
+    void put(char c);
+    void put(std::string_view text);
+    void put_key(std::string_view key);     // "key":
+    void put_uint(uint64_t value);
+    void put_float(float value);
+    void put_vec2(const decltype(PlayerSnapshot::pos)& value);
+
+    template <typename Enum>
+    void put_enum(Enum value) {
+        put_uint(static_cast<std::underlying_type_t<Enum>>(value));
+    }
+
+    std::pmr::vector<char>  m_buffer;
+    size_t                  m_size;
+};
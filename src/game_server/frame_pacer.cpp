@@ -0,0 +1,70 @@
+#include "frame_pacer.hpp"
+
+#include <algorithm>    // std::min
+#include <cerrno>
+#include <ctime>
+
+namespace {
+    constexpr int64_t NSEC_PER_SEC = 1000000000;
+
+    void sleep_until(int64_t deadline_nsec) {
+        timespec deadline = {};
+        deadline.tv_sec = deadline_nsec / NSEC_PER_SEC;
+        deadline.tv_nsec = deadline_nsec % NSEC_PER_SEC;
+
+        // Absolute, so a signal only needs the same call again
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+        {
+        }
+    }
+}
+
+FramePacer::FramePacer(int64_t period_nsec, int64_t spin_nsec, uint32_t max_catch_up_ticks)
+    : m_period_nsec(period_nsec)
+    , m_spin_nsec(std::min(spin_nsec, period_nsec))
+    , m_max_catch_up_ticks(max_catch_up_ticks)
+    , m_deadline_nsec(0)
+{
+}
+
+int64_t FramePacer::now_nsec() {
+    timespec now = {};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return static_cast<int64_t>(now.tv_sec) * NSEC_PER_SEC + now.tv_nsec;
+}
+
+void FramePacer::start() {
+    m_deadline_nsec = now_nsec() + m_period_nsec;
+}
+
+PaceResult FramePacer::wait() {
+    auto now = now_nsec();
+
+    if (now < m_deadline_nsec - m_spin_nsec)
+    {
+        sleep_until(m_deadline_nsec - m_spin_nsec);
+    }
+
+    // The scheduler wakes us up late by tens of microseconds, the spin covers that
+    do
+    {
+        now = now_nsec();
+    }
+    while (now < m_deadline_nsec);
+
+    PaceResult result = {};
+    result.late_nsec = now - m_deadline_nsec;
+
+    // Deadlines that have passed while we were late
+    const auto missed = static_cast<uint64_t>(result.late_nsec / m_period_nsec);
+    const auto caught_up = static_cast<uint32_t>(std::min<uint64_t>(missed, m_max_catch_up_ticks));
+
+    result.ticks = 1 + caught_up;
+    result.dropped = static_cast<uint32_t>(missed - caught_up);
+
+    // Still on the grid, dropped ticks included
+    m_deadline_nsec += static_cast<int64_t>(missed + 1) * m_period_nsec;
+
+    return result;
+}
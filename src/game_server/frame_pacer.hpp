@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include "game_server_constants.hpp"
+
+enum class OverrunPolicy : uint8_t {
+    CatchUp,    // The missed ticks run back to back, each frame is sent
+    Skip,       // The missed ticks run back to back, only the latest frame is sent
+};
+
+// Missed ticks a policy runs on the next wake up, see pacing_constants
+constexpr uint32_t get_max_catch_up_ticks(OverrunPolicy policy) {
+    return policy == OverrunPolicy::Skip ? pacing_constants::MAX_SKIP_TICKS : pacing_constants::MAX_CATCH_UP_TICKS;
+}
+
+struct PaceResult {
+    uint32_t    ticks;          // Steps to run now, more than 1 after a missed deadline
+    uint32_t    dropped;        // Missed ticks beyond the catch up limit, never simulated
+    int64_t     late_nsec;      // Wake up time past the deadline
+};
+
+/*
+    Paces the game loop on absolute deadlines.
+
+    Tick n is due at start + n * period on the monotonic clock, and the loop
+    sleeps until that point (clock_nanosleep with TIMER_ABSTIME) instead of
+    for whatever is left of the tick. An oversleep delays only the tick it
+    happens in, the following deadlines stay where they were. With a spin
+    set, the last part of the wait busy waits for a tighter wake up.
+
+    A wake up past one or more following deadlines reports those ticks as
+    due, so simulation time keeps up with wall time. What the loop sends
+    for them is the overrun policy's business, and so is how many of them
+    run at most (get_max_catch_up_ticks()). Only the ticks beyond that are
+    dropped and set simulation time back.
+*/
+class FramePacer {
+public:
+    FramePacer(
+        int64_t period_nsec,
+        int64_t spin_nsec = pacing_constants::SPIN_NSEC,
+        uint32_t max_catch_up_ticks = pacing_constants::MAX_CATCH_UP_TICKS
+    );
+
+    static int64_t now_nsec();  // CLOCK_MONOTONIC
+
+    // The first deadline is one period from now
+    void start();
+
+    // Blocks until the next deadline
+    PaceResult wait();
+
+    int64_t get_period_nsec() const { return m_period_nsec; }
+
+private:
+    int64_t     m_period_nsec;
+    int64_t     m_spin_nsec;
+    uint32_t    m_max_catch_up_ticks;
+    int64_t     m_deadline_nsec;
+};
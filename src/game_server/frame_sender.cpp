@@ -0,0 +1,286 @@
+#include "frame_sender.hpp"
+
+#include "game_server_constants.hpp"
+#include <chrono>
+
+FrameSender::FrameSender(
+    Transport& transport,
+    std::shared_ptr<InstanceStats> stats,
+    LatencyEstimator* latency_estimator
+)
+    : m_transport(transport)
+    , m_inline(transport.sends_inline())
+    , m_stats(std::move(stats))
+    , m_latency_estimator(latency_estimator)
+    , m_pending_ack{}
+    , m_in_flight(false)
+    , m_running(false)
+    , m_connection_lost(false)
+    , m_worker_done(false)
+    , m_rate_level(0)
+    , m_window_ticks(0)
+    , m_clean_windows(0)
+    , m_window_coalesced_base(0)
+{
+    m_stats->snapshot_rate_hz = get_snapshot_rate_hz();
+}
+
+FrameSender::~FrameSender() {
+    stop();
+}
+
+void FrameSender::start() {
+    if (!m_running)
+    {
+        m_running = true;
+
+        if (!m_inline)
+        {
+            m_worker_done = false;
+
+            m_worker = std::thread(&FrameSender::sending_worker, this);
+        }
+    }
+}
+
+void FrameSender::stop() {
+    if (m_running && m_inline)
+    {
+        m_running = false;
+
+        // One last chance for the latest frame
+        flush_inline();
+    }
+    else if (m_running)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_running = false;
+        m_cv.notify_one();
+
+        const auto flushed = m_done_cv.wait_for(lock, std::chrono::milliseconds(send_constants::STOP_TIMEOUT_MSEC), [&]{
+            return m_worker_done;
+        });
+
+        lock.unlock();
+
+        // Blocked on a client that does not drain, cutting the connection fails the send
+        if (!flushed)
+        {
+            m_connection_lost = true;
+            m_transport.disconnect();
+        }
+
+        if (m_worker.joinable())
+        {
+            m_worker.join();
+        }
+    }
+}
+
+bool FrameSender::is_frame_due(uint64_t tick) {
+    adapt_rate();
+
+    return tick % send_constants::SNAPSHOT_RATE_DIVISORS[m_rate_level] == 0;
+}
+
+void FrameSender::send_frame(Packet packet, const FrameAck& ack) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The previous frame is stale by now, the newest one replaces it
+        if (m_pending_frame.has_value())
+        {
+            m_stats->frames_coalesced++;
+        }
+
+        m_pending_frame = std::move(packet);
+        m_pending_ack = ack;
+        update_queue_depth();
+    }
+
+    if (m_inline)
+    {
+        flush_inline();
+
+        return;
+    }
+
+    m_cv.notify_one();
+}
+
+void FrameSender::send_control(Packet packet) {
+    if (m_inline)
+    {
+        m_transport.send_packet(std::move(packet));
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_control_queue.push(std::move(packet));
+        update_queue_depth();
+    }
+
+    m_cv.notify_one();
+}
+
+uint32_t FrameSender::get_snapshot_rate_hz() const {
+    return game_constants::TARGET_FPS / send_constants::SNAPSHOT_RATE_DIVISORS[m_rate_level];
+}
+
+void FrameSender::sending_worker() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        m_cv.wait(
+            lock,
+            [&]{
+                return !m_control_queue.empty() || m_pending_frame.has_value() || !m_running.load();
+            }
+        );
+
+        if (m_control_queue.empty() && !m_pending_frame.has_value())
+        {
+            // Stopped and nothing left to flush
+            break;
+        }
+
+        // Nothing reaches the client any more
+        if (m_connection_lost)
+        {
+            m_control_queue = {};
+            m_pending_frame.reset();
+            update_queue_depth();
+
+            continue;
+        }
+
+        // Control packets go first, they are never coalesced
+        const auto is_frame = m_control_queue.empty();
+        const auto ack = m_pending_ack;
+        auto packet = is_frame ? std::move(*m_pending_frame) : std::move(m_control_queue.front());
+
+        if (is_frame)
+        {
+            m_pending_frame.reset();
+        }
+        else
+        {
+            m_control_queue.pop();
+        }
+
+        m_in_flight = true;
+        lock.unlock();
+
+        if (is_frame && m_latency_estimator != nullptr)
+        {
+            m_latency_estimator->record_ping(std::get<FrameSnapshot>(packet.payload).timestamp, LatencyEstimator::now_usec());
+        }
+
+        // May block as long as the client does not drain its socket
+        const auto sent = is_frame ? m_transport.send_frame(std::move(packet), ack) : m_transport.send_packet(std::move(packet));
+
+        lock.lock();
+        m_in_flight = false;
+        update_queue_depth();
+
+        if (!sent)
+        {
+            m_connection_lost = true;
+        }
+        else if (is_frame)
+        {
+            m_stats->frames_sent++;
+        }
+    }
+
+    m_worker_done = true;
+    m_done_cv.notify_all();
+}
+
+// Game loop thread, the pending frame stays pending while the client has no room for it
+void FrameSender::flush_inline() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_pending_frame.has_value())
+    {
+        return;
+    }
+
+    const auto frame_tick = std::get<FrameSnapshot>(m_pending_frame->payload).timestamp;
+
+    if (m_latency_estimator != nullptr)
+    {
+        m_latency_estimator->record_ping(frame_tick, LatencyEstimator::now_usec());
+    }
+
+    if (m_transport.try_send_frame(*m_pending_frame, m_pending_ack))
+    {
+        m_pending_frame.reset();
+        m_stats->frames_sent++;
+    }
+
+    update_queue_depth();
+}
+
+// Requires m_mutex
+void FrameSender::update_queue_depth() {
+    const auto depth = static_cast<uint32_t>(
+        m_control_queue.size() + (m_pending_frame.has_value() ? 1 : 0) + (m_in_flight ? 1 : 0)
+    );
+
+    m_stats->send_queue_depth = depth;
+
+    if (depth > m_stats->max_send_queue_depth)
+    {
+        m_stats->max_send_queue_depth = depth;
+    }
+}
+
+void FrameSender::adapt_rate() {
+    if (++m_window_ticks < send_constants::RATE_WINDOW_TICKS)
+    {
+        return;
+    }
+
+    const uint64_t coalesced = m_stats->frames_coalesced.load();
+    const auto window_coalesced = coalesced - m_window_coalesced_base;
+
+    m_window_ticks = 0;
+    m_window_coalesced_base = coalesced;
+
+    auto new_level = m_rate_level;
+
+    if (window_coalesced >= send_constants::RATE_DOWNGRADE_COALESCED)
+    {
+        // The client can not keep up
+        m_clean_windows = 0;
+
+        if (m_rate_level + 1 < send_constants::SNAPSHOT_RATE_LEVELS)
+        {
+            new_level = m_rate_level + 1;
+        }
+    }
+    else if (window_coalesced == 0 && ++m_clean_windows >= send_constants::RATE_RECOVERY_WINDOWS)
+    {
+        // The client has been keeping up for a while
+        m_clean_windows = 0;
+
+        if (m_rate_level > 0)
+        {
+            new_level = m_rate_level - 1;
+        }
+    }
+
+    if (new_level != m_rate_level)
+    {
+        m_rate_level = new_level;
+
+        m_stats->snapshot_rate_hz = get_snapshot_rate_hz();
+        m_stats->rate_changes++;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <packet_template/packet_template.hpp>
+#include "instance_stats.hpp"
+#include "transport.hpp"
+#include "latency_estimator.hpp"
+
+/*
+    Send side of a single connection.
+
+    The game loop hands packets over and never blocks on the socket.
+    Control packets are queued in order and never dropped. A frame that is
+    still unsent when the next one arrives is replaced by the newer one.
+    While frames keep getting coalesced the snapshot rate is lowered
+    (60 -> 30 -> 20 Hz), and it recovers once the client keeps up again.
+
+    A transport that never blocks is sent to from the game loop itself,
+    without the send thread.
+
+    A failed send marks the connection lost and drops what is still pending.
+    stop() gives the send thread STOP_TIMEOUT_MSEC to flush; a client that
+    does not drain its socket for that long is disconnected, which fails the
+    blocked send, so stop() always returns.
+*/
+class FrameSender {
+public:
+    FrameSender(
+        Transport& transport,
+        std::shared_ptr<InstanceStats> stats,
+        LatencyEstimator* latency_estimator = nullptr    // Gets the send time of every frame
+    );
+    ~FrameSender();
+
+    void start();
+    void stop();    // Flushes the pending packets before joining the send thread
+
+    // A send failed or stop() had to cut the connection, the stream may end in the middle of a packet
+    bool is_connection_lost() const { return m_connection_lost; }
+
+    // Called once per tick, tells whether a frame should be produced for this tick
+    bool is_frame_due(uint64_t tick);
+
+    void send_frame(Packet packet, const FrameAck& ack);
+    void send_control(Packet packet);
+
+    uint32_t get_snapshot_rate_hz() const;
+
+private:
+    void sending_worker();
+    void update_queue_depth();
+    void adapt_rate();
+    void flush_inline();
+
+    Transport&                      m_transport;
+    const bool                      m_inline;
+    std::shared_ptr<InstanceStats>  m_stats;
+    LatencyEstimator*               m_latency_estimator;
+
+    // Pending packets
+    std::mutex                      m_mutex;
+    std::condition_variable         m_cv;
+    std::queue<Packet>              m_control_queue;
+    std::optional<Packet>           m_pending_frame;
+    FrameAck                        m_pending_ack;
+    bool                            m_in_flight;
+
+    std::atomic<bool>               m_running;
+    std::atomic<bool>               m_connection_lost;
+    std::thread                     m_worker;
+    bool                            m_worker_done;      // Signalled on m_done_cv
+    std::condition_variable         m_done_cv;
+
+    // Rate adaptation (game loop thread only)
+    size_t                          m_rate_level;
+    uint32_t                        m_window_ticks;
+    uint32_t                        m_clean_windows;
+    uint64_t                        m_window_coalesced_base;
+};
@@ -1,12 +1,42 @@
-#include <iostream>
+#include <algorithm>    // std::max
+#include <cstdio>       // std::rename
+
+#include <sys/socket.h>   // shutdown
 
 #include "game_server.hpp"
+#include "game_server_constants.hpp"
+#include "payload_limits.hpp"
+#include "diag_logger.hpp"
+#include "socket_transport.hpp"
+#include "../config_constants.hpp"
 
 GameServerMaster::GameServerMaster(uint16_t server_port, size_t max_instances)
     : m_ready_to_accept(false)
     , m_running(false)
     , m_max_instances(max_instances)
     , m_active_instances(0)
+    , m_parallel_bullet_threshold(SIZE_MAX)
+    , m_admission(
+        std::max(1u, std::thread::hardware_concurrency()),
+        admission_constants::TARGET_CPU_UTILIZATION,
+        max_instances,
+        std::chrono::milliseconds(admission_constants::UTILIZATION_WINDOW_MSEC),
+        admission_constants::DEFAULT_INSTANCE_LOAD
+    )
+    , m_rejected_instance_limit(0)
+    , m_rejected_cpu_budget(0)
+    , m_draining(false)
+    , m_handoff_listen_fd(-1)
+    , m_successor_fd(-1)
+    , m_predecessor_fd(-1)
+    , m_handoff_token{}
+    , m_overrun_policy(OverrunPolicy::CatchUp)
+    , m_collision_mode(CollisionMode::Discrete)
+    , m_receive_pool(
+        payload_limits::RECEIVE_BLOCK_SIZE,
+        max_instances * receive_constants::BLOCKS_PER_CONNECTION
+    )
+    , m_next_instance_id(0)
 {
     m_server_socket = std::make_shared<ServerSocket>(
         server_port
@@ -24,9 +54,16 @@ bool GameServerMaster::initialize() {
 void GameServerMaster::run() {
     if (!m_running)
     {
-        std::cout << "[GameServerMaster] DEBUG: Game server has been started" << "\n";
+        DIAG_DEBUG("GameServerMaster", "Game server has been started");
 
         m_running = true;
+
+        // Sessions handed over by the predecessor
+        if (has_predecessor())
+        {
+            m_adopt_thread = std::thread(&GameServerMaster::adopt_loop, this);
+        }
+
         accept_loop();
     }
 }
@@ -35,12 +72,53 @@ void GameServerMaster::run_async() {
     if (!m_running)
     {
         m_running = true;
+
+        // Sessions handed over by the predecessor
+        if (has_predecessor())
+        {
+            m_adopt_thread = std::thread(&GameServerMaster::adopt_loop, this);
+        }
+
         m_accept_thread = std::thread(&GameServerMaster::accept_loop, this);
 
-        std::cout << "[GameServerMaster] DEBUG: Accept thread has been created" << "\n";
+        DIAG_DEBUG("GameServerMaster", "Accept thread has been created");
+    }
+}
+
+void GameServerMaster::run_local() {
+    if (!m_running)
+    {
+        m_running = true;
+
+        DIAG_DEBUG("GameServerMaster", "Game server has been started without a listening socket");
     }
 }
 
+std::shared_ptr<LocalClient> GameServerMaster::connect_local() {
+    if (!m_running)
+    {
+        return nullptr;
+    }
+
+    uint64_t instance_id = 0;
+    double projected = 0.0;
+    const auto admission = admit_instance(instance_id, projected);
+
+    if (admission != AdmissionResult::Accepted)
+    {
+        DIAG_DEBUG("GameServerMaster", "The local client has been refused"
+                                       << " (reason: " << admission_result_str(admission)
+                                       << ", projected utilization: " << projected << " cores)");
+
+        return nullptr;
+    }
+
+    auto [transport, client] = make_local_connection();
+    spawn_instance(transport, instance_id, nullptr);
+
+    return client;
+}
+
 void GameServerMaster::stop() {
     if (m_running)
     {
@@ -53,9 +131,49 @@ void GameServerMaster::stop() {
         { 
             m_accept_thread.join();
 
-            std::cout << "[GameServerMaster] DEBUG: Accept thread has been joined" << "\n";
+            DIAG_DEBUG("GameServerMaster", "Accept thread has been joined");
+        }
+    }
+
+    if (m_checkpointer)
+    {
+        m_checkpointer->stop();
+    }
+
+    // Unblock and join the migration threads, which close the descriptors under the same mutex
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+        if (m_handoff_listen_fd >= 0)
+        {
+            shutdown(m_handoff_listen_fd, SHUT_RDWR);
+        }
+    }
+
+    if (m_handoff_thread.joinable())
+    {
+        m_handoff_thread.join();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+        if (m_predecessor_fd >= 0)
+        {
+            shutdown(m_predecessor_fd, SHUT_RDWR);
         }
     }
+
+    if (m_adopt_thread.joinable())
+    {
+        m_adopt_thread.join();
+    }
+}
+
+bool GameServerMaster::has_predecessor() {
+    std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+    return m_predecessor_fd >= 0;
 }
 
 bool GameServerMaster::wait_for_accept_ready(size_t timeout_msec, size_t max_attempts) {
@@ -79,21 +197,188 @@ bool GameServerMaster::wait_for_accept_ready(size_t timeout_msec, size_t max_att
     }
 }
 
+void GameServerMaster::enable_parallel_bullets(size_t worker_count, size_t bullet_threshold) {
+    if (m_running)
+    {
+        DIAG_ERROR("GameServerMaster", "The parallel bullet pass must be enabled before running");
+
+        return;
+    }
+
+    // The instance thread takes part in the work as well
+    if (worker_count == 0)
+    {
+        const auto hardware_threads = std::thread::hardware_concurrency();
+        worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+    }
+
+    m_worker_pool = std::make_shared<WorkerPool>(worker_count);
+    m_parallel_bullet_threshold = bullet_threshold;
+
+    DIAG_DEBUG("GameServerMaster", "Parallel bullet pass enabled with " << worker_count << " workers"
+                                   << " above " << bullet_threshold << " bullets");
+}
+
+void GameServerMaster::enable_crash_checkpoints(const std::string& path, int64_t interval_msec) {
+    if (m_running)
+    {
+        DIAG_ERROR("GameServerMaster", "Crash checkpoints must be enabled before running");
+
+        return;
+    }
+
+    m_checkpointer = std::make_unique<CrashCheckpointer>(path, interval_msec);
+
+    // What the previous run left behind, the first checkpoint of this run would replace it
+    std::vector<CheckpointEntry> entries;
+    uint64_t written_unix_msec = 0;
+
+    if (read_checkpoint(path, entries, written_unix_msec))
+    {
+        std::lock_guard<std::mutex> lock(m_recovered_mutex);
+
+        for (const auto& entry : entries)
+        {
+            auto session = std::make_unique<GameSession>(0, m_stage_timeline);
+            StateReader reader(entry.state);
+
+            if (!session->deserialize(reader))
+            {
+                DIAG_ERROR("GameServerMaster", "Session of instance " << entry.instance_id << " could not be restored");
+
+                continue;
+            }
+
+            // Kept in the checkpoints, a second crash before the client is back does not lose it
+            const auto key = session->get_resume_token().instance_id;
+            auto slot = m_checkpointer->add_session(entry.instance_id, *session);
+
+            m_recovered_sessions.emplace(key, RecoveredSession{ std::move(session), std::move(slot) });
+        }
+
+        m_recovered_deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(checkpoint_constants::RESUME_WINDOW_MSEC);
+
+        const auto recovered_path = path + ".recovered";
+        std::rename(path.c_str(), recovered_path.c_str());
+
+        DIAG_INFO("GameServerMaster", m_recovered_sessions.size() << " of " << entries.size() << " sessions of the previous run "
+                                      << "have been restored (written at " << written_unix_msec << " unix msec), "
+                                      << "the checkpoint has been moved to " << recovered_path);
+    }
+
+    m_checkpointer->start();
+
+    DIAG_DEBUG("GameServerMaster", "Crash checkpoints enabled every " << interval_msec << " msec to " << path);
+}
+
+std::vector<InstanceStatsSnapshot> GameServerMaster::get_instance_stats() {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+    std::vector<InstanceStatsSnapshot> snapshots;
+    snapshots.reserve(m_instance_stats.size());
+
+    for (const auto& [instance_id, stats] : m_instance_stats)
+    {
+        snapshots.push_back(take_snapshot(instance_id, *stats));
+    }
+
+    return snapshots;
+}
+
+void GameServerMaster::set_cpu_capacity(double cpu_capacity) {
+    std::lock_guard<std::mutex> lock(m_admission_mutex);
+
+    m_admission.set_cpu_capacity(cpu_capacity);
+}
+
+double GameServerMaster::get_cpu_utilization() {
+    std::lock_guard<std::mutex> lock(m_admission_mutex);
+
+    return m_admission.get_utilization();
+}
+
+uint64_t GameServerMaster::get_rejection_count(AdmissionResult reason) const {
+    switch (reason)
+    {
+        case AdmissionResult::InstanceLimit:    return m_rejected_instance_limit;
+        case AdmissionResult::CpuBudget:        return m_rejected_cpu_budget;
+        default:                                return 0;
+    }
+}
+
+size_t GameServerMaster::get_recovered_sessions() {
+    std::lock_guard<std::mutex> lock(m_recovered_mutex);
+
+    return m_recovered_sessions.size();
+}
+
+std::unique_ptr<GameSession> GameServerMaster::take_recovered_session(const ResumeToken& token) {
+    std::lock_guard<std::mutex> lock(m_recovered_mutex);
+
+    // Past the window, the clients that are not back yet are not coming back
+    if (!m_recovered_sessions.empty() && std::chrono::steady_clock::now() > m_recovered_deadline)
+    {
+        DIAG_DEBUG("GameServerMaster", m_recovered_sessions.size() << " restored sessions have not been resumed in time");
+
+        for (const auto& [instance_id, recovered] : m_recovered_sessions)
+        {
+            m_checkpointer->remove_session(recovered.checkpoint_slot);
+        }
+
+        m_recovered_sessions.clear();
+    }
+
+    // Instance ids are unique within one process only, the secret tells the sessions apart
+    const auto [first, last] = m_recovered_sessions.equal_range(token.instance_id);
+
+    for (auto it = first; it != last; ++it)
+    {
+        if (it->second.session->get_resume_token() == token)
+        {
+            // From now on the instance registers it
+            m_checkpointer->remove_session(it->second.checkpoint_slot);
+
+            auto session = std::move(it->second.session);
+            m_recovered_sessions.erase(it);
+
+            return session;
+        }
+    }
+
+    return nullptr;
+}
+
+CheckpointStats GameServerMaster::get_checkpoint_stats() {
+    return m_checkpointer ? m_checkpointer->get_stats() : CheckpointStats{};
+}
+
+void GameServerMaster::report_tick_busy(uint64_t instance_id, AdmissionController::Duration busy) {
+    std::lock_guard<std::mutex> lock(m_admission_mutex);
+
+    m_admission.record_busy(instance_id, busy, AdmissionController::Clock::now());
+}
+
 void GameServerMaster::accept_loop() {
     m_ready_to_accept = true;
 
-    while (m_running)
+    while (m_running && !m_draining)
     {
-        std::cerr << "[GameServerMaster] DEBUG: Now accept will block this thread" << "\n";
+        DIAG_DEBUG("GameServerMaster", "Now accept will block this thread");
 
         // Block until the client to connect
         auto client_opt = m_server_socket->accept_client();
 
-        std::cerr << "[GameServerMaster] DEBUG: Thread is back from accept" << "\n";
+        DIAG_DEBUG("GameServerMaster", "Thread is back from accept");
+
+        // The listening socket has been closed for the successor
+        if (m_draining)
+        {
+            break;
+        }
 
         if (!client_opt.has_value())
         {
-            std::cerr << "[GameServerMaster] ERROR: Invalid connection attempt from the client" << "\n";
+            DIAG_ERROR("GameServerMaster", "Invalid connection attempt from the client");
 
             continue;
         }
@@ -102,32 +387,103 @@ void GameServerMaster::accept_loop() {
             std::move(client_opt.value())
         );
 
-        std::cout << "[GameServerMaster] DEBUG: client_conn accepted" << "\n";
-        
-        auto current = m_active_instances.load();
+        DIAG_DEBUG("GameServerMaster", "client_conn accepted");
 
-        // CAS (Compare-And-Swap)
-        if (m_active_instances >= m_max_instances || !m_active_instances.compare_exchange_strong(current, current + 1))
+        uint64_t instance_id = 0;
+        double projected = 0.0;
+        const auto admission = admit_instance(instance_id, projected);
+
+        if (admission != AdmissionResult::Accepted)
         {
-            std::cerr << "[GameServerMaster] DEBUG: The maximum number of instances has been reached"
-                      << " and the client connection has been refused." << "\n";
+            DIAG_DEBUG("GameServerMaster", "The client connection has been refused"
+                                           << " (reason: " << admission_result_str(admission)
+                                           << ", projected utilization: " << projected << " cores)");
 
             client_conn->disconnect();
 
             continue;
         }
 
-        // Create thread
-        auto worker_thread = std::thread([this, client_conn]() {
-            handle_client(client_conn);
-            m_active_instances.fetch_sub(1);
-        });
-            
-        worker_thread.detach();
+        spawn_instance(std::make_shared<SocketTransport>(client_conn, m_receive_pool), instance_id, nullptr);
+    }
 
-        std::cout << "[GameServerMaster] DEBUG: Game Instance has been created" << "\n"
-                  << "[GameServerMaster] DEBUG: " << m_active_instances << " instances are active" << "\n";
+    // Wait for the live sessions to be handed over
+    if (m_draining)
+    {
+        finish_handoff();
     }
 
     m_ready_to_accept = false;
 }
+
+// Admits the new instance only while the CPU budget allows it
+AdmissionResult GameServerMaster::admit_instance(uint64_t& instance_id, double& projected) {
+    auto admission = AdmissionResult::Accepted;
+
+    {
+        std::lock_guard<std::mutex> lock(m_admission_mutex);
+
+        admission = m_admission.try_admit();
+        projected = m_admission.get_projected_utilization();
+
+        if (admission == AdmissionResult::Accepted)
+        {
+            instance_id = m_next_instance_id++;
+            m_admission.add_instance(instance_id, AdmissionController::Clock::now());
+        }
+    }
+
+    if (admission == AdmissionResult::InstanceLimit)
+    {
+        m_rejected_instance_limit++;
+    }
+    else if (admission == AdmissionResult::CpuBudget)
+    {
+        m_rejected_cpu_budget++;
+    }
+
+    return admission;
+}
+
+void GameServerMaster::spawn_instance(
+    std::shared_ptr<Transport> transport,
+    uint64_t instance_id,
+    std::unique_ptr<GameSession> session
+) {
+    m_active_instances.fetch_add(1);
+
+    // Register the stats of the new instance
+    auto stats = std::make_shared<InstanceStats>();
+
+    {
+        std::lock_guard<std::mutex> lock(m_stats_mutex);
+        m_instance_stats.emplace(instance_id, stats);
+    }
+
+    // Create thread
+    auto worker_thread = std::thread([this, transport, stats, instance_id, session = std::move(session)]() mutable {
+        handle_client(transport, instance_id, stats, std::move(session));
+
+        {
+            std::lock_guard<std::mutex> lock(m_stats_mutex);
+            m_instance_stats.erase(instance_id);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_admission_mutex);
+            m_admission.remove_instance(instance_id);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_instances_mutex);
+            m_active_instances.fetch_sub(1);
+        }
+
+        m_instances_cv.notify_all();
+    });
+
+    worker_thread.detach();
+
+    DIAG_DEBUG("GameServerMaster", "Game Instance has been created");
+    DIAG_DEBUG("GameServerMaster", m_active_instances << " instances are active");
+}
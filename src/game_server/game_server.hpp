@@ -4,7 +4,23 @@
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <string>
 #include <socket/socket.hpp>
+#include "instance_stats.hpp"
+#include "worker_pool.hpp"
+#include "admission_controller.hpp"
+#include "game_session.hpp"
+#include "receive_buffer_pool.hpp"
+#include "frame_pacer.hpp"
+#include "transport.hpp"
+#include "local_transport.hpp"
+#include "crash_checkpoint.hpp"
+#include "session_handoff.hpp"
 
 class GameServerMaster {
 public:
@@ -14,12 +30,70 @@ public:
     bool initialize();
     void run();
     void run_async();   // It's useful if you want to run the server in the same process as the client
+    void run_local();   // Embedded mode without the listening socket, instances only come from connect_local()
     void stop();
     bool wait_for_accept_ready(size_t timeout_msec, size_t max_attempts);
 
+    // Splits the bullet pass of instances with at least `bullet_threshold` bullets across a shared pool
+    void enable_parallel_bullets(size_t worker_count, size_t bullet_threshold);
+
+    // A game instance for a client in this process, nullptr if it is not admitted. Requires one of the run functions
+    std::shared_ptr<LocalClient> connect_local();
+
+    // Session migration, see session_migration.cpp
+    bool enable_session_handoff(const std::string& path);   // Lets a successor process take the live sessions over
+    bool take_over(const std::string& path);                // Asks the server listening at `path` for its sessions
+
+    // Checkpoints the live sessions to `path` periodically. The sessions of a checkpoint left by the
+    // previous run are restored, to be resumed by their clients, and the file is moved aside to
+    // `path`.recovered. Call after set_stage_timeline() and before run()
+    void enable_crash_checkpoints(const std::string& path, int64_t interval_msec = checkpoint_constants::INTERVAL_MSEC);
+
+    // Cores the admission control plans with, all of the host by default
+    void set_cpu_capacity(double cpu_capacity);
+
+    // Stage of every new instance, the default stage if not set. Call before run()
+    void set_stage_timeline(std::shared_ptr<const StageTimeline> timeline) { m_stage_timeline = std::move(timeline); }
+
+    // What the instances send for the ticks they run late, catch up by default. Call before run()
+    void set_overrun_policy(OverrunPolicy policy) { m_overrun_policy = policy; }
+
+    // How the instances collide bullets with the player, discrete by default. Call before run()
+    void set_collision_mode(CollisionMode mode) { m_collision_mode = mode; }
+
+    // Monitoring
+    size_t get_active_instances() const { return m_active_instances; }
+    size_t get_recovered_sessions();    // Restored from the checkpoint, not resumed yet
+    std::vector<InstanceStatsSnapshot> get_instance_stats();
+    double get_cpu_utilization();   // In cores, summed over the instances
+    uint64_t get_rejection_count(AdmissionResult reason) const;
+    CheckpointStats get_checkpoint_stats();
+
 private:
     void accept_loop();
-    void handle_client(std::shared_ptr<ClientConnection> client_conn);
+    AdmissionResult admit_instance(uint64_t& instance_id, double& projected);
+    void spawn_instance(
+        std::shared_ptr<Transport> transport,
+        uint64_t instance_id,
+        std::unique_ptr<GameSession> session
+    );
+    void handle_client(
+        std::shared_ptr<Transport> transport,
+        uint64_t instance_id,
+        std::shared_ptr<InstanceStats> stats,
+        std::unique_ptr<GameSession> session    // nullptr: new game, handshake first
+    );
+    void report_tick_busy(uint64_t instance_id, AdmissionController::Duration busy);
+
+    // Crash recovery, nullptr if no restored session matches the token
+    std::unique_ptr<GameSession> take_recovered_session(const ResumeToken& token);
+
+    // Session migration
+    void handoff_loop();
+    void adopt_loop();
+    bool has_predecessor();
+    bool hand_off_session(int client_fd, const GameSession& session);
+    void finish_handoff();
 
     std::shared_ptr<ServerSocket>   m_server_socket;
     std::atomic<bool>               m_running;
@@ -27,4 +101,53 @@ private:
     std::thread                     m_accept_thread;
     size_t                          m_max_instances;
     std::atomic<size_t>             m_active_instances;
+    std::mutex                      m_instances_mutex;      // Signals m_instances_cv when an instance ends
+    std::condition_variable         m_instances_cv;
+
+    // Parallel bullet pass
+    std::shared_ptr<WorkerPool>     m_worker_pool;
+    size_t                          m_parallel_bullet_threshold;
+
+    // Admission based on the measured CPU headroom
+    std::mutex                      m_admission_mutex;
+    AdmissionController             m_admission;
+    std::atomic<uint64_t>           m_rejected_instance_limit;
+    std::atomic<uint64_t>           m_rejected_cpu_budget;
+
+    // Session migration
+    std::atomic<bool>               m_draining;
+    std::mutex                      m_handoff_mutex;    // Guards the three descriptors below
+    int                             m_handoff_listen_fd;
+    int                             m_successor_fd;
+    int                             m_predecessor_fd;
+    HandoffToken                    m_handoff_token;    // Set before the handoff thread starts
+    std::thread                     m_handoff_thread;
+    std::thread                     m_adopt_thread;
+
+    // Crash recovery, nullptr if not enabled
+    std::unique_ptr<CrashCheckpointer>  m_checkpointer;
+
+    // Sessions of the previous run until their clients resume them. They stay in the checkpoints
+    // meanwhile, the first resume request after the resume window drops the rest
+    struct RecoveredSession {
+        std::unique_ptr<GameSession>                session;
+        std::shared_ptr<CrashCheckpointer::Slot>    checkpoint_slot;
+    };
+
+    std::mutex                                                  m_recovered_mutex;
+    std::unordered_multimap<uint64_t, RecoveredSession>         m_recovered_sessions;   // By ResumeToken::instance_id
+    std::chrono::steady_clock::time_point                       m_recovered_deadline;
+
+    // Compiled once, shared read only by the instances
+    std::shared_ptr<const StageTimeline>    m_stage_timeline;
+    OverrunPolicy                           m_overrun_policy;
+    CollisionMode                           m_collision_mode;
+
+    // Receive buffers of all connections, allocated up front
+    ReceiveBufferPool               m_receive_pool;
+
+    // Live stats of the active instances
+    std::mutex                                                      m_stats_mutex;
+    uint64_t                                                        m_next_instance_id;
+    std::unordered_map<uint64_t, std::shared_ptr<InstanceStats>>    m_instance_stats;
 };
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
+#include <iterator>   // std::size
 
 namespace math_constants {
     constexpr double PI         = 3.14159265358979323846;
@@ -16,6 +18,7 @@ namespace game_constants {
     constexpr float GAME_HEIGHT             = 448.0f;
     constexpr float GAME_WIDTH_HALF         = GAME_WIDTH / 2.0f;
     constexpr float GAME_HEIGHT_HALF        = GAME_HEIGHT / 2.0f;
+    constexpr uint32_t TARGET_FPS           = 60;
 
     /*
         Player configuration
@@ -45,3 +48,124 @@ namespace game_constants {
     // Wedge bullet
     constexpr float ENEMY_WEDGE_BULLET_RADIUS = 10.0f;
 }
+
+namespace bullet_constants {
+    // Bullets per chunk when the bullet pass runs on the worker pool
+    constexpr size_t PARALLEL_CHUNK_SIZE = 4096;
+
+    // Ticks of the expiry wheel, bullets leaving later are filed at its end and estimated again
+    constexpr uint64_t EXPIRY_WHEEL_TICKS = 256;
+
+    // Bound on the rounding error one tick of float integration adds to a position (of magnitude < 2048)
+    constexpr double EXPIRY_POSITION_ERROR = 1.0 / 8192;
+
+    // Slots reserved up front, more than the largest pooled block so growing never fills a pool chunk
+    constexpr size_t EXPIRY_RESERVED_SLOTS = 512;
+}
+
+namespace send_constants {
+    /*
+        Snapshot rate adaptation
+        A frame is sent every N ticks, where N is picked from the divisors below (60, 30, 20 Hz).
+    */
+    constexpr uint32_t SNAPSHOT_RATE_DIVISORS[]     = { 1, 2, 3 };
+    constexpr size_t   SNAPSHOT_RATE_LEVELS         = std::size(SNAPSHOT_RATE_DIVISORS);
+
+    // Number of ticks the send side is observed before the rate is reconsidered
+    constexpr uint32_t RATE_WINDOW_TICKS            = 60;
+
+    // How long stop() waits for the send thread to flush before the connection is cut
+    constexpr uint32_t STOP_TIMEOUT_MSEC            = 500;
+
+    // Coalesced frames within a window that make the rate go down
+    constexpr uint32_t RATE_DOWNGRADE_COALESCED     = 2;
+
+    // Clean windows in a row that make the rate go up again
+    constexpr uint32_t RATE_RECOVERY_WINDOWS        = 3;
+}
+
+namespace receive_constants {
+    /*
+        Receive budget of a connection
+        Payloads are read into blocks of a pool allocated up front, see payload_limits.hpp for their size.
+    */
+    constexpr size_t   BLOCKS_PER_CONNECTION        = 1;
+    constexpr size_t   MAX_QUEUED_PACKETS           = 64;       // Decoded packets waiting for the game loop
+    constexpr int      POLL_TIMEOUT_MSEC            = 100;
+    constexpr int      STOP_GRACE_POLLS             = 10;       // Idle polls a packet may take to complete after stop()
+}
+
+namespace latency_constants {
+    // A round trip sample is taken at most every N ticks of echoed frames
+    constexpr uint64_t PING_INTERVAL_TICKS          = 30;
+
+    // Send times of the most recent frames, an echo of an older one is ignored
+    constexpr size_t   PING_HISTORY                 = 128;
+}
+
+namespace memory_constants {
+    // A session is ended once it holds more than this, including its frame
+    constexpr size_t   SESSION_MEMORY_CAP           = 64 * 1024 * 1024;
+
+    // Per-tick scratch that never touches the heap in a normal tick
+    constexpr size_t   SCRATCH_BLOCK_BYTES          = 16 * 1024;
+}
+
+namespace stage_constants {
+    // Limits a stage file is validated against
+    constexpr uint32_t MAX_PATTERN_BULLETS          = 256;
+    constexpr uint64_t MAX_START_TICK               = 60 * 60 * 30;     // 30 minutes
+    constexpr uint64_t MAX_LOOP_TICKS               = 60 * 60 * 10;     // Schedule size bound
+}
+
+namespace pacing_constants {
+    // Busy waits the last part of every tick instead of sleeping, 0 to always sleep
+    constexpr int64_t  SPIN_NSEC                    = 0;
+
+    /*
+        Missed ticks run on the next wake up, beyond these they are dropped
+        Catching up sends a frame for each of them, so it stays a short burst (100ms).
+        Skipping sends only the latest frame and simulates the missed ticks up to a safety cap (10s).
+    */
+    constexpr uint32_t MAX_CATCH_UP_TICKS           = 6;
+    constexpr uint32_t MAX_SKIP_TICKS               = 600;
+}
+
+namespace local_transport_constants {
+    // Queue sizes of an in process connection, the inputs of a few ticks and a couple of frames
+    constexpr size_t   TO_SERVER_CAPACITY           = 64;
+    constexpr size_t   TO_CLIENT_CAPACITY           = 4;
+}
+
+namespace batch_env_constants {
+    // Instances one task of the worker pool steps, large enough to amortize the hand off
+    constexpr size_t   INSTANCES_PER_CHUNK          = 32;
+
+    // Rows of the observation buffers per instance, the closest bullets are kept beyond it
+    constexpr size_t   MAX_OBSERVED_ENEMIES         = 16;
+    constexpr size_t   MAX_OBSERVED_BULLETS         = 256;
+}
+
+namespace diag_log_constants {
+    // How often the background thread writes the buffered lines out
+    constexpr int64_t  FLUSH_INTERVAL_MSEC          = 50;
+
+    // Lines a thread may have waiting, more are dropped and counted instead of blocking it
+    constexpr size_t   THREAD_BUFFER_BYTES          = 64 * 1024;
+
+    // Lines one logging statement may write per window, the rest are summed up once per window
+    constexpr int64_t  RATE_WINDOW_MSEC             = 1000;
+    constexpr uint32_t RATE_LIMIT_PER_WINDOW        = 10;
+}
+
+namespace checkpoint_constants {
+    // How often the live sessions are written out for crash recovery
+    constexpr int64_t  INTERVAL_MSEC                = 5000;
+
+    // Checkpoint file, the version changes with its layout
+    constexpr uint32_t FILE_MAGIC                   = 0x50434842;       // "BHCP"
+    constexpr uint32_t FILE_VERSION                 = 1;
+
+    // How long the sessions of the previous run wait for their clients to resume them
+    constexpr int64_t  RESUME_WINDOW_MSEC           = 5 * 60 * 1000;
+}
@@ -0,0 +1,353 @@
+#include "game_server_supervisor.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <algorithm>    // std::max
+#include <utility>
+#include <stdexcept>
+#include <new>
+#include <csignal>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "diag_logger.hpp"
+#include "../config_constants.hpp"
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+namespace {
+    volatile std::sig_atomic_t s_stop_requested = 0;
+
+    void handle_stop_signal(int) {
+        s_stop_requested = 1;
+    }
+
+    std::vector<std::vector<int>> read_numa_nodes() {
+        std::vector<std::vector<int>> nodes;
+
+        for (int node = 0; ; node++)
+        {
+            std::ifstream ifs("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+
+            if (!ifs)
+            {
+                break;
+            }
+
+            std::string cpu_list;
+            std::getline(ifs, cpu_list);
+
+            nodes.push_back(GameServerSupervisor::parse_cpu_list(cpu_list));
+        }
+
+        return nodes;
+    }
+
+    void describe_exit(std::ostream& os, int status) {
+        if (WIFSIGNALED(status))
+        {
+            os << "killed by signal " << WTERMSIG(status);
+        }
+        else if (WIFEXITED(status))
+        {
+            os << "exited with code " << WEXITSTATUS(status);
+        }
+        else
+        {
+            os << "stopped";
+        }
+    }
+}
+
+// "0-3,8-11" -> { 0, 1, 2, 3, 8, 9, 10, 11 }
+std::vector<int> GameServerSupervisor::parse_cpu_list(const std::string& cpu_list) {
+    std::vector<int> cpus;
+    std::stringstream ss(cpu_list);
+    std::string range;
+
+    while (std::getline(ss, range, ','))
+    {
+        if (range.empty())
+        {
+            continue;
+        }
+
+        const auto dash = range.find('-');
+
+        try
+        {
+            const int first = std::stoi(range.substr(0, dash));
+            const int last  = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+            for (int cpu = first; cpu <= last; cpu++)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        catch (const std::exception&)
+        {
+            std::cerr << "[GameServerSupervisor] ERROR: Invalid cpu list: " << cpu_list << "\n";
+        }
+    }
+
+    return cpus;
+}
+
+GameServerSupervisor::GameServerSupervisor(size_t worker_count, bool pin_numa)
+    : GameServerSupervisor(worker_count, pin_numa ? read_numa_nodes() : std::vector<std::vector<int>>())
+{
+    if (pin_numa && m_numa_cpus.empty())
+    {
+        std::cerr << "[GameServerSupervisor] ERROR: No NUMA node found, workers will not be pinned" << "\n";
+    }
+}
+
+GameServerSupervisor::GameServerSupervisor(size_t worker_count, std::vector<std::vector<int>> numa_cpus)
+    : m_worker_count(std::max<size_t>(worker_count, 1))
+    , m_pin_numa(!numa_cpus.empty())
+    , m_numa_cpus(std::move(numa_cpus))
+    , m_slots(nullptr)
+    , m_restart_at(m_worker_count)
+{
+    // The workers write their counters here
+    void* mapping = mmap(
+        nullptr,
+        sizeof(WorkerSlot) * m_worker_count,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS,
+        -1,
+        0
+    );
+
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("[GameServerSupervisor] Failed to map the worker slots");
+    }
+
+    m_slots = static_cast<WorkerSlot*>(mapping);
+
+    for (size_t i = 0; i < m_worker_count; i++)
+    {
+        new (&m_slots[i]) WorkerSlot{};
+        m_slots[i].pid = -1;
+    }
+}
+
+GameServerSupervisor::~GameServerSupervisor() {
+    stop_workers();
+
+    if (m_slots != nullptr)
+    {
+        munmap(m_slots, sizeof(WorkerSlot) * m_worker_count);
+    }
+}
+
+int GameServerSupervisor::run(const WorkerMain& worker_main) {
+    s_stop_requested = 0;
+    std::signal(SIGINT, handle_stop_signal);
+    std::signal(SIGTERM, handle_stop_signal);
+
+    for (size_t i = 0; i < m_worker_count; i++)
+    {
+        spawn_worker(i, worker_main);
+    }
+
+    uint64_t last_total = 0;
+
+    while (!s_stop_requested)
+    {
+        // Reap the workers that went down
+        int status = 0;
+        pid_t pid = 0;
+
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0)
+        {
+            for (size_t i = 0; i < m_worker_count; i++)
+            {
+                if (m_slots[i].pid != pid)
+                {
+                    continue;
+                }
+
+                std::cerr << "[GameServerSupervisor] ERROR: Worker " << i << " (pid " << pid << ") ";
+                describe_exit(std::cerr, status);
+                std::cerr << ", " << m_slots[i].active_instances << " games lost" << "\n";
+
+                m_slots[i].pid = -1;
+                m_slots[i].active_instances = 0;
+                m_slots[i].restarts++;
+                m_restart_at[i] = std::chrono::steady_clock::now()
+                                + std::chrono::milliseconds(supervisor_constants::WORKER_RESTART_DELAY_MSEC);
+            }
+        }
+
+        // Restart them once the delay is over
+        const auto now = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < m_worker_count; i++)
+        {
+            if (m_slots[i].pid == -1 && now >= m_restart_at[i] && !s_stop_requested)
+            {
+                spawn_worker(i, worker_main);
+            }
+        }
+
+        const auto total = get_total_instances();
+
+        if (total != last_total)
+        {
+            std::cout << "[GameServerSupervisor] DEBUG: " << total << " instances are active"
+                      << " across " << m_worker_count << " workers" << "\n";
+
+            last_total = total;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(supervisor_constants::POLL_INTERVAL_MSEC));
+    }
+
+    std::cout << "[GameServerSupervisor] DEBUG: Stop requested" << "\n";
+
+    stop_workers();
+
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    return 0;
+}
+
+bool GameServerSupervisor::stop_requested() {
+    return s_stop_requested != 0;
+}
+
+uint64_t GameServerSupervisor::get_total_instances() const {
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < m_worker_count; i++)
+    {
+        total += m_slots[i].active_instances;
+    }
+
+    return total;
+}
+
+double GameServerSupervisor::get_worker_cpu_capacity(size_t worker_index) const {
+    if (m_pin_numa && !m_numa_cpus.empty())
+    {
+        // Workers pinned to the same node share its CPUs
+        const auto node_count = m_numa_cpus.size();
+        const auto node = worker_index % node_count;
+        const auto workers_on_node = m_worker_count / node_count + (node < m_worker_count % node_count ? 1 : 0);
+
+        return static_cast<double>(m_numa_cpus[node].size()) / workers_on_node;
+    }
+
+    const auto hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    return static_cast<double>(hardware_threads) / m_worker_count;
+}
+
+pid_t GameServerSupervisor::spawn_worker(size_t worker_index, const WorkerMain& worker_main) {
+    const pid_t pid = fork();
+
+    if (pid < 0)
+    {
+        std::cerr << "[GameServerSupervisor] ERROR: Failed to fork worker " << worker_index << "\n";
+
+        m_restart_at[worker_index] = std::chrono::steady_clock::now()
+                                   + std::chrono::milliseconds(supervisor_constants::WORKER_RESTART_DELAY_MSEC);
+
+        return pid;
+    }
+
+    if (pid == 0)
+    {
+        // Worker process, stops on its own once asked so the diagnostics are written out
+        s_stop_requested = 0;
+        std::signal(SIGINT, handle_stop_signal);
+        std::signal(SIGTERM, handle_stop_signal);
+
+        if (m_pin_numa)
+        {
+            pin_worker(worker_index);
+        }
+
+        const auto exit_code = worker_main(worker_index, m_slots[worker_index]);
+
+        // _Exit() skips the exit handlers that write the queued diagnostics out
+        DiagLogger::instance().flush();
+        std::cout.flush();
+        std::cerr.flush();
+        std::_Exit(exit_code);
+    }
+
+    m_slots[worker_index].pid = pid;
+
+    std::cout << "[GameServerSupervisor] DEBUG: Worker " << worker_index << " has been started (pid " << pid << ")" << "\n";
+
+    return pid;
+}
+
+// Runs in the worker process
+void GameServerSupervisor::pin_worker(size_t worker_index) const {
+#if defined(__linux__)
+    if (m_numa_cpus.empty())
+    {
+        return;
+    }
+
+    const auto node = worker_index % m_numa_cpus.size();
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    for (const auto cpu : m_numa_cpus[node])
+    {
+        CPU_SET(cpu, &cpu_set);
+    }
+
+    if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) != 0)
+    {
+        std::cerr << "[GameServerSupervisor] ERROR: Failed to pin worker " << worker_index << " to node " << node << "\n";
+    }
+
+    // Prefer the memory of the same node
+    unsigned long node_mask = 1UL << node;
+
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, &node_mask, sizeof(node_mask) * 8) != 0)
+    {
+        std::cerr << "[GameServerSupervisor] ERROR: Failed to set the memory policy of worker " << worker_index << "\n";
+    }
+#else
+    static_cast<void>(worker_index);
+#endif
+}
+
+void GameServerSupervisor::stop_workers() {
+    for (size_t i = 0; i < m_worker_count; i++)
+    {
+        const pid_t pid = m_slots[i].pid;
+
+        if (pid > 0)
+        {
+            kill(pid, SIGTERM);
+        }
+    }
+
+    for (size_t i = 0; i < m_worker_count; i++)
+    {
+        const pid_t pid = m_slots[i].pid;
+
+        if (pid > 0)
+        {
+            waitpid(pid, nullptr, 0);
+            m_slots[i].pid = -1;
+        }
+    }
+}
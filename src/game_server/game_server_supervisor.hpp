@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+// Lives in memory shared between the supervisor and the workers
+struct WorkerSlot {
+    std::atomic<int32_t>    pid;
+    std::atomic<uint64_t>   active_instances;
+    std::atomic<uint64_t>   restarts;
+};
+
+/*
+    Runs the game server as N forked worker processes.
+
+    The listening socket is bound once by the supervisor and inherited by every
+    worker, the kernel hands each incoming connection to one of the workers
+    blocked in accept. A crashing worker only takes its own games down, it is
+    restarted on the same socket after a short delay. Workers can be pinned to
+    the CPUs of a NUMA node (round robin over the nodes).
+
+    The supervisor stops a worker with SIGTERM, the worker main is expected to
+    return once stop_requested() is true so the worker exits cleanly.
+
+    Fork before any thread is started, the workers start their own threads.
+*/
+class GameServerSupervisor {
+public:
+    // Runs inside the worker process, its return value is the exit code of the worker
+    using WorkerMain = std::function<int(size_t worker_index, WorkerSlot& slot)>;
+
+    GameServerSupervisor(size_t worker_count, bool pin_numa);
+    GameServerSupervisor(size_t worker_count, std::vector<std::vector<int>> numa_cpus);  // Pinned to the given nodes
+    ~GameServerSupervisor();
+
+    GameServerSupervisor(const GameServerSupervisor&) = delete;
+    GameServerSupervisor& operator=(const GameServerSupervisor&) = delete;
+
+    // Blocks until SIGINT / SIGTERM, then stops the workers
+    int run(const WorkerMain& worker_main);
+
+    uint64_t get_total_instances() const;
+    double get_worker_cpu_capacity(size_t worker_index) const;  // Cores a worker should plan with
+
+    // In a worker, true once SIGTERM / SIGINT asked it to stop
+    static bool stop_requested();
+
+    // "0-3,8-11" as /sys/devices/system/node/node*/cpulist has it, invalid ranges are skipped
+    static std::vector<int> parse_cpu_list(const std::string& cpu_list);
+
+private:
+    pid_t spawn_worker(size_t worker_index, const WorkerMain& worker_main);
+    void pin_worker(size_t worker_index) const;
+    void stop_workers();
+
+    size_t                                  m_worker_count;
+    bool                                    m_pin_numa;
+    std::vector<std::vector<int>>           m_numa_cpus;        // CPUs of each NUMA node
+    WorkerSlot*                             m_slots;            // Shared mapping, one per worker
+    std::vector<std::chrono::steady_clock::time_point> m_restart_at;
+};
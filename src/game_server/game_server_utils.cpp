@@ -58,3 +58,54 @@ bool detect_collision(
 
     return dist_squared <= radius_sum * radius_sum;
 }
+
+bool detect_swept_collision(
+    const PlayerSnapshot& player,
+    const Vec2& player_from,
+    const BulletSnapshot& bullet,
+    const Vec2& bullet_from,
+    float& contact_time
+) {
+    // Relative to the player: starts at d, moves by m over the tick
+    const float dx = bullet_from.x - player_from.x;
+    const float dy = bullet_from.y - player_from.y;
+    const float mx = (bullet.pos.x - bullet_from.x) - (player.pos.x - player_from.x);
+    const float my = (bullet.pos.y - bullet_from.y) - (player.pos.y - player_from.y);
+
+    const float radius_sum = player.radius + bullet.radius;
+    const float c = dx * dx + dy * dy - radius_sum * radius_sum;
+
+    // Touching from the start
+    if (c <= 0.0f)
+    {
+        contact_time = 0.0f;
+        return true;
+    }
+
+    // Not moving relative to each other, or apart
+    const float a = mx * mx + my * my;
+    const float b = dx * mx + dy * my;
+
+    if (a == 0.0f || b >= 0.0f)
+    {
+        return false;
+    }
+
+    // First root of |d + t m| = radius_sum
+    const float discriminant = b * b - a * c;
+
+    if (discriminant < 0.0f)
+    {
+        return false;
+    }
+
+    const float t = (-b - std::sqrt(discriminant)) / a;
+
+    if (t > 1.0f)
+    {
+        return false;
+    }
+
+    contact_time = t;
+    return true;
+}
@@ -15,3 +15,13 @@ bool detect_collision(
     const PlayerSnapshot& player,
     const BulletSnapshot& bullet
 );
+
+// Both move in a line over the tick, from `*_from` to their current position.
+// On contact, `contact_time` is the earliest time within the tick (0 to 1) they touch
+bool detect_swept_collision(
+    const PlayerSnapshot& player,
+    const Vec2& player_from,
+    const BulletSnapshot& bullet,
+    const Vec2& bullet_from,
+    float& contact_time
+);
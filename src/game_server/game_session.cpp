@@ -0,0 +1,311 @@
+#include "game_session.hpp"
+
+#include <sstream>
+#include <cstring>    // std::memcmp
+#include <algorithm>  // std::upper_bound, std::find_if
+#include "game_server_constants.hpp"
+#include "game_server_utils.hpp"
+
+namespace {
+    constexpr uint32_t SESSION_STATE_MAGIC      = 0x53534842;   // "BHSS"
+    constexpr uint32_t SESSION_STATE_VERSION    = 6;
+
+    // Both sides must agree on the memory layout of the copied types
+    struct SessionStateHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t player_size;
+        uint32_t enemy_size;
+        uint32_t bullet_size;
+        uint32_t emitter_size;
+        uint64_t stage_fingerprint;     // Both sides must play the same stage
+    };
+
+    SessionStateHeader make_header(const StageTimeline& timeline) {
+        return {
+            SESSION_STATE_MAGIC,
+            SESSION_STATE_VERSION,
+            sizeof(PlayerSnapshot),
+            sizeof(EnemySnapshot),
+            sizeof(BulletSnapshot),
+            sizeof(Emitter),
+            timeline.get_fingerprint()
+        };
+    }
+}
+
+GameSession::GameSession(uint32_t seed, std::shared_ptr<const StageTimeline> timeline, size_t memory_cap)
+    : m_memory(std::make_unique<SessionMemory>(memory_cap))
+    , m_timeline(timeline ? std::move(timeline) : default_stage_timeline())
+    , m_frame{}
+    , m_arrow_state{}
+    , m_gen(seed)
+    , m_bullet_id(0)
+    , m_enemy_world(m_memory->pool())
+    , m_bullet_expiry(m_memory->pool())
+    , m_emitter_entities(m_timeline->get_emitter_count(), INVALID_ENTITY, m_memory->pool())
+    , m_pending_inputs(m_memory->pool())
+    , m_last_queued_sequence(0)
+    , m_last_input_sequence(0)
+    , m_resume_token{}
+{
+    // Stage
+    m_frame.stage.id = 0;
+    m_frame.stage.name = StageName::Default;
+
+    // Player
+    PlayerSnapshot player = {};
+    player.id = 0;
+    player.name = PlayerName::Default;
+    player.pos = {
+        0,
+        -120
+    };
+    player.vel = {
+        game_constants::PLAYER_SPEED,
+        game_constants::PLAYER_SPEED
+    };
+    player.radius = game_constants::PLAYER_RADIUS;
+    player.lives = 1;
+    m_frame.player_vector.push_back(player);
+    m_frame.player_count = 1;
+
+    // Enemies present from the start
+    spawn_due_enemies(0);
+    m_enemy_world.write_enemies(m_frame);
+}
+
+void GameSession::apply_input(const ClientInput& input) {
+    InputStamp stamp = {};
+    stamp.sequence = m_last_queued_sequence + 1;
+
+    apply_input(input, stamp);
+}
+
+void GameSession::apply_input(const ClientInput& input, const InputStamp& stamp) {
+    // Already applied, a resend or a stale input
+    if (stamp.sequence <= m_last_input_sequence)
+    {
+        return;
+    }
+
+    // Kept in sequence order, an equal sequence stays behind the first one
+    const auto position = std::upper_bound(
+        m_pending_inputs.begin(),
+        m_pending_inputs.end(),
+        stamp.sequence,
+        [](uint32_t sequence, const PendingInput& pending) {
+            return sequence < pending.stamp.sequence;
+        }
+    );
+
+    m_pending_inputs.insert(position, { input.game_input.arrows, stamp });
+    m_last_queued_sequence = std::max(m_last_queued_sequence, stamp.sequence);
+}
+
+void GameSession::update_player() {
+    auto& player = m_frame.player_vector[0];
+    const auto speed = player.vel.x;
+
+    // Moves for each stretch of the tick with the arrows held during it
+    uint32_t segment_start = 0;
+
+    auto move_until = [&](uint32_t segment_end) {
+        if (segment_end <= segment_start)
+        {
+            return;
+        }
+
+        if (player.lives > 0)
+        {
+            const auto fraction = static_cast<float>(segment_end - segment_start) / input_constants::TICK_OFFSET_ONE;
+            apply_player_input(player, get_direction_from_arrows(m_arrow_state), speed * fraction);
+        }
+
+        segment_start = segment_end;
+    };
+
+    auto apply_arrows = [&](const PendingInput& pending) {
+        if (pending.stamp.sequence <= m_last_input_sequence)
+        {
+            return;
+        }
+
+        m_arrow_state.held |= pending.arrows.pressed;
+        m_arrow_state.held &= ~pending.arrows.released;
+
+        m_last_input_sequence = pending.stamp.sequence;
+    };
+
+    // End of the inputs made in the same client tick as the first one
+    auto tick_end = [&](std::pmr::vector<PendingInput>::iterator first) {
+        return std::find_if(first, m_pending_inputs.end(), [&](const PendingInput& pending) {
+            return pending.stamp.client_tick != first->stamp.client_tick;
+        });
+    };
+
+    size_t queued_ticks = 0;
+
+    for (auto first = m_pending_inputs.begin(); first != m_pending_inputs.end(); first = tick_end(first))
+    {
+        queued_ticks++;
+    }
+
+    auto next = m_pending_inputs.begin();
+
+    // Held back for too long, the oldest ticks only change the arrows
+    for (; queued_ticks > input_constants::MAX_QUEUED_TICKS; queued_ticks--)
+    {
+        for (const auto last = tick_end(next); next != last; ++next)
+        {
+            apply_arrows(*next);
+        }
+    }
+
+    // The oldest client tick queued, the later ones wait for the next steps
+    if (next != m_pending_inputs.end())
+    {
+        for (const auto last = tick_end(next); next != last; ++next)
+        {
+            if (next->stamp.sequence > m_last_input_sequence)
+            {
+                move_until(next->stamp.tick_offset);
+            }
+
+            apply_arrows(*next);
+        }
+    }
+
+    move_until(input_constants::TICK_OFFSET_ONE);
+
+    m_pending_inputs.erase(m_pending_inputs.begin(), next);
+}
+
+void GameSession::step(BulletUpdater& bullet_updater) {
+    m_frame.timestamp++;
+
+    // Update player, with the inputs that arrived since the last tick
+    const auto player_from = m_frame.player_vector[0].pos;
+    update_player();
+
+    // Update enemies and fire the patterns the timeline has due this tick
+    spawn_due_enemies(m_frame.timestamp);
+
+    m_enemy_world.update_motion(m_frame.timestamp);
+    m_enemy_world.update_follow(m_memory->scratch());
+
+    for (const auto slot : m_timeline->fires_at(m_frame.timestamp))
+    {
+        m_enemy_world.fire_emitter(m_emitter_entities[slot], m_frame, m_gen, m_bullet_id);
+    }
+
+    m_enemy_world.write_enemies(m_frame);
+
+    // Update and detect collision of bullets, remove the dead ones
+    bullet_updater.update(m_frame, m_bullet_expiry, player_from);
+
+    m_memory->end_tick();
+    account_frame();
+}
+
+void GameSession::spawn_due_enemies(uint64_t tick) {
+    const auto& enemies = m_timeline->get_desc().enemies;
+
+    for (const auto& spawn : m_timeline->spawns_at(tick))
+    {
+        const auto first_slot = m_timeline->get_first_slot(spawn.enemy);
+
+        spawn_stage_enemy(m_enemy_world, enemies[spawn.enemy], m_emitter_entities.data() + first_slot);
+    }
+}
+
+void GameSession::account_frame() {
+    m_memory->set_external_bytes(
+        m_frame.player_vector.capacity() * sizeof(PlayerSnapshot) +
+        m_frame.enemy_vector.capacity() * sizeof(EnemySnapshot) +
+        m_frame.bullet_vector.capacity() * sizeof(BulletSnapshot)
+    );
+}
+
+void GameSession::serialize(StateWriter& writer) const {
+    writer.write(make_header(*m_timeline));
+    writer.write(m_resume_token);
+
+    // Frame
+    writer.write(m_frame.timestamp);
+    writer.write(m_frame.state);
+    writer.write(m_frame.stage);
+    writer.write(m_frame.player_count);
+    writer.write_vector(m_frame.player_vector);
+    writer.write(m_frame.enemy_count);
+    writer.write_vector(m_frame.enemy_vector);
+    writer.write(m_frame.bullet_count);
+    writer.write_vector(m_frame.bullet_vector);
+
+    // Input, RNG and counters
+    writer.write(m_arrow_state);
+    writer.write_vector(m_pending_inputs);
+    writer.write(m_last_queued_sequence);
+    writer.write(m_last_input_sequence);
+    writer.write(m_bullet_id);
+
+    std::ostringstream gen_state;
+    gen_state << m_gen;
+    writer.write_string(gen_state.str());
+
+    // Enemies and their pattern emitters
+    m_enemy_world.serialize(writer);
+    writer.write_vector(m_emitter_entities);
+}
+
+bool GameSession::deserialize(StateReader& reader) {
+    SessionStateHeader header = {};
+    const auto expected = make_header(*m_timeline);
+
+    if (!reader.read(header) || std::memcmp(&header, &expected, sizeof(header)) != 0)
+    {
+        return false;
+    }
+
+    reader.read(m_resume_token);
+    reader.read(m_frame.timestamp);
+    reader.read(m_frame.state);
+    reader.read(m_frame.stage);
+    reader.read(m_frame.player_count);
+    reader.read_vector(m_frame.player_vector);
+    reader.read(m_frame.enemy_count);
+    reader.read_vector(m_frame.enemy_vector);
+    reader.read(m_frame.bullet_count);
+    reader.read_vector(m_frame.bullet_vector);
+
+    // Filed again from where they are by the next step
+    m_bullet_expiry.clear();
+
+    reader.read(m_arrow_state);
+    reader.read_vector(m_pending_inputs);
+    reader.read(m_last_queued_sequence);
+    reader.read(m_last_input_sequence);
+    reader.read(m_bullet_id);
+
+    std::string gen_state;
+
+    if (!reader.read_string(gen_state))
+    {
+        return false;
+    }
+
+    std::istringstream iss(gen_state);
+    iss >> m_gen;
+
+    if (iss.fail() || m_frame.player_vector.empty())
+    {
+        return false;
+    }
+
+    if (!m_enemy_world.deserialize(reader))
+    {
+        return false;
+    }
+
+    return reader.read_vector(m_emitter_entities) && m_emitter_entities.size() == m_timeline->get_emitter_count();
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <random>
+#include <memory>
+#include <memory_resource>
+#include <packet_template/packet_template.hpp>
+#include "enemy_world.hpp"
+#include "stage_timeline.hpp"
+#include "bullet_updater.hpp"
+#include "bullet_expiry.hpp"
+#include "state_codec.hpp"
+#include "input_sequence.hpp"
+#include "resume_token.hpp"
+#include "session_memory.hpp"
+#include "game_server_constants.hpp"
+
+/*
+    Simulation state of one game instance, independent of the connection.
+    Everything needed to continue the game elsewhere is in here and can be
+    serialized: the frame, the player input, the RNG, the bullet id counter
+    and the enemies with their pattern emitters. The stage timeline decides
+    when enemies spawn and which emitters fire, it is shared read only with
+    the other instances of the stage.
+
+    Inputs are queued and applied in sequence order, one client tick of them
+    per step(). The ship moves for the part of the tick each arrow
+    combination was held, and the sequence of the last applied input is what
+    a frame acknowledges.
+    Bullets are culled through the session's expiry wheel.
+
+    The resume token of the game goes along with the state, a restored
+    session is resumed by the client that holds it.
+
+    The session owns its memory: the enemies and the input queue allocate
+    from its pool, the enemy tick from its scratch arena, and the frame is
+    counted against the same cap. step() throws SessionMemoryExceeded once
+    the session outgrows it.
+*/
+class GameSession {
+public:
+    // The default stage is played without a timeline
+    explicit GameSession(
+        uint32_t seed,
+        std::shared_ptr<const StageTimeline> timeline = nullptr,
+        size_t memory_cap = memory_constants::SESSION_MEMORY_CAP
+    );
+
+    void apply_input(const ClientInput& input);                             // Numbered in arrival order
+    void apply_input(const ClientInput& input, const InputStamp& stamp);
+
+    // Sequence of the last input the current frame reflects
+    uint32_t get_last_input_sequence() const { return m_last_input_sequence; }
+
+    // Crash recovery, set once when the game starts
+    const ResumeToken& get_resume_token() const { return m_resume_token; }
+    void set_resume_token(const ResumeToken& token) { m_resume_token = token; }
+
+    // Advances the game by one tick
+    void step(BulletUpdater& bullet_updater);
+
+    SessionMemory& get_memory() { return *m_memory; }
+    const SessionMemory& get_memory() const { return *m_memory; }
+
+    FrameSnapshot& get_frame() { return m_frame; }
+    const FrameSnapshot& get_frame() const { return m_frame; }
+
+    // Session migration
+    void serialize(StateWriter& writer) const;
+    bool deserialize(StateReader& reader);
+
+private:
+    struct PendingInput {
+        ArrowInput  arrows;
+        InputStamp  stamp;
+    };
+
+    void update_player();
+    void spawn_due_enemies(uint64_t tick);
+    void account_frame();
+
+    // First, everything below allocates from it
+    std::unique_ptr<SessionMemory>  m_memory;
+
+    std::shared_ptr<const StageTimeline>    m_timeline;
+
+    FrameSnapshot   m_frame;
+    ArrowState      m_arrow_state;
+    std::mt19937    m_gen;
+    uint32_t        m_bullet_id;
+    EnemyWorld      m_enemy_world;
+
+    // Derived from the bullets, rebuilt after a restore
+    BulletExpiry    m_bullet_expiry;
+
+    // Entity of every emitter slot of the timeline, INVALID_ENTITY until spawned
+    std::pmr::vector<EntityId>  m_emitter_entities;
+
+    // Inputs for the next ticks, in sequence order
+    std::pmr::vector<PendingInput>  m_pending_inputs;
+    uint32_t                    m_last_queued_sequence;
+    uint32_t                    m_last_input_sequence;
+
+    ResumeToken     m_resume_token;
+};
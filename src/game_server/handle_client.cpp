@@ -1,128 +1,180 @@
-#include <iostream>
+#include <sstream>
 #include <cmath>        // std::sqrt
 #include <algorithm>    // std::clamp
 #include <random>
 #include "game_server.hpp"
 #include "game_server_constants.hpp"
 #include "game_server_utils.hpp"
+#include "frame_sender.hpp"
+#include "bullet_updater.hpp"
+#include "game_session.hpp"
+#include "transport.hpp"
+#include "latency_estimator.hpp"
+#include "frame_json_writer.hpp"
+#include "frame_pacer.hpp"
+#include "diag_logger.hpp"
 #include "../game_logger/game_logger.hpp"
-#include <packet_stream/packet_stream.hpp>
+#include "../config_constants.hpp"
 #include <packet_template/packet_template.hpp>
 
-void GameServerMaster::handle_client(std::shared_ptr<ClientConnection> client_conn) {
-    PacketStreamServer packet_stream(client_conn);
-    packet_stream.start();
+void GameServerMaster::handle_client(
+    std::shared_ptr<Transport> transport,
+    uint64_t instance_id,
+    std::shared_ptr<InstanceStats> stats,
+    std::unique_ptr<GameSession> session
+) {
+    transport->start();
 
     // A closure that waits for a specific packet to arrive.
-    auto wait_packet = [&](PayloadType payload_type, size_t timeout_msec, size_t max_attempts) -> bool {
+    auto wait_packet = [&](PayloadType payload_type, size_t timeout_msec, size_t max_attempts) -> std::optional<ReceivedPacket> {
         for (size_t attempt = 0; attempt < max_attempts; attempt++)
         {
-            std::optional<Packet> packet_opt = packet_stream.poll_packet();
+            std::optional<ReceivedPacket> packet_opt = transport->poll_packet();
 
             if (packet_opt.has_value())
             {
-                if (packet_opt.value().header.payload_type == payload_type)
+                if (packet_opt.value().packet.header.payload_type == payload_type)
                 {
-                    return true;
+                    return packet_opt;
                 }
             }
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_msec));
+            // In short steps, a session that has not started yet is not handed over but ends with the drain
+            for (size_t waited = 0; waited < timeout_msec; waited += handoff_constants::HANDSHAKE_POLL_MSEC)
+            {
+                if (m_draining || !m_running)
+                {
+                    return std::nullopt;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(std::min<size_t>(handoff_constants::HANDSHAKE_POLL_MSEC, timeout_msec - waited)));
+            }
         }
 
-        return false;
+        return std::nullopt;
     };
 
-    FrameSnapshot frame = {};
+    // 1sec / Target FPS
+    constexpr int64_t target_frame_nsec = 1000000000 / game_constants::TARGET_FPS;
 
-    // Stage
-    frame.stage.id = 0;
-    frame.stage.name = StageName::Default;
+    // A new game, an adopted session continues where it was handed over
+    if (!session)
+    {
+        // Wait for client hello
+        if (!wait_packet(PayloadType::ClientHello, 1000, 10))
+        {
+            DIAG_DEBUG("GameServerMaster", "Client hello timeout");
 
-    // Player
-    PlayerSnapshot player = {};
-    player.id = 0;
-    player.name = PlayerName::Default;
-    player.pos = {
-        0,
-        -120
-    };
-    player.vel = {
-        game_constants::PLAYER_SPEED,
-        game_constants::PLAYER_SPEED
-    };
-    player.radius = game_constants::PLAYER_RADIUS;
-    player.lives = 1;
-    frame.player_vector.push_back(player);
-    frame.player_count = 1; 
-
-    // Enemy
-    EnemySnapshot enemy = {};
-    enemy.id = 0;
-    enemy.name = EnemyName::Default;
-    enemy.pos = {
-        0,
-        120
-    };
-    enemy.vel = {
-        2,
-        2
-    };
-    enemy.radius = game_constants::ENEMY_RADIUS;
-    frame.enemy_vector.push_back(enemy);
-    frame.enemy_count = 1;
+            return;
+        }
 
-    ArrowState arrow_state = {};
+        // Send server accept
+        transport->send_packet(make_packet<ServerAccept>({}));
+        DIAG_DEBUG("GameServerMaster", "Server accept has been sent");
 
-    // 1sec / Target FPS
-    constexpr auto target_frame_duration = std::chrono::duration<double>(1.0 / 60);
+        // Wait for client game request
+        const auto game_request_opt = wait_packet(PayloadType::ClientGameRequest, 1000, 1000);
 
-    // Wait for client hello
-    if (!wait_packet(PayloadType::ClientHello, 1000, 10))
-    {
-        std::cout << "[GameServerMaster] DEBUG: Client hello timeout" << "\n";
+        if (!game_request_opt)
+        {
+            DIAG_DEBUG("GameServerMaster", "Client game request timeout");
 
-        return;
-    }
+            return;
+        }
 
-    // Send server accept
-    packet_stream.send_packet(make_packet<ServerAccept>({}));
-    std::cout << "[GameServerMaster] DEBUG: Server accept has been sent" << "\n";
+        // A client back after a crash continues its game, if this run restored it
+        if (game_request_opt->resume_token.has_value())
+        {
+            session = take_recovered_session(*game_request_opt->resume_token);
+        }
 
-    // Wait for client game request
-    if (!wait_packet(PayloadType::ClientGameRequest, 1000, 1000))
-    {
-        std::cout << "[GameServerMaster] DEBUG: Client game request timeout" << "\n";
+        if (session)
+        {
+            DIAG_DEBUG("GameServerMaster", "The game of instance " << session->get_resume_token().instance_id
+                                           << " of the previous run has been resumed");
+        }
+        else
+        {
+            std::random_device rd;
+            session = std::make_unique<GameSession>(rd(), m_stage_timeline);
+            session->set_resume_token({ instance_id, (static_cast<uint64_t>(rd()) << 32) | rd() });
+        }
 
-        return;
+        // Send server game response
+        transport->send_game_response(make_packet<ServerGameResponse>({}), session->get_resume_token());
+        DIAG_DEBUG("GameServerMaster", "Server game response has been sent");
     }
 
-    // Send server game response
-    packet_stream.send_packet(make_packet<ServerGameResponse>({}));
-    std::cout << "[GameServerMaster] DEBUG: Server game response has been sent" << "\n";
-
     auto quit = false;
-    auto bullet_id = 0;
+    auto migrated = false;
+    auto& frame = session->get_frame();
+
+    // Round trip and clock offset of this connection
+    LatencyEstimator latency_estimator;
+
+    // Checkpoints only see the session between two changes, it is held for nothing that may block
+    std::shared_ptr<CrashCheckpointer::Slot> checkpoint_slot;
+
+    auto hold_for_checkpoint = [&]() {
+        return checkpoint_slot ? std::unique_lock<std::mutex>(checkpoint_slot->mutex) : std::unique_lock<std::mutex>();
+    };
+
+    auto apply_input = [&](const ReceivedPacket& received) {
+        const auto& input = std::get<ClientInput>(received.packet.payload);
+
+        if (received.pong_stamp.has_value() && latency_estimator.on_pong(*received.pong_stamp, received.received_usec))
+        {
+            const auto estimate = latency_estimator.get_estimate();
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
+            stats->rtt_usec = estimate.rtt_usec;
+            stats->rtt_jitter_usec = estimate.jitter_usec;
+            stats->clock_offset_usec = estimate.clock_offset_usec;
+            stats->rtt_samples = estimate.samples;
+        }
 
-    // Create a distribution in the range [0, 359]
-    std::uniform_int_distribution<> dist(0, 359);
+        const auto checkpoint_lock = hold_for_checkpoint();
+
+        if (received.input_stamp.has_value())
+        {
+            session->apply_input(input, *received.input_stamp);
+        }
+        else
+        {
+            session->apply_input(input);
+        }
+    };
+
+    // Bullet pass, parallel for the large bullet counts if enabled
+    auto& session_memory = session->get_memory();
+    BulletUpdater bullet_updater(m_worker_pool.get(), m_parallel_bullet_threshold, session_memory.pool());
+    bullet_updater.set_collision_mode(m_collision_mode);
 
     // Start logger
     GameLogger game_logger;
+    FrameJsonWriter frame_json_writer(64 * 1024, session_memory.pool());
+
+    // From here on, every packet goes through the frame sender
+    FrameSender frame_sender(*transport, stats, &latency_estimator);
+    frame_sender.start();
+
+    // Ticks on absolute deadlines, more than one is due after a missed deadline
+    FramePacer frame_pacer(target_frame_nsec, pacing_constants::SPIN_NSEC, get_max_catch_up_ticks(m_overrun_policy));
+    uint32_t ticks_due = 1;
+    frame_pacer.start();
+
+    if (m_checkpointer)
+    {
+        checkpoint_slot = m_checkpointer->add_session(instance_id, *session);
+    }
 
     // Game logic loop
     while (m_running && !quit)
     {
-        frame.timestamp++;
-
         auto frame_start = std::chrono::steady_clock::now();
 
         // Check if the recv thread is alive
-        const auto expr_1 = packet_stream.get_recv_exception() == nullptr;
-        const auto expr_2 = packet_stream.is_running();
+        const auto expr_1 = transport->get_recv_exception() == nullptr;
+        const auto expr_2 = transport->is_running();
 
         if (!expr_1 || !expr_2)
         {
@@ -132,32 +184,29 @@ void GameServerMaster::handle_client(std::shared_ptr<ClientConnection> client_co
         // Process the packet queue
         while (true && !quit)
         {
-            std::optional<Packet> packet_opt = packet_stream.poll_packet();
+            std::optional<ReceivedPacket> packet_opt = transport->poll_packet();
 
             if (!packet_opt.has_value())
             {
                 break;
             }
 
-            Packet packet = std::move(*packet_opt);
+            const Packet& packet = packet_opt->packet;
 
             switch (packet.header.payload_type)
             {
                 case PayloadType::ClientInput:
                 {
-                    const auto input_snapshot = std::get<ClientInput>(packet.payload);
-                    arrow_state.held |= input_snapshot.game_input.arrows.pressed;
-                    arrow_state.held &= ~input_snapshot.game_input.arrows.released;
+                    apply_input(*packet_opt);
 
                     break;
                 }
 
                 case PayloadType::ClientGoodbye:
                 {
-                    std::cout << "[GameServerMaster] DEBUG: Received client goodbye" << "\n";
+                    DIAG_DEBUG("GameServerMaster", "Received client goodbye");
 
-                    const auto packet = make_packet<ServerGoodbye>({});
-                    packet_stream.send_packet(packet);
+                    frame_sender.send_control(make_packet<ServerGoodbye>({}));
 
                     quit = true;
 
@@ -166,221 +215,184 @@ void GameServerMaster::handle_client(std::shared_ptr<ClientConnection> client_co
 
                 default:
                 {
-                    std::cerr << "[GameServerMaster] DEBUG: Unexpected message type: "
-                            << static_cast<uint32_t>(packet.header.payload_type) << "\n";
+                    DIAG_DEBUG("GameServerMaster", "Unexpected message type: "
+                                                   << static_cast<uint32_t>(packet.header.payload_type));
                     break;
                 }
             }
         }
 
-        /*
-            Logic update
-        */
-        // Update player
-        if (frame.player_vector[0].lives > 0)
-        {
-            auto direction = get_direction_from_arrows(arrow_state);
-            apply_player_input(frame.player_vector[0], direction, frame.player_vector[0].vel.x);
-        }
-        
-        // Update enemy direction
-        auto& enemy = frame.enemy_vector[0];
-        if (enemy.pos.x > game_constants::GAME_WIDTH_HALF)
-        {
-            enemy.vel.x = -2;
-        }
-        else if (enemy.pos.x < -game_constants::GAME_WIDTH_HALF)
-        {
-            enemy.vel.x = 2;
-        }
-        
-        if (enemy.pos.y > game_constants::GAME_HEIGHT_HALF)
-        {
-            enemy.vel.y = -2;
-        }
-        else if (enemy.pos.y < 60)
+        // Hand the session over between two ticks while draining, an in process client can not follow
+        if (m_draining && transport->get_socket() >= 0)
         {
-            enemy.vel.y = 2;
-        }
-
-        // Move enemy
-        if ((frame.timestamp % 360) < 120)
-        {
-            frame.enemy_vector[0].pos.x += frame.enemy_vector[0].vel.x;
-            frame.enemy_vector[0].pos.y += frame.enemy_vector[0].vel.y;
-        }
-
-        // Circle shot
-        if ((frame.timestamp % 360) > 120 && frame.timestamp % 60 == 0)
-        {
-            constexpr double two_pi = 2*math_constants::PI;
-            constexpr double step = two_pi / 8;
+            // The successor owns the session from here on
+            if (checkpoint_slot)
+            {
+                m_checkpointer->remove_session(checkpoint_slot);
+                checkpoint_slot.reset();
+            }
 
-            const float rad_offset = static_cast<float>(deg_to_rad(frame.timestamp % 360));
+            frame_sender.stop();
+            transport->stop();
 
-            for (double r = 0; r < two_pi; r += step)
+            // Inputs that already made it into the queue
+            while (auto packet_opt = transport->poll_packet())
             {
-                auto bullet = BulletSnapshot{};
-
-                bullet.id = bullet_id++;
-                bullet.name = BulletName::BigRed;
-                bullet.pos = frame.enemy_vector[0].pos;
-                bullet.vel = {
-                    2 * std::cos(rad_offset + static_cast<float>(r)),
-                    2 * std::sin(rad_offset + static_cast<float>(r))
-                };
-                bullet.radius = game_constants::ENEMY_BIG_BULLET_RADIUS;
-                bullet.angle = std::atan2(bullet.vel.y, bullet.vel.x) - math_constants::HALF_PI;
-                frame.bullet_vector.push_back(bullet);
-                frame.bullet_count++;
+                if (packet_opt->packet.header.payload_type == PayloadType::ClientInput)
+                {
+                    apply_input(*packet_opt);
+                }
             }
-        }
 
-        // Homing shot
-        if ((frame.timestamp % 360) > 120 && frame.timestamp % 30 == 0)
-        {
-            float vx = frame.player_vector[0].pos.x - frame.enemy_vector[0].pos.x;
-            float vy = frame.player_vector[0].pos.y - frame.enemy_vector[0].pos.y;
+            // A send cut off in the middle of a packet, the successor could not make sense of the stream
+            if (frame_sender.is_connection_lost())
+            {
+                DIAG_ERROR("GameServerMaster", "The client stopped reading, the session is not handed over");
 
-            float length = std::sqrt(vx * vx + vy * vy);
+                break;
+            }
 
-            float dx = 1.0f;
-            float dy = 1.0f;
+            migrated = hand_off_session(transport->get_socket(), *session);
 
-            if (length != 0.0f)
+            if (!migrated)
             {
-                dx = vx / length * 2.5f;
-                dy = vy / length * 2.5f;
+                DIAG_ERROR("GameServerMaster", "Failed to hand the session over");
             }
 
-            auto bullet = BulletSnapshot{};
-
-            bullet.id = bullet_id++;
-            bullet.name = BulletName::WedgeRed;
-            bullet.pos = frame.enemy_vector[0].pos;
-            bullet.vel = { dx, dy };
-            bullet.radius = game_constants::ENEMY_WEDGE_BULLET_RADIUS;
-            bullet.angle = std::atan2(dy, dx) - math_constants::HALF_PI;
-            frame.bullet_vector.push_back(bullet);
-            frame.bullet_count++;
+            break;
         }
 
-        // Spiral shot
-        if ((frame.timestamp % 360) > 120 && frame.timestamp % 8 == 0)
+        // An in process client has nowhere to follow the session to, its game ends with the drain
+        if (m_draining)
         {
-            constexpr double two_pi = 2*math_constants::PI;
-            constexpr double step = two_pi / 7;
+            DIAG_DEBUG("GameServerMaster", "Ending the in process session for the drain");
 
-            const float rad_offset = static_cast<float>(deg_to_rad(frame.timestamp % 360));
-            size_t sprite_index = 0;
+            frame_sender.send_control(make_packet<ServerGoodbye>({}));
 
-            for (double r = 0; r < two_pi; r += step)
-            {
-                sprite_index++;
-
-                const float dx = cos(rad_offset + r) * 2;
-                const float dy = sin(rad_offset + r) * 2;
-
-                auto bullet = BulletSnapshot{};
-
-                bullet.id = bullet_id++;
-                bullet.name = static_cast<BulletName>(
-                    static_cast<size_t>(BulletName::RiceRed) + (sprite_index % 8)
-                );
-                bullet.pos = frame.enemy_vector[0].pos;
-                bullet.vel = { dx, dy };
-                bullet.radius = game_constants::ENEMY_RICE_BULLET_RADIUS;
-                bullet.angle = std::atan2(dy, dx) - math_constants::HALF_PI;
-                frame.bullet_vector.push_back(bullet);
-                frame.bullet_count++;
-            }
+            break;
         }
 
-        // Random shot
-        if (frame.timestamp % 60 == 0 && frame.timestamp > 120)
+        /*
+            Logic update
+        */
+        auto memory_exceeded = false;
+
+        for (uint32_t tick = 0; tick < ticks_due; tick++)
         {
-            size_t number_of_rand_shot = 7;
+            try
+            {
+                const auto checkpoint_lock = hold_for_checkpoint();
 
-            for (size_t i = 0; i < number_of_rand_shot; i++)
+                session->step(bullet_updater);
+            }
+            catch (const SessionMemoryExceeded&)
             {
-                const double rand_1 = dist(gen);
-                const double rand_2 = dist(gen);
-                const float rad_1 = static_cast<float>(deg_to_rad(rand_1));
-                const float rad_2 = static_cast<float>(deg_to_rad(rand_2));
-                const float dx = cos(rad_1) * 2;
-                const float dy = sin(rad_2) * 2;
-
-                auto bullet = BulletSnapshot{};
-
-                bullet.id = bullet_id++;
-                bullet.name = static_cast<BulletName>(i % 8 + 1);
-                bullet.pos = frame.enemy_vector[0].pos;
-                bullet.vel = { dx, dy };
-                bullet.radius = game_constants::ENEMY_NORMAL_BULLET_RADIUS;
-                bullet.angle = std::atan2(dy, dx) - math_constants::HALF_PI;
-                frame.bullet_vector.push_back(bullet);
-                frame.bullet_count++;
+                DIAG_ERROR("GameServerMaster", "Session memory cap exceeded, ending the game");
+
+                memory_exceeded = true;
+
+                break;
             }
-        }
 
-        // Update and detect collision of bullets
-        for (auto& bullet : frame.bullet_vector)
-        {
-            bullet.pos.x += bullet.vel.x;
-            bullet.pos.y += bullet.vel.y;
-
-            const auto collided = detect_collision(
-                frame.player_vector[0],
-                bullet
-            );
-            
-            if (collided)
+            // Send frame (at the rate the client is able to drain), only the latest one of a late batch when skipping
+            const auto expr_1 = tick + 1 == ticks_due || m_overrun_policy == OverrunPolicy::CatchUp;
+
+            if (expr_1 && frame_sender.is_frame_due(frame.timestamp))
             {
-                frame.player_vector[0].lives = 0;
-                frame.state = frame.state | GameState::GameOver;
+                frame_sender.send_frame(make_packet<FrameSnapshot>(frame), { session->get_last_input_sequence() });
             }
+
+            // Save game log, every tick
+            game_logger.async_log(frame_json_writer.write(frame));
         }
 
-        // Remove the dead bullets
-        auto& vec = frame.bullet_vector;
-        for (size_t i = 0; i < vec.size(); )
+        if (memory_exceeded)
         {
-            if (outside(vec[i].pos.x, vec[i].pos.y))
-            {
-                std::swap(vec[i], vec.back());
-                vec.pop_back();
-                frame.bullet_count--;
-            }
-            else
-            {
-                i++;
-            }
+            break;
         }
 
-        // Send frame
-        const auto packet = make_packet<FrameSnapshot>(frame);
-        packet_stream.send_packet(packet);
+        const auto memory_usage = session_memory.get_usage();
+        stats->memory_in_use = memory_usage.in_use;
+        stats->memory_high_water = memory_usage.high_water;
+        stats->last_input_sequence = session->get_last_input_sequence();
 
-        // Save game log
-        const auto log_message = frame_to_json_str(frame);
-        game_logger.async_log(log_message);
+        report_tick_busy(instance_id, std::chrono::steady_clock::now() - frame_start);
 
-        // Adjust the frame rate
-        auto frame_end = std::chrono::steady_clock::now();
-        auto frame_duration = frame_end - frame_start;
+        // Wait for the deadline of the next tick
+        const auto pace = frame_pacer.wait();
+        const auto late_usec = pace.late_nsec / 1000;
 
-        if (frame_duration < target_frame_duration)
+        ticks_due = pace.ticks;
+
+        if (late_usec > stats->max_pacing_late_usec)
         {
-            std::this_thread::sleep_for(target_frame_duration - frame_duration);
+            stats->max_pacing_late_usec = late_usec;
         }
-        else
+
+        if (pace.ticks > 1 || pace.dropped > 0)
         {
-            std::cerr << "[GameServerMaster] ERROR: The game logic update could not be completed within the specified FPS" << "\n";
+            stats->pacing_overruns++;
+            stats->ticks_caught_up += pace.ticks - 1;
+            stats->ticks_dropped += pace.dropped;
+
+            DIAG_ERROR("GameServerMaster", "The game logic update could not be completed within the specified FPS, "
+                                           << pace.ticks - 1 << " ticks behind, " << pace.dropped << " dropped");
         }
     }
 
-    packet_stream.stop();
-    client_conn->disconnect();
+    if (checkpoint_slot)
+    {
+        m_checkpointer->remove_session(checkpoint_slot);
+    }
+
+    frame_sender.stop();
+    transport->stop();
 
-    std::cout << "[GameServerMaster] DEBUG: Game Instance has been terminated successfully" << "\n";
+    if (auto recv_exception = transport->get_recv_exception())
+    {
+        try
+        {
+            std::rethrow_exception(recv_exception);
+        }
+        catch (const std::exception& e)
+        {
+            DIAG_DEBUG("GameServerMaster", "Receive stopped: " << e.what());
+        }
+    }
+
+    // The successor owns the connection now
+    if (!migrated)
+    {
+        transport->disconnect();
+    }
+
+    // Connection quality over the whole game, at the top of the playlog
+    const auto latency = latency_estimator.get_estimate();
+
+    std::ostringstream playlog_header;
+    playlog_header << "{\"header\":{"
+                   << "\"instance_id\":" << instance_id << ","
+                   << "\"rtt_usec\":" << latency.rtt_usec << ","
+                   << "\"rtt_jitter_usec\":" << latency.jitter_usec << ","
+                   << "\"clock_offset_usec\":" << latency.clock_offset_usec << ","
+                   << "\"rtt_samples\":" << latency.samples
+                   << "}}";
+    game_logger.set_header(playlog_header.str());
+
+    DIAG_DEBUG("GameServerMaster", "Send stats: "
+                                   << stats->frames_sent << " frames sent, "
+                                   << stats->frames_coalesced << " coalesced, "
+                                   << stats->rate_changes << " rate changes, "
+                                   << "max queue depth " << stats->max_send_queue_depth << ", "
+                                   << stats->pacing_overruns << " pacing overruns, "
+                                   << "memory high water " << stats->memory_high_water << " bytes");
+
+    if (migrated)
+    {
+        DIAG_DEBUG("GameServerMaster", "Game Instance has been handed over at frame " << frame.timestamp);
+    }
+    else
+    {
+        DIAG_DEBUG("GameServerMaster", "Game Instance has been terminated successfully");
+    }
 }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Sequence number and timing of a client input.
+
+    A client that predicts its own ship appends this to the ClientInput
+    payload. Inputs are applied in sequence order, and `tick_offset` tells
+    when within the tick the arrows changed, so a press and release inside
+    one tick still moves the ship for the time it was held. A server tick
+    applies the inputs of one client tick, inputs of later client ticks that
+    arrived with them wait for the following ticks. Inputs without it are
+    numbered by the server in arrival order and apply at the start of the
+    next tick.
+*/
+struct InputStamp {
+    uint32_t sequence;      // Starts at 1, increments by one per input
+    uint16_t tick_offset;   // In 1/65536 of a tick
+    uint16_t client_tick;   // Tick of the client the input was made in, wraps around
+};
+
+namespace input_constants {
+    constexpr uint32_t TICK_OFFSET_ONE = 65536;
+
+    // Client ticks of inputs held back at most, the older ones are applied at once so the input delay does not build up
+    constexpr size_t   MAX_QUEUED_TICKS = 4;
+}
+
+/*
+    Optional, follows the InputStamp. Echoes the newest frame the client has
+    received, with its own clock at receipt and at sending this input. The
+    server knows when it sent that frame and when the input arrived, which
+    gives a round trip and a clock offset sample (as in NTP).
+*/
+struct PongStamp {
+    uint64_t frame_tick;
+    int64_t  client_recv_usec;
+    int64_t  client_send_usec;
+};
+
+/*
+    Follows the FrameSnapshot payload of every frame sent to a client, the
+    newest input applied when the frame was built. A predicting client drops
+    its inputs up to this sequence and replays the rest on top of the frame.
+*/
+struct FrameAck {
+    uint32_t last_input_sequence;   // 0 before the first input
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+/*
+    Live counters of a single game instance.
+    Written by the instance threads, read by the master for monitoring.
+*/
+struct InstanceStats {
+    // Send side
+    std::atomic<uint32_t> send_queue_depth{0};
+    std::atomic<uint32_t> max_send_queue_depth{0};
+    std::atomic<uint64_t> frames_sent{0};
+    std::atomic<uint64_t> frames_coalesced{0};
+    std::atomic<uint32_t> snapshot_rate_hz{0};
+    std::atomic<uint32_t> rate_changes{0};
+
+    // Network latency, see LatencyEstimator
+    std::atomic<int64_t>  rtt_usec{0};
+    std::atomic<int64_t>  rtt_jitter_usec{0};
+    std::atomic<int64_t>  clock_offset_usec{0};
+    std::atomic<uint64_t> rtt_samples{0};
+
+    // Memory of the session, see SessionMemory
+    std::atomic<size_t>   memory_in_use{0};
+    std::atomic<size_t>   memory_high_water{0};
+
+    // Tick pacing, see FramePacer
+    std::atomic<uint64_t> pacing_overruns{0};
+    std::atomic<uint64_t> ticks_caught_up{0};
+    std::atomic<uint64_t> ticks_dropped{0};
+    std::atomic<int64_t>  max_pacing_late_usec{0};
+
+    // Input, see GameSession::get_last_input_sequence()
+    std::atomic<uint32_t> last_input_sequence{0};
+};
+
+// Plain copy of InstanceStats taken at a point in time
+struct InstanceStatsSnapshot {
+    uint64_t instance_id;
+
+    // Send side
+    uint32_t send_queue_depth;
+    uint32_t max_send_queue_depth;
+    uint64_t frames_sent;
+    uint64_t frames_coalesced;
+    uint32_t snapshot_rate_hz;
+    uint32_t rate_changes;
+
+    // Network latency
+    int64_t  rtt_usec;
+    int64_t  rtt_jitter_usec;
+    int64_t  clock_offset_usec;
+    uint64_t rtt_samples;
+
+    // Memory
+    size_t   memory_in_use;
+    size_t   memory_high_water;
+
+    // Tick pacing
+    uint64_t pacing_overruns;
+    uint64_t ticks_caught_up;
+    uint64_t ticks_dropped;
+    int64_t  max_pacing_late_usec;
+
+    // Input
+    uint32_t last_input_sequence;
+};
+
+inline InstanceStatsSnapshot take_snapshot(uint64_t instance_id, const InstanceStats& stats) {
+    InstanceStatsSnapshot snapshot = {};
+
+    snapshot.instance_id            = instance_id;
+    snapshot.send_queue_depth       = stats.send_queue_depth.load();
+    snapshot.max_send_queue_depth   = stats.max_send_queue_depth.load();
+    snapshot.frames_sent            = stats.frames_sent.load();
+    snapshot.frames_coalesced       = stats.frames_coalesced.load();
+    snapshot.snapshot_rate_hz       = stats.snapshot_rate_hz.load();
+    snapshot.rate_changes           = stats.rate_changes.load();
+    snapshot.rtt_usec               = stats.rtt_usec.load();
+    snapshot.rtt_jitter_usec        = stats.rtt_jitter_usec.load();
+    snapshot.clock_offset_usec      = stats.clock_offset_usec.load();
+    snapshot.rtt_samples            = stats.rtt_samples.load();
+    snapshot.memory_in_use          = stats.memory_in_use.load();
+    snapshot.memory_high_water      = stats.memory_high_water.load();
+    snapshot.pacing_overruns        = stats.pacing_overruns.load();
+    snapshot.ticks_caught_up        = stats.ticks_caught_up.load();
+    snapshot.ticks_dropped          = stats.ticks_dropped.load();
+    snapshot.max_pacing_late_usec   = stats.max_pacing_late_usec.load();
+    snapshot.last_input_sequence    = stats.last_input_sequence.load();
+
+    return snapshot;
+}
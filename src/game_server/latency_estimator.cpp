@@ -0,0 +1,95 @@
+#include "latency_estimator.hpp"
+
+#include <chrono>
+#include <algorithm>  // std::max
+#include <cmath>    // std::abs, std::llround
+
+namespace {
+    // RFC 6298 gains
+    constexpr double RTT_ALPHA      = 1.0 / 8;
+    constexpr double RTTVAR_BETA    = 1.0 / 4;
+    constexpr double OFFSET_GAIN    = 1.0 / 8;
+}
+
+LatencyEstimator::LatencyEstimator()
+    : m_pings{}
+    , m_last_sample_tick(0)
+    , m_samples(0)
+    , m_srtt_usec(0)
+    , m_rttvar_usec(0)
+    , m_offset_usec(0)
+{
+    for (auto& ping : m_pings)
+    {
+        ping.frame_tick = UINT64_MAX;
+    }
+}
+
+int64_t LatencyEstimator::now_usec() {
+    using namespace std::chrono;
+
+    return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+void LatencyEstimator::record_ping(uint64_t frame_tick, int64_t send_usec) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_pings[frame_tick % m_pings.size()] = { frame_tick, send_usec };
+}
+
+bool LatencyEstimator::on_pong(const PongStamp& pong, int64_t recv_usec) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_samples > 0 && pong.frame_tick < m_last_sample_tick + latency_constants::PING_INTERVAL_TICKS)
+    {
+        return false;
+    }
+
+    // Not one of the recent frames
+    const auto& ping = m_pings[pong.frame_tick % m_pings.size()];
+
+    if (ping.frame_tick != pong.frame_tick || pong.client_send_usec < pong.client_recv_usec)
+    {
+        return false;
+    }
+
+    // t0: server send, t1: client receive, t2: client send, t3: server receive
+    const auto t0 = ping.send_usec;
+    const auto t1 = pong.client_recv_usec;
+    const auto t2 = pong.client_send_usec;
+    const auto t3 = recv_usec;
+
+    const auto rtt = static_cast<double>(std::max<int64_t>((t3 - t0) - (t2 - t1), 0));
+    const auto offset = ((t1 - t0) + (t2 - t3)) / 2.0;
+
+    if (m_samples == 0)
+    {
+        m_srtt_usec = rtt;
+        m_rttvar_usec = rtt / 2;
+        m_offset_usec = offset;
+    }
+    else
+    {
+        m_rttvar_usec = (1 - RTTVAR_BETA) * m_rttvar_usec + RTTVAR_BETA * std::abs(m_srtt_usec - rtt);
+        m_srtt_usec = (1 - RTT_ALPHA) * m_srtt_usec + RTT_ALPHA * rtt;
+        m_offset_usec = (1 - OFFSET_GAIN) * m_offset_usec + OFFSET_GAIN * offset;
+    }
+
+    m_last_sample_tick = pong.frame_tick;
+    m_samples++;
+
+    return true;
+}
+
+LatencyEstimate LatencyEstimator::get_estimate() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    LatencyEstimate estimate = {};
+
+    estimate.rtt_usec           = std::llround(m_srtt_usec);
+    estimate.jitter_usec        = std::llround(m_rttvar_usec);
+    estimate.clock_offset_usec  = std::llround(m_offset_usec);
+    estimate.samples            = m_samples;
+
+    return estimate;
+}
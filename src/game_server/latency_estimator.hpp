@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <mutex>
+#include "input_sequence.hpp"
+#include "game_server_constants.hpp"
+
+struct LatencyEstimate {
+    int64_t     rtt_usec;           // Smoothed round trip time
+    int64_t     jitter_usec;        // Smoothed deviation of the round trip time
+    int64_t     clock_offset_usec;  // Client clock minus server clock
+    uint64_t    samples;
+};
+
+/*
+    Network latency of a single connection.
+
+    Every frame the server sends is a ping, and a client input echoing one
+    of them (PongStamp) is the pong. The round trip is smoothed like TCP
+    does (RFC 6298), and the deviation of it is the jitter. Lag
+    compensation, snapshot rate and matchmaking all read the same estimate.
+*/
+class LatencyEstimator {
+public:
+    LatencyEstimator();
+
+    // Wall clock both sides agree on the epoch of
+    static int64_t now_usec();
+
+    // Send side, when a frame goes out
+    void record_ping(uint64_t frame_tick, int64_t send_usec);
+
+    // Game loop, when an input with an echo arrives. True if it made a new sample.
+    bool on_pong(const PongStamp& pong, int64_t recv_usec);
+
+    LatencyEstimate get_estimate() const;
+
+private:
+    struct Ping {
+        uint64_t    frame_tick;
+        int64_t     send_usec;
+    };
+
+    mutable std::mutex                                      m_mutex;
+    std::array<Ping, latency_constants::PING_HISTORY>       m_pings;
+
+    uint64_t    m_last_sample_tick;
+    uint64_t    m_samples;
+    double      m_srtt_usec;
+    double      m_rttvar_usec;
+    double      m_offset_usec;
+};
@@ -0,0 +1,166 @@
+#include "local_transport.hpp"
+
+#include <thread>
+#include "latency_estimator.hpp"
+
+LocalChannel::LocalChannel()
+    : to_server(local_transport_constants::TO_SERVER_CAPACITY)
+    , to_client(local_transport_constants::TO_CLIENT_CAPACITY)
+    , server_closed(false)
+    , client_closed(false)
+{}
+
+/*
+    LocalTransport
+*/
+LocalTransport::LocalTransport(std::shared_ptr<LocalChannel> channel)
+    : m_channel(std::move(channel))
+    , m_running(false)
+{}
+
+LocalTransport::~LocalTransport() {
+    disconnect();
+}
+
+void LocalTransport::start() {
+    m_running = true;
+}
+
+void LocalTransport::stop() {
+    m_running = false;
+}
+
+std::optional<ReceivedPacket> LocalTransport::poll_packet() {
+    ReceivedPacket received;
+
+    if (!m_channel->to_server.try_pop(received))
+    {
+        return std::nullopt;
+    }
+
+    return received;
+}
+
+bool LocalTransport::send_packet(Packet packet) {
+    return push({ std::move(packet), std::nullopt, std::nullopt });
+}
+
+bool LocalTransport::send_game_response(Packet packet, const ResumeToken& token) {
+    return push({ std::move(packet), std::nullopt, token });
+}
+
+bool LocalTransport::send_frame(Packet packet, const FrameAck& ack) {
+    return push({ std::move(packet), ack, std::nullopt });
+}
+
+bool LocalTransport::try_send_frame(Packet& packet, const FrameAck& ack) {
+    if (m_channel->client_closed)
+    {
+        return false;
+    }
+
+    DeliveredPacket delivered = { std::move(packet), ack, std::nullopt };
+
+    if (m_channel->to_client.try_push(delivered))
+    {
+        return true;
+    }
+
+    // Stays with the caller for the next chance
+    packet = std::move(delivered.packet);
+
+    return false;
+}
+
+// Only the rare control packets wait here, frames go through try_send_frame()
+bool LocalTransport::push(DeliveredPacket delivered) {
+    while (!m_channel->to_client.try_push(delivered))
+    {
+        if (m_channel->client_closed || m_channel->server_closed)
+        {
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+bool LocalTransport::is_running() const {
+    return m_running && !m_channel->client_closed;
+}
+
+void LocalTransport::disconnect() {
+    m_channel->server_closed = true;
+}
+
+/*
+    LocalClient
+*/
+LocalClient::LocalClient(std::shared_ptr<LocalChannel> channel)
+    : m_channel(std::move(channel))
+{}
+
+LocalClient::~LocalClient() {
+    disconnect();
+}
+
+bool LocalClient::send_packet(Packet packet, std::optional<InputStamp> input_stamp, std::optional<PongStamp> pong_stamp) {
+    if (m_channel->server_closed)
+    {
+        return false;
+    }
+
+    ReceivedPacket received = {
+        std::move(packet),
+        input_stamp,
+        pong_stamp,
+        std::nullopt,
+        LatencyEstimator::now_usec()
+    };
+
+    return m_channel->to_server.try_push(received);
+}
+
+bool LocalClient::send_game_request(const ResumeToken& resume_token) {
+    if (m_channel->server_closed)
+    {
+        return false;
+    }
+
+    ReceivedPacket received = {
+        make_packet<ClientGameRequest>({}),
+        std::nullopt,
+        std::nullopt,
+        resume_token,
+        LatencyEstimator::now_usec()
+    };
+
+    return m_channel->to_server.try_push(received);
+}
+
+std::optional<DeliveredPacket> LocalClient::poll_packet() {
+    DeliveredPacket delivered;
+
+    if (!m_channel->to_client.try_pop(delivered))
+    {
+        return std::nullopt;
+    }
+
+    return delivered;
+}
+
+bool LocalClient::is_connected() const {
+    return !m_channel->server_closed;
+}
+
+void LocalClient::disconnect() {
+    m_channel->client_closed = true;
+}
+
+std::pair<std::shared_ptr<LocalTransport>, std::shared_ptr<LocalClient>> make_local_connection() {
+    auto channel = std::make_shared<LocalChannel>();
+
+    return { std::make_shared<LocalTransport>(channel), std::make_shared<LocalClient>(channel) };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <atomic>
+#include <utility>
+#include "transport.hpp"
+#include "spsc_queue.hpp"
+#include "game_server_constants.hpp"
+
+// A packet as an in process client receives it
+struct DeliveredPacket {
+    Packet                      packet;
+    std::optional<FrameAck>     frame_ack;      // FrameSnapshot only
+    std::optional<ResumeToken>  resume_token;   // ServerGameResponse only
+};
+
+// The two queues between an in process client and its game instance
+struct LocalChannel {
+    LocalChannel();
+
+    SpscQueue<ReceivedPacket>   to_server;
+    SpscQueue<DeliveredPacket>  to_client;
+
+    std::atomic<bool>           server_closed;
+    std::atomic<bool>           client_closed;
+};
+
+/*
+    Instance side of a client in the same process (embedded server mode).
+
+    Packets are moved through lock free queues: a frame reaches the client
+    as the FrameSnapshot the game loop built, with its FrameAck next to it,
+    without serialization, socket or system call in between. Sending never blocks, so the FrameSender sends
+    from the game loop; a frame the client has no room for waits there and
+    is replaced by the next one.
+*/
+class LocalTransport : public Transport {
+public:
+    explicit LocalTransport(std::shared_ptr<LocalChannel> channel);
+    ~LocalTransport() override;
+
+    void start() override;
+    void stop() override;
+
+    std::optional<ReceivedPacket> poll_packet() override;
+    bool send_packet(Packet packet) override;
+    bool send_game_response(Packet packet, const ResumeToken& token) override;
+    bool send_frame(Packet packet, const FrameAck& ack) override;
+
+    bool sends_inline() const override { return true; }
+    bool try_send_frame(Packet& packet, const FrameAck& ack) override;
+
+    std::exception_ptr get_recv_exception() const override { return nullptr; }
+    bool is_running() const override;
+
+    void disconnect() override;
+
+private:
+    bool push(DeliveredPacket delivered);
+
+    std::shared_ptr<LocalChannel>   m_channel;
+    std::atomic<bool>               m_running;
+};
+
+/*
+    Client side of a LocalTransport, used by one client thread.
+*/
+class LocalClient {
+public:
+    explicit LocalClient(std::shared_ptr<LocalChannel> channel);
+    ~LocalClient();
+
+    LocalClient(const LocalClient&) = delete;
+    LocalClient& operator=(const LocalClient&) = delete;
+
+    // False if the instance is behind on its inputs or gone
+    bool send_packet(
+        Packet packet,
+        std::optional<InputStamp> input_stamp = std::nullopt,
+        std::optional<PongStamp> pong_stamp = std::nullopt
+    );
+
+    // A ClientGameRequest resuming the game of the token
+    bool send_game_request(const ResumeToken& resume_token);
+
+    std::optional<DeliveredPacket> poll_packet();
+
+    bool is_connected() const;
+    void disconnect();
+
+private:
+    std::shared_ptr<LocalChannel>   m_channel;
+};
+
+// A connected pair, the transport goes to the game instance
+std::pair<std::shared_ptr<LocalTransport>, std::shared_ptr<LocalClient>> make_local_connection();
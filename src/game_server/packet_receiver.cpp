@@ -0,0 +1,336 @@
+#include "packet_receiver.hpp"
+#include "payload_limits.hpp"
+#include "game_server_constants.hpp"
+#include "latency_estimator.hpp"
+#include <cstring>      // std::memcpy, std::strerror
+#include <cerrno>
+#include <algorithm>    // std::min
+#include <stdexcept>
+#include <string>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+namespace {
+    /*
+        The client payloads are trivially copyable and the packet library
+        writes them, like the header, as their bytes in host order. This reads
+        them back the same way, which only holds while both sides are built
+        with the same struct layout (padding included) on hosts of the same
+        byte order. DecodesWhatThePacketLibrarySerializes checks it against
+        the library of the build. A shorter payload leaves the rest zeroed.
+    */
+    template <typename T>
+    T decode_payload(const uint8_t* payload, uint32_t payload_size) {
+        T value{};
+        std::memcpy(&value, payload, std::min<size_t>(payload_size, sizeof(T)));
+
+        return value;
+    }
+
+    // Magic and version of the packet library of this build, as make_packet() stamps them
+    const PacketHeader& reference_header() {
+        static const auto header = make_packet<ClientGoodbye>({}).header;
+
+        return header;
+    }
+}
+
+PacketReceiver::PacketReceiver(std::shared_ptr<ClientConnection> client_conn, ReceiveBufferPool& pool)
+    : m_client_conn(std::move(client_conn))
+    , m_budget(pool, receive_constants::BLOCKS_PER_CONNECTION)
+    , m_recv_exception(nullptr)
+    , m_running(false)
+    , m_wake_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    if (m_wake_fd < 0)
+    {
+        throw std::runtime_error("[PacketReceiver] eventfd failed: " + std::string(std::strerror(errno)));
+    }
+}
+
+PacketReceiver::~PacketReceiver() {
+    stop();
+
+    close(m_wake_fd);
+}
+
+void PacketReceiver::start() {
+    if (m_running)
+    {
+        return;
+    }
+
+    // A wake up left from an earlier stop()
+    uint64_t wakes = 0;
+    while (read(m_wake_fd, &wakes, sizeof(wakes)) > 0) {}
+
+    m_running = true;
+    m_worker = std::thread(&PacketReceiver::receiving_worker, this);
+}
+
+void PacketReceiver::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    m_cv.notify_all();
+
+    // Out of poll() without touching the socket, the successor may still read from it
+    const uint64_t wake = 1;
+    [[maybe_unused]] const auto written = write(m_wake_fd, &wake, sizeof(wake));
+
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+std::optional<ReceivedPacket> PacketReceiver::poll_packet() {
+    std::optional<ReceivedPacket> packet_opt;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_queue.empty())
+        {
+            return std::nullopt;
+        }
+
+        packet_opt = std::move(m_queue.front());
+        m_queue.pop_front();
+    }
+
+    m_cv.notify_one();
+
+    return packet_opt;
+}
+
+std::exception_ptr PacketReceiver::get_recv_exception() const {
+    std::lock_guard<std::mutex> lock(const_cast<std::mutex&>(m_mutex));
+
+    return m_recv_exception;
+}
+
+size_t PacketReceiver::get_memory_budget() {
+    return receive_constants::BLOCKS_PER_CONNECTION * payload_limits::RECEIVE_BLOCK_SIZE
+         + receive_constants::MAX_QUEUED_PACKETS * sizeof(Packet);
+}
+
+void PacketReceiver::receiving_worker() {
+    try
+    {
+        while (m_running)
+        {
+            PacketHeader header{};
+
+            if (!recv_exact(&header, sizeof(header), false))
+            {
+                break;
+            }
+
+            // Not a packet of ours, the size can not be trusted either
+            const auto& reference = reference_header();
+
+            if (header.magic != reference.magic || header.version != reference.version)
+            {
+                throw std::runtime_error(
+                    "[PacketReceiver] Bad packet header: magic " + std::to_string(header.magic)
+                    + ", version " + std::to_string(header.version)
+                );
+            }
+
+            // Nothing has been allocated for the payload yet
+            const auto max_payload_size = payload_limits::max_client_payload_size(header.payload_type);
+
+            if (max_payload_size == 0)
+            {
+                throw std::runtime_error(
+                    "[PacketReceiver] Unexpected payload type: "
+                    + std::to_string(static_cast<uint32_t>(header.payload_type))
+                );
+            }
+
+            if (header.payload_size > max_payload_size)
+            {
+                throw std::runtime_error(
+                    "[PacketReceiver] Payload of " + std::to_string(header.payload_size)
+                    + " bytes exceeds the limit of " + std::to_string(max_payload_size)
+                    + " bytes for type " + std::to_string(static_cast<uint32_t>(header.payload_type))
+                );
+            }
+
+            auto* block = m_budget.acquire();
+
+            if (block == nullptr)
+            {
+                throw std::runtime_error("[PacketReceiver] Receive buffer pool exhausted");
+            }
+
+            std::optional<ReceivedPacket> packet_opt;
+
+            if (recv_exact(block, header.payload_size, true))
+            {
+                packet_opt = decode(header, block);
+                packet_opt->received_usec = LatencyEstimator::now_usec();
+            }
+
+            m_budget.release(block);
+
+            if (!packet_opt.has_value())
+            {
+                break;
+            }
+
+            // Stop reading the socket while the game loop is behind
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_cv.wait(lock, [this] {
+                return !m_running || m_queue.size() < receive_constants::MAX_QUEUED_PACKETS;
+            });
+
+            // Queued even when stopping, the packet has been taken off the socket already
+            m_queue.push_back(std::move(*packet_opt));
+        }
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recv_exception = std::current_exception();
+    }
+
+    m_running = false;
+}
+
+bool PacketReceiver::recv_exact(void* data, size_t size, bool in_packet) {
+    auto* bytes = static_cast<uint8_t*>(data);
+    size_t received = 0;
+    int idle_polls_while_stopping = 0;
+
+    const auto fd = m_client_conn->get_socket();
+
+    while (received < size)
+    {
+        const auto at_boundary = !in_packet && received == 0;
+
+        // Stop between packets, so the rest of the stream stays intact for a successor
+        if (!m_running && at_boundary)
+        {
+            return false;
+        }
+
+        // stop() wakes the wait through the eventfd. Once stopping, only the socket is
+        // waited on, so the grace period below is counted in whole polls
+        pollfd pfds[2]{};
+        pfds[0].fd = fd;
+        pfds[0].events = POLLIN;
+        pfds[1].fd = m_wake_fd;
+        pfds[1].events = POLLIN;
+
+        const nfds_t count = m_running ? 2 : 1;
+        const auto ready = ::poll(pfds, count, receive_constants::POLL_TIMEOUT_MSEC);
+        const auto socket_ready = ready > 0 && pfds[0].revents != 0;
+
+        // A client stalled in the middle of a packet is given up on after a grace period
+        if (!m_running)
+        {
+            if (at_boundary || (!socket_ready && ++idle_polls_while_stopping > receive_constants::STOP_GRACE_POLLS))
+            {
+                return false;
+            }
+        }
+
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            throw std::runtime_error("[PacketReceiver] poll failed: " + std::string(std::strerror(errno)));
+        }
+
+        if (!socket_ready)
+        {
+            continue;
+        }
+
+        const auto n = ::recv(fd, bytes + received, size - received, 0);
+
+        if (n == 0)
+        {
+            throw std::runtime_error("[PacketReceiver] Connection closed by the client");
+        }
+
+        if (n < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                continue;
+            }
+
+            throw std::runtime_error("[PacketReceiver] recv failed: " + std::string(std::strerror(errno)));
+        }
+
+        received += static_cast<size_t>(n);
+    }
+
+    return true;
+}
+
+ReceivedPacket PacketReceiver::decode(const PacketHeader& header, const uint8_t* payload) const {
+    ReceivedPacket received{};
+    auto& packet = received.packet;
+    packet.header = header;
+
+    switch (header.payload_type)
+    {
+        case PayloadType::ClientHello:
+            packet.payload = decode_payload<ClientHello>(payload, header.payload_size);
+            break;
+
+        case PayloadType::ClientGameRequest:
+        {
+            packet.payload = decode_payload<ClientGameRequest>(payload, header.payload_size);
+
+            // A client resuming its game after a crash of the server
+            if (header.payload_size == sizeof(ClientGameRequest) + sizeof(ResumeToken))
+            {
+                received.resume_token = decode_payload<ResumeToken>(payload + sizeof(ClientGameRequest), sizeof(ResumeToken));
+            }
+
+            break;
+        }
+
+        case PayloadType::ClientInput:
+        {
+            packet.payload = decode_payload<ClientInput>(payload, header.payload_size);
+
+            // Sequenced input, the stamp follows the input and may be followed by an echo
+            const auto* stamps = payload + sizeof(ClientInput);
+
+            if (header.payload_size >= sizeof(ClientInput) + sizeof(InputStamp))
+            {
+                received.input_stamp = decode_payload<InputStamp>(stamps, sizeof(InputStamp));
+            }
+
+            if (header.payload_size == sizeof(ClientInput) + sizeof(InputStamp) + sizeof(PongStamp))
+            {
+                received.pong_stamp = decode_payload<PongStamp>(stamps + sizeof(InputStamp), sizeof(PongStamp));
+            }
+
+            break;
+        }
+
+        case PayloadType::ClientGoodbye:
+            packet.payload = decode_payload<ClientGoodbye>(payload, header.payload_size);
+            break;
+
+        default:
+            throw std::runtime_error("[PacketReceiver] No decoder for the payload type");
+    }
+
+    return received;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <deque>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <socket/socket.hpp>
+#include <packet_template/packet_template.hpp>
+#include "receive_buffer_pool.hpp"
+#include "transport.hpp"
+
+/*
+    Receive side of a single connection.
+
+    The header is validated before anything is allocated for the payload: a
+    magic or version other than the one of this build, a payload type the
+    server does not expect from a client, or a size above the limit of that
+    type, ends the connection. Payloads are read into a buffer
+    from the connection's share of the receive pool, and the decoded packets
+    wait in a bounded queue. Once it is full the socket is no longer read and
+    TCP pushes back on the client, so a connection never holds more than
+    `get_memory_budget()` bytes of receive state.
+
+    The header and the payloads are read as the bytes of their structs, see
+    decode_payload() in packet_receiver.cpp for what that assumes of the
+    packet library.
+
+    stop() wakes the receiving thread through an eventfd, so a receiver
+    waiting between two packets stops right away and the socket is left
+    open and intact for a successor.
+*/
+class PacketReceiver {
+public:
+    PacketReceiver(std::shared_ptr<ClientConnection> client_conn, ReceiveBufferPool& pool);
+    ~PacketReceiver();
+
+    void start();
+    void stop();
+
+    std::optional<ReceivedPacket> poll_packet();
+
+    std::exception_ptr get_recv_exception() const;
+    bool is_running() const { return m_running; }
+
+    static size_t get_memory_budget();
+
+private:
+    void receiving_worker();
+    bool recv_exact(void* data, size_t size, bool in_packet);
+    ReceivedPacket decode(const PacketHeader& header, const uint8_t* payload) const;
+
+    std::shared_ptr<ClientConnection>   m_client_conn;
+    ReceiveBudget                       m_budget;
+
+    // Decoded packets
+    std::mutex                          m_mutex;
+    std::condition_variable             m_cv;
+    std::deque<ReceivedPacket>          m_queue;
+
+    std::exception_ptr                  m_recv_exception;
+    std::atomic<bool>                   m_running;
+    int                                 m_wake_fd;      // Readable once stop() has been called
+    std::thread                         m_worker;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>    // std::max
+#include <packet_template/packet_template.hpp>
+#include "input_sequence.hpp"
+#include "resume_token.hpp"
+
+/*
+    Largest payload the server accepts for each payload type a client may send.
+    Everything else is rejected from the header alone, before anything is allocated.
+*/
+namespace payload_limits {
+    constexpr uint32_t max_client_payload_size(PayloadType payload_type) {
+        switch (payload_type)
+        {
+            case PayloadType::ClientHello:          return sizeof(ClientHello);
+            case PayloadType::ClientGameRequest:    return sizeof(ClientGameRequest) + sizeof(ResumeToken);
+            case PayloadType::ClientInput:          return sizeof(ClientInput) + sizeof(InputStamp) + sizeof(PongStamp);
+            case PayloadType::ClientGoodbye:        return sizeof(ClientGoodbye);
+            default:                                return 0;
+        }
+    }
+
+    constexpr uint32_t MAX_CLIENT_PAYLOAD_SIZE = std::max({
+        max_client_payload_size(PayloadType::ClientHello),
+        max_client_payload_size(PayloadType::ClientGameRequest),
+        max_client_payload_size(PayloadType::ClientInput),
+        max_client_payload_size(PayloadType::ClientGoodbye),
+    });
+
+    // Blocks of the receive pool hold the largest of them
+    constexpr size_t RECEIVE_BLOCK_SIZE = (MAX_CLIENT_PAYLOAD_SIZE + 63) / 64 * 64;
+
+    constexpr bool is_client_payload(PayloadType payload_type) {
+        return max_client_payload_size(payload_type) > 0;
+    }
+}
@@ -0,0 +1,78 @@
+#include "receive_buffer_pool.hpp"
+
+ReceiveBufferPool::ReceiveBufferPool(size_t block_size, size_t block_count)
+    : m_block_size(block_size)
+    , m_block_count(block_count)
+    , m_storage(block_size * block_count)
+{
+    m_free_blocks.reserve(block_count);
+
+    for (size_t i = 0; i < block_count; i++)
+    {
+        m_free_blocks.push_back(m_storage.data() + i * block_size);
+    }
+}
+
+uint8_t* ReceiveBufferPool::acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_free_blocks.empty())
+    {
+        return nullptr;
+    }
+
+    auto* block = m_free_blocks.back();
+    m_free_blocks.pop_back();
+
+    return block;
+}
+
+void ReceiveBufferPool::release(uint8_t* block) {
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_free_blocks.push_back(block);
+}
+
+size_t ReceiveBufferPool::get_available() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_free_blocks.size();
+}
+
+ReceiveBudget::ReceiveBudget(ReceiveBufferPool& pool, size_t max_blocks)
+    : m_pool(pool)
+    , m_max_blocks(max_blocks)
+    , m_in_use(0)
+{}
+
+ReceiveBudget::~ReceiveBudget() = default;
+
+uint8_t* ReceiveBudget::acquire() {
+    if (m_in_use >= m_max_blocks)
+    {
+        return nullptr;
+    }
+
+    auto* block = m_pool.acquire();
+
+    if (block != nullptr)
+    {
+        m_in_use++;
+    }
+
+    return block;
+}
+
+void ReceiveBudget::release(uint8_t* block) {
+    if (block == nullptr)
+    {
+        return;
+    }
+
+    m_pool.release(block);
+    m_in_use--;
+}
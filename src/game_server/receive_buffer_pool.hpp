@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+
+/*
+    Fixed budget of receive buffers, allocated once when the server starts.
+    Every connection may hold at most `max_blocks` of them at a time, so the
+    receive memory of a session is known up front and does not depend on
+    what a client claims in a header.
+*/
+class ReceiveBufferPool {
+public:
+    ReceiveBufferPool(size_t block_size, size_t block_count);
+
+    ReceiveBufferPool(const ReceiveBufferPool&) = delete;
+    ReceiveBufferPool& operator=(const ReceiveBufferPool&) = delete;
+
+    uint8_t* acquire();     // nullptr once the pool is exhausted
+    void release(uint8_t* block);
+
+    size_t get_block_size() const { return m_block_size; }
+    size_t get_block_count() const { return m_block_count; }
+    size_t get_available() const;
+
+private:
+    size_t                  m_block_size;
+    size_t                  m_block_count;
+    std::vector<uint8_t>    m_storage;
+
+    mutable std::mutex      m_mutex;
+    std::vector<uint8_t*>   m_free_blocks;
+};
+
+// Per-connection share of the pool
+class ReceiveBudget {
+public:
+    ReceiveBudget(ReceiveBufferPool& pool, size_t max_blocks);
+    ~ReceiveBudget();
+
+    ReceiveBudget(const ReceiveBudget&) = delete;
+    ReceiveBudget& operator=(const ReceiveBudget&) = delete;
+
+    uint8_t* acquire();     // nullptr if over budget or the pool is exhausted
+    void release(uint8_t* block);
+
+    size_t get_block_size() const { return m_pool.get_block_size(); }
+    size_t get_in_use() const { return m_in_use; }
+
+private:
+    ReceiveBufferPool&  m_pool;
+    size_t              m_max_blocks;
+    size_t              m_in_use;
+};
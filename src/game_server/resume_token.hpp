@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+    Names a game to its client across a crash of the server.
+
+    Follows the ServerGameResponse payload of every game. A client that lost
+    its connection appends it to the ClientGameRequest payload when it
+    connects again: if the server restarted from a crash checkpoint that holds
+    the game, the game continues from there, otherwise a new game starts
+    (with a new token).
+
+    The token is part of the session state, so it stays the same when the
+    session is handed over or restored.
+*/
+struct ResumeToken {
+    uint64_t instance_id;   // Of the instance that started the game, unique within its process only
+    uint64_t secret;        // Random, the instance id alone does not resume a game
+
+    bool operator==(const ResumeToken& other) const { return instance_id == other.instance_id && secret == other.secret; }
+    bool operator!=(const ResumeToken& other) const { return !(*this == other); }
+};
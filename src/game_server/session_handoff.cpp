@@ -0,0 +1,406 @@
+#include "session_handoff.hpp"
+#include "diag_logger.hpp"
+
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+namespace {
+    bool make_address(const std::string& path, sockaddr_un& addr) {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+
+        if (path.size() >= sizeof(addr.sun_path))
+        {
+            DIAG_ERROR("SessionHandoff", "Socket path is too long: " << path);
+
+            return false;
+        }
+
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+
+        return true;
+    }
+
+    bool send_all(int fd, const uint8_t* data, size_t size) {
+        while (size > 0)
+        {
+            const auto sent = send(fd, data, size, MSG_NOSIGNAL);
+
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            data += sent;
+            size -= static_cast<size_t>(sent);
+        }
+
+        return true;
+    }
+
+    bool recv_all(int fd, uint8_t* data, size_t size) {
+        while (size > 0)
+        {
+            const auto received = recv(fd, data, size, 0);
+
+            if (received < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (received <= 0)
+            {
+                return false;
+            }
+
+            data += received;
+            size -= static_cast<size_t>(received);
+        }
+
+        return true;
+    }
+
+    // Created if missing. Anyone else who may enter it could connect, or put a socket of their own in place
+    bool ensure_private_directory(const std::string& path) {
+        const auto slash = path.find_last_of('/');
+        const auto dir = slash == std::string::npos ? std::string(".") : path.substr(0, slash == 0 ? 1 : slash);
+
+        if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)
+        {
+            DIAG_ERROR("SessionHandoff", "Failed to create " << dir << ": " << std::strerror(errno));
+
+            return false;
+        }
+
+        struct stat st = {};
+
+        if (lstat(dir.c_str(), &st) != 0 || !S_ISDIR(st.st_mode) || st.st_uid != geteuid() || (st.st_mode & 077) != 0)
+        {
+            DIAG_ERROR("SessionHandoff", dir << " is not a directory private to this user, session handoff is disabled");
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool is_same_user(int fd) {
+        ucred cred = {};
+        socklen_t size = sizeof(cred);
+
+        return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &size) == 0 && cred.uid == geteuid();
+    }
+
+    std::string get_token_path(const std::string& path) {
+        return path + ".token";
+    }
+
+    bool write_token(const std::string& path, HandoffToken& token) {
+        if (getrandom(token.data(), token.size(), 0) != static_cast<ssize_t>(token.size()))
+        {
+            return false;
+        }
+
+        const int fd = open(get_token_path(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        // A file left from before may have been created with another mode
+        const auto written = fchmod(fd, 0600) == 0 && write(fd, token.data(), token.size()) == static_cast<ssize_t>(token.size());
+        close(fd);
+
+        return written;
+    }
+
+    bool read_token(const std::string& path, HandoffToken& token) {
+        const int fd = open(get_token_path(path).c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        const auto read_all = read(fd, token.data(), token.size()) == static_cast<ssize_t>(token.size());
+        close(fd);
+
+        return read_all;
+    }
+
+    // 0 waits for as long as it takes
+    void set_recv_timeout(int fd, uint32_t timeout_msec) {
+        timeval timeout = {};
+        timeout.tv_sec = timeout_msec / 1000;
+        timeout.tv_usec = (timeout_msec % 1000) * 1000;
+
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    // Sends the size prefix of a message, with the client socket attached if there is one
+    bool send_header(int handoff_fd, int client_fd, uint32_t size) {
+        iovec iov = {};
+        iov.iov_base = &size;
+        iov.iov_len = sizeof(size);
+
+        msghdr msg = {};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+        if (client_fd >= 0)
+        {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(cmsg), &client_fd, sizeof(int));
+        }
+
+        while (true)
+        {
+            const auto sent = sendmsg(handoff_fd, &msg, MSG_NOSIGNAL);
+
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            return sent == static_cast<ssize_t>(sizeof(size));
+        }
+    }
+}
+
+int open_handoff_listener(const std::string& path, HandoffToken& token) {
+    sockaddr_un addr;
+
+    if (!make_address(path, addr) || !ensure_private_directory(path))
+    {
+        return -1;
+    }
+
+    // Before the socket exists, a successor never reads the token of an earlier server
+    if (!write_token(path, token))
+    {
+        DIAG_ERROR("SessionHandoff", "Failed to write the handoff token " << get_token_path(path) << ": " << std::strerror(errno));
+
+        return -1;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    // A stale socket file, or the one of the server we took over from
+    unlink(path.c_str());
+
+    // The directory keeps the others out already, the mode is a second line
+    if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || chmod(path.c_str(), 0600) != 0 || listen(fd, 1) != 0)
+    {
+        DIAG_ERROR("SessionHandoff", "Failed to listen on " << path << ": " << std::strerror(errno));
+
+        close(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
+int accept_handoff(int listen_fd, const HandoffToken& token) {
+    while (true)
+    {
+        const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+
+        if (fd < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (fd < 0)
+        {
+            return -1;
+        }
+
+        // The peer would get every live client, anyone but a successor of ours is turned away
+        if (!is_same_user(fd))
+        {
+            DIAG_ERROR("SessionHandoff", "Refused a handoff connection of another user");
+
+            close(fd);
+
+            continue;
+        }
+
+        HandoffToken received = {};
+        set_recv_timeout(fd, handoff_constants::TOKEN_TIMEOUT_MSEC);
+
+        if (!recv_all(fd, received.data(), received.size()) || received != token)
+        {
+            DIAG_ERROR("SessionHandoff", "Refused a handoff connection without the token");
+
+            close(fd);
+
+            continue;
+        }
+
+        set_recv_timeout(fd, 0);
+
+        return fd;
+    }
+}
+
+int connect_handoff(const std::string& path) {
+    sockaddr_un addr;
+    HandoffToken token = {};
+
+    if (!make_address(path, addr))
+    {
+        return -1;
+    }
+
+    if (!read_token(path, token))
+    {
+        DIAG_ERROR("SessionHandoff", "Failed to read the handoff token " << get_token_path(path) << ": " << std::strerror(errno));
+
+        return -1;
+    }
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+        DIAG_ERROR("SessionHandoff", "Failed to connect to " << path << ": " << std::strerror(errno));
+
+        close(fd);
+
+        return -1;
+    }
+
+    // Sessions are only taken from, and the token only given to, a server of the same user
+    if (!is_same_user(fd) || !send_all(fd, token.data(), token.size()))
+    {
+        DIAG_ERROR("SessionHandoff", "The server at " << path << " is not one of this user");
+
+        close(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
+bool send_session(int handoff_fd, int client_fd, const std::vector<uint8_t>& state) {
+    if (client_fd < 0 || state.empty())
+    {
+        return false;
+    }
+
+    const auto size = static_cast<uint32_t>(state.size());
+
+    return send_header(handoff_fd, client_fd, size) && send_all(handoff_fd, state.data(), state.size());
+}
+
+bool send_handoff_end(int handoff_fd) {
+    return send_header(handoff_fd, -1, 0);
+}
+
+bool recv_session(int handoff_fd, int& client_fd, std::vector<uint8_t>& state) {
+    client_fd = -1;
+
+    uint32_t size = 0;
+
+    iovec iov = {};
+    iov.iov_base = &size;
+    iov.iov_len = sizeof(size);
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t received = 0;
+
+    do
+    {
+        received = recvmsg(handoff_fd, &msg, MSG_CMSG_CLOEXEC | MSG_WAITALL);
+    }
+    while (received < 0 && errno == EINTR);
+
+    if (received != static_cast<ssize_t>(sizeof(size)))
+    {
+        return false;
+    }
+
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        {
+            std::memcpy(&client_fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    // End of the handoff
+    if (size == 0)
+    {
+        if (client_fd >= 0)
+        {
+            close(client_fd);
+            client_fd = -1;
+        }
+
+        state.clear();
+
+        return true;
+    }
+
+    state.resize(size);
+
+    if (client_fd < 0 || !recv_all(handoff_fd, state.data(), state.size()))
+    {
+        if (client_fd >= 0)
+        {
+            close(client_fd);
+            client_fd = -1;
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+void close_handoff(int fd) {
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
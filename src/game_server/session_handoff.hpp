@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <string>
+#include <vector>
+#include "../config_constants.hpp"
+
+/*
+    Unix domain socket channel used to hand live sessions over to another
+    server process on the same host. Every message carries the serialized
+    session and the client socket itself (SCM_RIGHTS), an empty message
+    without a socket marks the end of the handoff.
+
+    Whoever is accepted gets every live client, so the socket is created
+    with mode 0600 in a directory only this user may enter, and a peer is
+    accepted only if it runs as the same user (SO_PEERCRED) and sends the
+    token the listener wrote next to the socket (`<path>.token`, mode 0600).
+    Any other connection is closed and the listener keeps waiting.
+*/
+using HandoffToken = std::array<uint8_t, handoff_constants::TOKEN_SIZE>;
+
+int open_handoff_listener(const std::string& path, HandoffToken& token);
+int accept_handoff(int listen_fd, const HandoffToken& token);
+int connect_handoff(const std::string& path);
+
+bool send_session(int handoff_fd, int client_fd, const std::vector<uint8_t>& state);
+bool send_handoff_end(int handoff_fd);
+
+// client_fd is -1 once the end of the handoff has been received
+bool recv_session(int handoff_fd, int& client_fd, std::vector<uint8_t>& state);
+
+void close_handoff(int fd);
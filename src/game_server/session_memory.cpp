@@ -0,0 +1,67 @@
+#include "session_memory.hpp"
+
+#include "game_server_constants.hpp"
+
+AccountingResource::AccountingResource(size_t cap, std::pmr::memory_resource* upstream)
+    : m_upstream(upstream)
+    , m_cap(cap)
+    , m_allocated(0)
+    , m_external(0)
+    , m_high_water(0)
+{}
+
+void AccountingResource::set_external_bytes(size_t bytes) {
+    if (m_allocated + bytes > m_cap)
+    {
+        throw SessionMemoryExceeded();
+    }
+
+    m_external = bytes;
+    add(0);
+}
+
+SessionMemoryUsage AccountingResource::get_usage() const {
+    return { m_allocated + m_external, m_high_water, m_cap };
+}
+
+void* AccountingResource::do_allocate(size_t bytes, size_t alignment) {
+    if (m_allocated + m_external + bytes > m_cap)
+    {
+        throw SessionMemoryExceeded();
+    }
+
+    auto* p = m_upstream->allocate(bytes, alignment);
+    add(bytes);
+
+    return p;
+}
+
+void AccountingResource::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    m_upstream->deallocate(p, bytes, alignment);
+    m_allocated -= bytes;
+}
+
+bool AccountingResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void AccountingResource::add(size_t bytes) {
+    const auto in_use = (m_allocated += bytes) + m_external;
+    auto high_water = m_high_water.load();
+
+    while (in_use > high_water && !m_high_water.compare_exchange_weak(high_water, in_use))
+    {
+    }
+}
+
+SessionMemory::SessionMemory(size_t cap)
+    : m_accounting(cap)
+    , m_pool(&m_accounting)
+    , m_scratch_buffer(m_accounting.allocate(memory_constants::SCRATCH_BLOCK_BYTES))
+    , m_scratch(m_scratch_buffer, memory_constants::SCRATCH_BLOCK_BYTES, &m_accounting)
+{}
+
+SessionMemory::~SessionMemory() {
+    m_scratch.release();
+    m_accounting.deallocate(m_scratch_buffer, memory_constants::SCRATCH_BLOCK_BYTES);
+}
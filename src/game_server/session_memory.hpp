@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>          // std::bad_alloc
+#include <memory_resource>
+
+struct SessionMemoryUsage {
+    size_t in_use;      // Bytes, including the frame vectors
+    size_t high_water;
+    size_t cap;
+};
+
+// Thrown by an allocation that would take a session over its cap
+class SessionMemoryExceeded : public std::bad_alloc {
+public:
+    const char* what() const noexcept override { return "Session memory cap exceeded"; }
+};
+
+/*
+    Counts what a session takes from the global heap and enforces its cap.
+    Memory the session can not allocate through a resource (the vectors of
+    the shared FrameSnapshot) is reported as external bytes and counts too.
+*/
+class AccountingResource : public std::pmr::memory_resource {
+public:
+    AccountingResource(size_t cap, std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+
+    void set_external_bytes(size_t bytes);  // Throws SessionMemoryExceeded over the cap
+
+    SessionMemoryUsage get_usage() const;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    void add(size_t bytes);
+
+    std::pmr::memory_resource*  m_upstream;
+    size_t                      m_cap;
+    std::atomic<size_t>         m_allocated;
+    std::atomic<size_t>         m_external;
+    std::atomic<size_t>         m_high_water;
+};
+
+/*
+    Memory of a single game instance.
+
+    Containers that live as long as the session allocate from `pool()`.
+    Scratch that is only needed within a tick allocates from `scratch()`,
+    a bump allocator that is rewound by end_tick(). Both draw from the
+    accounting resource, so the usage of every session is known and a
+    runaway session hits its cap instead of the host.
+*/
+class SessionMemory {
+public:
+    explicit SessionMemory(size_t cap);
+    ~SessionMemory();
+
+    SessionMemory(const SessionMemory&) = delete;
+    SessionMemory& operator=(const SessionMemory&) = delete;
+
+    std::pmr::memory_resource* pool() { return &m_pool; }
+    std::pmr::memory_resource* scratch() { return &m_scratch; }
+
+    void end_tick() { m_scratch.release(); }
+
+    void set_external_bytes(size_t bytes) { m_accounting.set_external_bytes(bytes); }
+    SessionMemoryUsage get_usage() const { return m_accounting.get_usage(); }
+
+private:
+    AccountingResource                      m_accounting;
+    std::pmr::unsynchronized_pool_resource  m_pool;
+
+    // The first scratch block is kept across ticks, larger ticks chain more from the accounting resource
+    void*                                   m_scratch_buffer;
+    std::pmr::monotonic_buffer_resource     m_scratch;
+};
@@ -0,0 +1,194 @@
+#include <thread>
+#include <chrono>
+
+#include "game_server.hpp"
+#include "session_handoff.hpp"
+#include "state_codec.hpp"
+#include "socket_transport.hpp"
+#include "diag_logger.hpp"
+#include "../config_constants.hpp"
+
+/*
+    Zero-downtime drain
+
+    1. The successor process connects to the handoff socket of the running server (take_over).
+    2. The running server stops accepting and releases the server port, the successor binds it.
+    3. Every instance thread finishes its current tick, serializes its session and passes it
+       together with the client socket to the successor, which resumes it right away.
+    4. Once no instance is left, the end of the handoff is sent and the old server exits.
+       Instances still in the handshake and in process clients end instead of being handed over,
+       and the old server stops waiting for the rest after DRAIN_TIMEOUT_MSEC.
+*/
+bool GameServerMaster::enable_session_handoff(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+        if (m_handoff_listen_fd >= 0)
+        {
+            return true;
+        }
+
+        m_handoff_listen_fd = open_handoff_listener(path, m_handoff_token);
+
+        if (m_handoff_listen_fd < 0)
+        {
+            return false;
+        }
+    }
+
+    m_handoff_thread = std::thread(&GameServerMaster::handoff_loop, this);
+
+    DIAG_DEBUG("GameServerMaster", "Session handoff is available at " << path);
+
+    return true;
+}
+
+bool GameServerMaster::take_over(const std::string& path) {
+    const int predecessor_fd = connect_handoff(path);
+
+    if (predecessor_fd < 0)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+        m_predecessor_fd = predecessor_fd;
+    }
+
+    DIAG_DEBUG("GameServerMaster", "Taking the sessions over from " << path);
+
+    return true;
+}
+
+void GameServerMaster::handoff_loop() {
+    // Only this thread closes the listener, stop() shuts it down under the mutex to wake the accept
+    int listen_fd = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+        listen_fd = m_handoff_listen_fd;
+    }
+
+    // Block until a successor shows up
+    const int successor_fd = accept_handoff(listen_fd, m_handoff_token);
+
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+        close_handoff(m_handoff_listen_fd);
+        m_handoff_listen_fd = -1;
+
+        if (successor_fd < 0)
+        {
+            return;
+        }
+
+        m_successor_fd = successor_fd;
+    }
+
+    DIAG_DEBUG("GameServerMaster", "A successor has connected, draining "
+                                   << m_active_instances << " instances");
+
+    // Release the server port for the successor, this also wakes the accept loop up
+    m_draining = true;
+    m_server_socket->disconnect();
+}
+
+void GameServerMaster::adopt_loop() {
+    // Only this thread closes the handoff connection, stop() shuts it down under the mutex
+    int predecessor_fd = -1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_handoff_mutex);
+        predecessor_fd = m_predecessor_fd;
+    }
+
+    while (m_running)
+    {
+        int client_fd = -1;
+        std::vector<uint8_t> state;
+
+        if (!recv_session(predecessor_fd, client_fd, state))
+        {
+            DIAG_ERROR("GameServerMaster", "The session handoff has been interrupted");
+
+            break;
+        }
+
+        if (client_fd < 0)
+        {
+            DIAG_DEBUG("GameServerMaster", "The session handoff has been completed");
+
+            break;
+        }
+
+        auto client_conn = std::make_shared<ClientConnection>(client_fd);
+        auto session = std::make_unique<GameSession>(0, m_stage_timeline);
+
+        StateReader reader(state);
+
+        if (!session->deserialize(reader))
+        {
+            DIAG_ERROR("GameServerMaster", "Incompatible session state, the client has been disconnected");
+
+            client_conn->disconnect();
+
+            continue;
+        }
+
+        // Adopted sessions are not subject to admission, they were running already
+        uint64_t instance_id = 0;
+
+        {
+            std::lock_guard<std::mutex> lock(m_admission_mutex);
+
+            instance_id = m_next_instance_id++;
+            m_admission.add_instance(instance_id, AdmissionController::Clock::now());
+        }
+
+        spawn_instance(std::make_shared<SocketTransport>(client_conn, m_receive_pool), instance_id, std::move(session));
+    }
+
+    std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+    close_handoff(m_predecessor_fd);
+    m_predecessor_fd = -1;
+}
+
+bool GameServerMaster::hand_off_session(int client_fd, const GameSession& session) {
+    StateWriter writer;
+    session.serialize(writer);
+
+    std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+    if (m_successor_fd < 0)
+    {
+        return false;
+    }
+
+    return send_session(m_successor_fd, client_fd, writer.get_buffer());
+}
+
+void GameServerMaster::finish_handoff() {
+    {
+        std::unique_lock<std::mutex> lock(m_instances_mutex);
+
+        const auto drained = m_instances_cv.wait_for(lock, std::chrono::milliseconds(handoff_constants::DRAIN_TIMEOUT_MSEC), [this]() {
+            return m_active_instances == 0;
+        });
+
+        if (!drained)
+        {
+            DIAG_ERROR("GameServerMaster", m_active_instances << " instances have not been handed over in time, they are dropped");
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_handoff_mutex);
+
+    send_handoff_end(m_successor_fd);
+    close_handoff(m_successor_fd);
+    m_successor_fd = -1;
+
+    DIAG_DEBUG("GameServerMaster", "Every session has been handed over");
+}
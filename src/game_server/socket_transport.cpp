@@ -0,0 +1,94 @@
+#include "socket_transport.hpp"
+#include "game_server_constants.hpp"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+
+namespace {
+    bool send_all(int fd, const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+
+        while (size > 0)
+        {
+            const auto sent = send(fd, bytes, size, MSG_NOSIGNAL);
+
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                // In steps, a disconnect() from another thread fails the next send
+                pollfd pfd{ fd, POLLOUT, 0 };
+                poll(&pfd, 1, receive_constants::POLL_TIMEOUT_MSEC);
+
+                continue;
+            }
+
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            bytes += sent;
+            size -= static_cast<size_t>(sent);
+        }
+
+        return true;
+    }
+}
+
+SocketTransport::SocketTransport(std::shared_ptr<ClientConnection> client_conn, ReceiveBufferPool& pool)
+    : m_client_conn(client_conn)
+    , m_packet_stream(client_conn)
+    , m_packet_receiver(client_conn, pool)
+{}
+
+void SocketTransport::start() {
+    m_packet_receiver.start();
+}
+
+void SocketTransport::stop() {
+    m_packet_receiver.stop();
+}
+
+std::optional<ReceivedPacket> SocketTransport::poll_packet() {
+    return m_packet_receiver.poll_packet();
+}
+
+bool SocketTransport::send_packet(Packet packet) {
+    return m_packet_stream.send_packet(packet);
+}
+
+bool SocketTransport::send_game_response(Packet packet, const ResumeToken& token) {
+    return send_with_trailer(packet, &token, sizeof(token));
+}
+
+// Only the send thread of the FrameSender writes to the socket once the game runs
+bool SocketTransport::send_frame(Packet packet, const FrameAck& ack) {
+    return send_with_trailer(packet, &ack, sizeof(ack));
+}
+
+bool SocketTransport::send_with_trailer(Packet& packet, const void* trailer, size_t trailer_size) {
+    packet.header.payload_size += static_cast<uint32_t>(trailer_size);
+
+    return m_packet_stream.send_packet(packet) && send_all(m_client_conn->get_socket(), trailer, trailer_size);
+}
+
+std::exception_ptr SocketTransport::get_recv_exception() const {
+    return m_packet_receiver.get_recv_exception();
+}
+
+bool SocketTransport::is_running() const {
+    return m_packet_receiver.is_running();
+}
+
+void SocketTransport::disconnect() {
+    m_client_conn->disconnect();
+}
+
+int SocketTransport::get_socket() const {
+    return m_client_conn->get_socket();
+}
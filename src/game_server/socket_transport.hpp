@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <socket/socket.hpp>
+#include <packet_stream/packet_stream.hpp>
+#include "transport.hpp"
+#include "packet_receiver.hpp"
+
+/*
+    A client connected over TCP. The packet stream only sends, receiving
+    goes through the bounded PacketReceiver.
+
+    A frame carries its FrameAck as a trailer, the same way a ClientInput
+    carries its stamps: the header the packet stream writes counts it in
+    the payload size, and it is written right behind the serialized frame.
+    The ServerGameResponse carries its ResumeToken the same way.
+    This relies on the packet stream writing the header of the packet as
+    given, like PacketReceiver relies on it for reading.
+*/
+class SocketTransport : public Transport {
+public:
+    SocketTransport(std::shared_ptr<ClientConnection> client_conn, ReceiveBufferPool& pool);
+
+    void start() override;
+    void stop() override;
+
+    std::optional<ReceivedPacket> poll_packet() override;
+    bool send_packet(Packet packet) override;
+    bool send_game_response(Packet packet, const ResumeToken& token) override;
+    bool send_frame(Packet packet, const FrameAck& ack) override;
+
+    std::exception_ptr get_recv_exception() const override;
+    bool is_running() const override;
+
+    void disconnect() override;
+    int get_socket() const override;
+
+private:
+    bool send_with_trailer(Packet& packet, const void* trailer, size_t trailer_size);
+
+    std::shared_ptr<ClientConnection>   m_client_conn;
+    PacketStreamServer                  m_packet_stream;
+    PacketReceiver                      m_packet_receiver;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <atomic>
+#include <vector>
+#include <utility>      // std::move
+
+/*
+    Bounded lock free queue for exactly one producer and one consumer thread.
+
+    Each side owns one index and only reads the other one, with acquire and
+    release ordering on the slot hand over. The indices sit on their own
+    cache lines, and each side keeps a copy of the other's index so the
+    shared line is only read when the copy says the queue is full or empty.
+*/
+template <typename T>
+class SpscQueue {
+public:
+    // Rounded up to a power of two
+    explicit SpscQueue(size_t capacity)
+        : m_slots(round_up(capacity))
+        , m_mask(m_slots.size() - 1)
+    {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer. The value is only moved from if there was room for it
+    bool try_push(T& value) {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head_cache == m_slots.size())
+        {
+            m_head_cache = m_head.load(std::memory_order_acquire);
+
+            if (tail - m_head_cache == m_slots.size())
+            {
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_push(T&& value) {
+        return try_push(value);
+    }
+
+    // Consumer, moves the oldest value out into `value`
+    bool try_pop(T& value) {
+        const auto head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail_cache)
+        {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+
+            if (head == m_tail_cache)
+            {
+                return false;
+            }
+        }
+
+        value = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    size_t capacity() const { return m_slots.size(); }
+
+private:
+    static size_t round_up(size_t capacity) {
+        size_t size = 1;
+
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        return size;
+    }
+
+    std::vector<T>  m_slots;
+    const size_t    m_mask;
+
+    // Consumer side
+    alignas(64) std::atomic<size_t>     m_head{0};
+    size_t                              m_tail_cache = 0;
+
+    // Producer side
+    alignas(64) std::atomic<size_t>     m_tail{0};
+    size_t                              m_head_cache = 0;
+};
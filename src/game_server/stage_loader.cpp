@@ -0,0 +1,313 @@
+#include "stage_loader.hpp"
+
+#include <cmath>        // std::floor
+#include <limits>
+#include <sol/sol.hpp>
+#include "game_server_constants.hpp"
+#include "diag_logger.hpp"
+
+namespace {
+    // false and `error` set if present but not a number, or missing while required
+    bool read_number(const sol::table& table, const char* key, double& value, std::string& error, bool required = true) {
+        const sol::object object = table[key];
+
+        if (object.get_type() == sol::type::lua_nil)
+        {
+            if (required)
+            {
+                error = std::string(key) + " is missing";
+            }
+
+            return !required;
+        }
+
+        if (object.get_type() != sol::type::number)
+        {
+            error = std::string(key) + " must be a number";
+
+            return false;
+        }
+
+        value = object.as<double>();
+
+        return true;
+    }
+
+    bool read_float(const sol::table& table, const char* key, float& value, std::string& error, bool required = true) {
+        double number = value;
+
+        if (!read_number(table, key, number, error, required))
+        {
+            return false;
+        }
+
+        value = static_cast<float>(number);
+
+        return true;
+    }
+
+    template <typename T>
+    bool read_count(const sol::table& table, const char* key, T& value, std::string& error, bool required = true) {
+        double number = static_cast<double>(value);
+
+        if (!read_number(table, key, number, error, required))
+        {
+            return false;
+        }
+
+        if (number < 0 || number != std::floor(number) || number > static_cast<double>(std::numeric_limits<T>::max()))
+        {
+            error = std::string(key) + " must be a non negative integer";
+
+            return false;
+        }
+
+        value = static_cast<T>(number);
+
+        return true;
+    }
+
+    bool read_table(const sol::table& table, const char* key, sol::table& value, std::string& error, bool required = true) {
+        const sol::object object = table[key];
+
+        if (object.get_type() == sol::type::lua_nil)
+        {
+            if (required)
+            {
+                error = std::string(key) + " is missing";
+            }
+
+            return false;
+        }
+
+        if (object.get_type() != sol::type::table)
+        {
+            error = std::string(key) + " must be a table";
+
+            return false;
+        }
+
+        value = object.as<sol::table>();
+
+        return true;
+    }
+
+    bool read_vec2(const sol::table& table, const char* key, Vec2& value, std::string& error, bool required = true) {
+        sol::table vec;
+
+        if (!read_table(table, key, vec, error, required))
+        {
+            return error.empty();
+        }
+
+        if (!read_float(vec, "x", value.x, error) || !read_float(vec, "y", value.y, error))
+        {
+            error = std::string(key) + "." + error;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool read_pattern(const sol::table& table, EmitterPattern& pattern, std::string& error) {
+        const sol::object object = table["pattern"];
+        const auto name = object.is<std::string>() ? object.as<std::string>() : std::string();
+
+        if (name == "circle")       { pattern = EmitterPattern::Circle; }
+        else if (name == "homing")  { pattern = EmitterPattern::Homing; }
+        else if (name == "spiral")  { pattern = EmitterPattern::Spiral; }
+        else if (name == "random")  { pattern = EmitterPattern::Random; }
+        else
+        {
+            error = "pattern must be one of circle, homing, spiral, random";
+
+            return false;
+        }
+
+        return true;
+    }
+
+    // Also picks the radius of the sprite, unless the stage sets one
+    bool read_bullet(const sol::table& table, BulletName& bullet_name, float& bullet_radius, std::string& error) {
+        const sol::object object = table["bullet"];
+        const auto name = object.is<std::string>() ? object.as<std::string>() : std::string("normal");
+
+        if (name == "big_red")          { bullet_name = BulletName::BigRed;     bullet_radius = game_constants::ENEMY_BIG_BULLET_RADIUS; }
+        else if (name == "wedge_red")   { bullet_name = BulletName::WedgeRed;   bullet_radius = game_constants::ENEMY_WEDGE_BULLET_RADIUS; }
+        else if (name == "rice_red")    { bullet_name = BulletName::RiceRed;    bullet_radius = game_constants::ENEMY_RICE_BULLET_RADIUS; }
+        else if (name == "normal")      { bullet_name = BulletName{};           bullet_radius = game_constants::ENEMY_NORMAL_BULLET_RADIUS; }
+        else
+        {
+            error = "bullet must be one of big_red, wedge_red, rice_red, normal";
+
+            return false;
+        }
+
+        return read_float(table, "bullet_radius", bullet_radius, error, false);
+    }
+
+    bool read_emitter(const sol::table& table, Emitter& emitter, std::string& error) {
+        emitter = {};
+        emitter.count = 1;
+
+        return read_pattern(table, emitter.pattern, error)
+            && read_count(table, "interval", emitter.interval, error)
+            && read_count(table, "cycle", emitter.cycle, error, false)
+            && read_count(table, "cycle_phase", emitter.cycle_phase, error, false)
+            && read_count(table, "start_tick", emitter.start_tick, error, false)
+            && read_count(table, "count", emitter.count, error, false)
+            && read_float(table, "speed", emitter.speed, error)
+            && read_bullet(table, emitter.bullet_name, emitter.bullet_radius, error);
+    }
+
+    bool read_bounce(const sol::table& table, BounceMotion& bounce, std::string& error) {
+        bounce = {};
+
+        return read_float(table, "speed", bounce.speed, error)
+            && read_float(table, "min_x", bounce.min_x, error)
+            && read_float(table, "max_x", bounce.max_x, error)
+            && read_float(table, "min_y", bounce.min_y, error)
+            && read_float(table, "max_y", bounce.max_y, error)
+            && read_count(table, "cycle", bounce.cycle, error)
+            && read_count(table, "active_ticks", bounce.active_ticks, error);
+    }
+
+    bool read_enemy(const sol::table& table, StageEnemyDesc& enemy, std::string& error) {
+        enemy = {};
+        enemy.body = { 0, EnemyName::Default, game_constants::ENEMY_RADIUS };
+
+        auto ok = read_count(table, "spawn_tick", enemy.spawn_tick, error, false)
+               && read_count(table, "id", enemy.body.id, error, false)
+               && read_float(table, "radius", enemy.body.radius, error, false)
+               && read_vec2(table, "pos", enemy.transform.pos, error)
+               && read_vec2(table, "vel", enemy.transform.vel, error, false);
+
+        if (!ok)
+        {
+            return false;
+        }
+
+        sol::table bounce;
+
+        if (read_table(table, "bounce", bounce, error, false))
+        {
+            enemy.bounces = true;
+
+            if (!read_bounce(bounce, enemy.bounce, error))
+            {
+                error = "bounce." + error;
+
+                return false;
+            }
+        }
+        else if (!error.empty())
+        {
+            return false;
+        }
+
+        sol::table emitters;
+
+        if (!read_table(table, "emitters", emitters, error, false))
+        {
+            return error.empty();
+        }
+
+        for (size_t i = 1; i <= emitters.size(); i++)
+        {
+            const sol::object object = emitters[i];
+            Emitter emitter;
+
+            if (object.get_type() != sol::type::table || !read_emitter(object.as<sol::table>(), emitter, error))
+            {
+                error = "emitter " + std::to_string(i - 1) + ": " + (error.empty() ? "must be a table" : error);
+
+                return false;
+            }
+
+            enemy.emitters.push_back(emitter);
+        }
+
+        return true;
+    }
+
+    bool read_stage(const sol::table& table, StageDesc& stage, std::string& error) {
+        const sol::object name = table["name"];
+        stage.name = name.is<std::string>() ? name.as<std::string>() : std::string("unnamed");
+
+        sol::table enemies;
+
+        if (!read_table(table, "enemies", enemies, error))
+        {
+            return false;
+        }
+
+        for (size_t i = 1; i <= enemies.size(); i++)
+        {
+            const sol::object object = enemies[i];
+            StageEnemyDesc enemy;
+
+            if (object.get_type() != sol::type::table || !read_enemy(object.as<sol::table>(), enemy, error))
+            {
+                error = "enemy " + std::to_string(i - 1) + ": " + (error.empty() ? "must be a table" : error);
+
+                return false;
+            }
+
+            stage.enemies.push_back(std::move(enemy));
+        }
+
+        return true;
+    }
+}
+
+std::shared_ptr<const StageTimeline> load_stage_timeline(const std::string& path) {
+    sol::state lua;
+    lua.open_libraries(sol::lib::base, sol::lib::math);
+
+    lua["GAME_WIDTH_HALF"] = game_constants::GAME_WIDTH_HALF;
+    lua["GAME_HEIGHT_HALF"] = game_constants::GAME_HEIGHT_HALF;
+
+    const auto result = lua.safe_script_file(path, sol::script_pass_on_error);
+
+    if (!result.valid())
+    {
+        const sol::error lua_error = result;
+        DIAG_ERROR("StageLoader", path << ": " << lua_error.what());
+
+        return nullptr;
+    }
+
+    const sol::object stage_object = lua["stage"];
+
+    if (stage_object.get_type() != sol::type::table)
+    {
+        DIAG_ERROR("StageLoader", path << ": no global stage table");
+
+        return nullptr;
+    }
+
+    StageDesc desc;
+    std::string error;
+
+    if (!read_stage(stage_object.as<sol::table>(), desc, error))
+    {
+        DIAG_ERROR("StageLoader", path << ": " << error);
+
+        return nullptr;
+    }
+
+    auto timeline = StageTimeline::compile(desc, error);
+
+    if (!timeline)
+    {
+        DIAG_ERROR("StageLoader", path << ": " << error);
+
+        return nullptr;
+    }
+
+    DIAG_DEBUG("StageLoader", "Stage '" << desc.name << "' has been loaded, "
+        << timeline->get_emitter_count() << " emitters repeating every " << timeline->get_loop_period() << " ticks");
+
+    return timeline;
+}
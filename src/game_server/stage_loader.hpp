@@ -0,0 +1,14 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include "stage_timeline.hpp"
+
+/*
+    Loads a stage from a Lua file and compiles it into a timeline.
+
+    The file sets a global `stage` table, see stages/default.lua. GAME_WIDTH_HALF
+    and GAME_HEIGHT_HALF are defined for it. Returns nullptr, after logging why,
+    if the file does not run or the stage does not validate.
+*/
+std::shared_ptr<const StageTimeline> load_stage_timeline(const std::string& path);
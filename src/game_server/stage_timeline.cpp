@@ -0,0 +1,344 @@
+#include "stage_timeline.hpp"
+
+#include <algorithm>    // std::sort, std::equal_range, std::max
+#include <numeric>      // std::lcm
+#include <cstring>      // std::memcpy
+#include "game_server_constants.hpp"
+
+namespace {
+    // FNV-1a
+    class Fingerprint {
+    public:
+        template <typename T>
+        void add(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+
+            unsigned char bytes[sizeof(T)];
+            std::memcpy(bytes, &value, sizeof(T));
+
+            for (const auto byte : bytes)
+            {
+                m_hash = (m_hash ^ byte) * 0x100000001b3ULL;
+            }
+        }
+
+        void add(const std::string& value) {
+            for (const auto c : value)
+            {
+                add(c);
+            }
+        }
+
+        uint64_t get() const { return m_hash; }
+
+    private:
+        uint64_t m_hash = 0xcbf29ce484222325ULL;
+    };
+
+    bool inside_stage(const Vec2& pos) {
+        const auto expr_1 = pos.x >= -game_constants::GAME_WIDTH_HALF && pos.x <= game_constants::GAME_WIDTH_HALF;
+        const auto expr_2 = pos.y >= -game_constants::GAME_HEIGHT_HALF && pos.y <= game_constants::GAME_HEIGHT_HALF;
+
+        return expr_1 && expr_2;
+    }
+
+    std::string validate_emitter(const Emitter& emitter) {
+        if (emitter.interval == 0)
+        {
+            return "interval must be positive";
+        }
+
+        if (emitter.cycle != 0 && emitter.cycle_phase >= emitter.cycle)
+        {
+            return "cycle_phase must be below cycle";
+        }
+
+        if (emitter.count == 0 || emitter.count > stage_constants::MAX_PATTERN_BULLETS)
+        {
+            return "count must be within 1.." + std::to_string(stage_constants::MAX_PATTERN_BULLETS);
+        }
+
+        if (!(emitter.speed > 0.0f) || !(emitter.bullet_radius > 0.0f))
+        {
+            return "speed and bullet_radius must be positive";
+        }
+
+        return {};
+    }
+
+    std::string validate_enemy(const StageEnemyDesc& enemy) {
+        if (!inside_stage(enemy.transform.pos))
+        {
+            return "spawns outside the stage";
+        }
+
+        if (!(enemy.body.radius > 0.0f))
+        {
+            return "radius must be positive";
+        }
+
+        if (enemy.spawn_tick > stage_constants::MAX_START_TICK)
+        {
+            return "spawn_tick is beyond " + std::to_string(stage_constants::MAX_START_TICK);
+        }
+
+        if (enemy.bounces)
+        {
+            const auto& bounce = enemy.bounce;
+
+            if (bounce.cycle == 0 || bounce.active_ticks > bounce.cycle)
+            {
+                return "bounce needs 0 < active_ticks <= cycle";
+            }
+
+            if (!(bounce.min_x < bounce.max_x) || !(bounce.min_y < bounce.max_y))
+            {
+                return "bounce box is empty";
+            }
+        }
+
+        for (size_t i = 0; i < enemy.emitters.size(); i++)
+        {
+            if (enemy.emitters[i].start_tick > stage_constants::MAX_START_TICK)
+            {
+                return "emitter " + std::to_string(i) + ": start_tick is beyond " + std::to_string(stage_constants::MAX_START_TICK);
+            }
+
+            auto error = validate_emitter(enemy.emitters[i]);
+
+            if (!error.empty())
+            {
+                return "emitter " + std::to_string(i) + ": " + error;
+            }
+        }
+
+        return {};
+    }
+
+    bool is_due(const Emitter& emitter, uint64_t tick) {
+        const auto expr_1 = tick % emitter.interval == 0;
+        const auto expr_2 = emitter.cycle == 0 || (tick % emitter.cycle) > emitter.cycle_phase;
+        const auto expr_3 = tick > emitter.start_tick;
+
+        return expr_1 && expr_2 && expr_3;
+    }
+}
+
+std::shared_ptr<const StageTimeline> StageTimeline::compile(const StageDesc& desc, std::string& error) {
+    if (desc.enemies.empty())
+    {
+        error = "stage '" + desc.name + "' has no enemies";
+
+        return nullptr;
+    }
+
+    std::shared_ptr<StageTimeline> timeline(new StageTimeline());
+    timeline->m_desc = desc;
+
+    uint64_t loop_start = 0;
+    uint64_t loop_period = 1;
+
+    for (uint32_t enemy_index = 0; enemy_index < desc.enemies.size(); enemy_index++)
+    {
+        const auto& enemy = desc.enemies[enemy_index];
+        const auto enemy_error = validate_enemy(enemy);
+
+        if (!enemy_error.empty())
+        {
+            error = "stage '" + desc.name + "', enemy " + std::to_string(enemy_index) + ": " + enemy_error;
+
+            return nullptr;
+        }
+
+        timeline->m_spawns.push_back({ enemy.spawn_tick, enemy_index });
+        timeline->m_enemy_first_slot.push_back(static_cast<uint32_t>(timeline->m_emitter_enemy.size()));
+        loop_start = std::max(loop_start, enemy.spawn_tick);
+
+        for (uint32_t i = 0; i < enemy.emitters.size(); i++)
+        {
+            const auto& emitter = enemy.emitters[i];
+
+            timeline->m_emitter_enemy.push_back(enemy_index);
+            timeline->m_emitter_index.push_back(i);
+
+            loop_start = std::max<uint64_t>(loop_start, emitter.start_tick);
+            loop_period = std::lcm(loop_period, static_cast<uint64_t>(emitter.interval));
+
+            if (emitter.cycle != 0)
+            {
+                loop_period = std::lcm(loop_period, static_cast<uint64_t>(emitter.cycle));
+            }
+
+            if (loop_period > stage_constants::MAX_LOOP_TICKS)
+            {
+                error = "stage '" + desc.name + "': the emitters only repeat after more than "
+                      + std::to_string(stage_constants::MAX_LOOP_TICKS) + " ticks";
+
+                return nullptr;
+            }
+        }
+    }
+
+    std::stable_sort(timeline->m_spawns.begin(), timeline->m_spawns.end(), [](const auto& a, const auto& b) {
+        return a.tick < b.tick;
+    });
+
+    timeline->m_loop_start = loop_start;
+    timeline->m_loop_period = loop_period;
+
+    // Fire events of every tick up to the end of the first loop
+    const auto schedule_ticks = loop_start + loop_period + 1;
+    timeline->m_fire_offsets.reserve(schedule_ticks + 1);
+
+    for (uint64_t tick = 0; tick < schedule_ticks; tick++)
+    {
+        timeline->m_fire_offsets.push_back(static_cast<uint32_t>(timeline->m_fire_slots.size()));
+
+        for (uint32_t slot = 0; slot < timeline->m_emitter_enemy.size(); slot++)
+        {
+            const auto& enemy = desc.enemies[timeline->m_emitter_enemy[slot]];
+            const auto& emitter = enemy.emitters[timeline->m_emitter_index[slot]];
+
+            // Spawned at the start of its tick, fires from the next one
+            if (tick > enemy.spawn_tick && is_due(emitter, tick))
+            {
+                timeline->m_fire_slots.push_back(slot);
+            }
+        }
+    }
+
+    timeline->m_fire_offsets.push_back(static_cast<uint32_t>(timeline->m_fire_slots.size()));
+
+    // Everything that decides the behaviour of the stage
+    Fingerprint fingerprint;
+    fingerprint.add(desc.name);
+
+    for (const auto& enemy : desc.enemies)
+    {
+        fingerprint.add(enemy.spawn_tick);
+        fingerprint.add(enemy.body);
+        fingerprint.add(enemy.transform);
+        fingerprint.add(enemy.bounces);
+        fingerprint.add(enemy.bounce);
+
+        // Field by field, Emitter has padding
+        for (const auto& emitter : enemy.emitters)
+        {
+            fingerprint.add(emitter.pattern);
+            fingerprint.add(emitter.interval);
+            fingerprint.add(emitter.cycle);
+            fingerprint.add(emitter.cycle_phase);
+            fingerprint.add(emitter.start_tick);
+            fingerprint.add(emitter.count);
+            fingerprint.add(emitter.speed);
+            fingerprint.add(emitter.bullet_name);
+            fingerprint.add(emitter.bullet_radius);
+        }
+    }
+
+    timeline->m_fingerprint = fingerprint.get();
+
+    return timeline;
+}
+
+EventRange<SpawnEvent> StageTimeline::spawns_at(uint64_t tick) const {
+    const auto range = std::equal_range(
+        m_spawns.begin(),
+        m_spawns.end(),
+        SpawnEvent{ tick, 0 },
+        [](const SpawnEvent& a, const SpawnEvent& b) { return a.tick < b.tick; }
+    );
+
+    return { m_spawns.data() + (range.first - m_spawns.begin()), m_spawns.data() + (range.second - m_spawns.begin()) };
+}
+
+EventRange<uint32_t> StageTimeline::fires_at(uint64_t tick) const {
+    const auto schedule_tick = to_schedule_tick(tick);
+    const auto* slots = m_fire_slots.data();
+
+    return { slots + m_fire_offsets[schedule_tick], slots + m_fire_offsets[schedule_tick + 1] };
+}
+
+uint64_t StageTimeline::to_schedule_tick(uint64_t tick) const {
+    const auto loop_end = m_loop_start + m_loop_period;
+
+    if (tick <= loop_end)
+    {
+        return tick;
+    }
+
+    return m_loop_start + 1 + (tick - m_loop_start - 1) % m_loop_period;
+}
+
+const StageDesc& default_stage_desc() {
+    static const StageDesc desc = [] {
+        StageDesc stage;
+        stage.name = "default";
+
+        StageEnemyDesc boss;
+        boss.body = { 0, EnemyName::Default, game_constants::ENEMY_RADIUS };
+        boss.transform = { { 0, 120 }, { 2, 2 } };
+        boss.bounces = true;
+        boss.bounce = {
+            2.0f,
+            -game_constants::GAME_WIDTH_HALF,
+            game_constants::GAME_WIDTH_HALF,
+            60.0f,
+            game_constants::GAME_HEIGHT_HALF,
+            360,
+            120
+        };
+
+        // pattern, interval, cycle, cycle_phase, start_tick, count, speed, bullet_name, bullet_radius
+        boss.emitters = {
+            { EmitterPattern::Circle, 60, 360, 120, 0,   8, 2.0f, BulletName::BigRed,   game_constants::ENEMY_BIG_BULLET_RADIUS },
+            { EmitterPattern::Homing, 30, 360, 120, 0,   1, 2.5f, BulletName::WedgeRed, game_constants::ENEMY_WEDGE_BULLET_RADIUS },
+            { EmitterPattern::Spiral, 8,  360, 120, 0,   7, 2.0f, BulletName::RiceRed,  game_constants::ENEMY_RICE_BULLET_RADIUS },
+            { EmitterPattern::Random, 60, 0,   0,   120, 7, 2.0f, BulletName{},        game_constants::ENEMY_NORMAL_BULLET_RADIUS },
+        };
+
+        stage.enemies.push_back(boss);
+
+        return stage;
+    }();
+
+    return desc;
+}
+
+std::shared_ptr<const StageTimeline> default_stage_timeline() {
+    static const auto timeline = [] {
+        std::string error;
+
+        return StageTimeline::compile(default_stage_desc(), error);
+    }();
+
+    return timeline;
+}
+
+EntityId spawn_stage_enemy(EnemyWorld& world, const StageEnemyDesc& enemy, EntityId* emitter_entities) {
+    EntityDesc desc = {};
+    desc.mask = component::TRANSFORM | component::BODY | (enemy.bounces ? component::BOUNCE : 0);
+    desc.transform = enemy.transform;
+    desc.body = enemy.body;
+    desc.bounce = enemy.bounce;
+
+    const auto enemy_entity = world.spawn(desc);
+
+    for (size_t i = 0; i < enemy.emitters.size(); i++)
+    {
+        EntityDesc emitter = {};
+        emitter.mask = component::TRANSFORM | component::EMITTER | component::FOLLOW;
+        emitter.transform = { enemy.transform.pos, { 0, 0 } };
+        emitter.emitter = enemy.emitters[i];
+        emitter.follow = { enemy_entity };
+
+        const auto emitter_entity = world.spawn(emitter);
+
+        if (emitter_entities != nullptr)
+        {
+            emitter_entities[i] = emitter_entity;
+        }
+    }
+
+    return enemy_entity;
+}
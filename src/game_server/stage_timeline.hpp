@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "enemy_world.hpp"
+
+/*
+    Stage description, as loaded from a stage file (see stage_loader.hpp)
+*/
+struct StageEnemyDesc {
+    uint64_t                spawn_tick  = 0;
+    EnemyBody               body        = {};
+    Transform               transform   = {};
+    bool                    bounces     = false;
+    BounceMotion            bounce      = {};
+    std::vector<Emitter>    emitters;           // Follow the enemy, fire on their own schedule
+};
+
+struct StageDesc {
+    std::string                 name;
+    std::vector<StageEnemyDesc> enemies;
+};
+
+template <typename T>
+struct EventRange {
+    const T* first;
+    const T* last;
+
+    const T* begin() const { return first; }
+    const T* end() const { return last; }
+    bool empty() const { return first == last; }
+};
+
+struct SpawnEvent {
+    uint64_t tick;
+    uint32_t enemy;     // Index into StageDesc::enemies
+};
+
+/*
+    A stage compiled into a schedule.
+
+    Emitter timing is resolved once here instead of being tested every tick:
+    after the last start tick everything repeats with the least common
+    multiple of the intervals and cycles, so the fire events of that first
+    stretch are laid out per tick and later ticks map back into the loop.
+    A tick only looks up the events due now. The timeline is immutable once
+    compiled and shared by all instances playing the stage.
+*/
+class StageTimeline {
+public:
+    // nullptr and `error` set if the stage does not validate
+    static std::shared_ptr<const StageTimeline> compile(const StageDesc& desc, std::string& error);
+
+    const StageDesc& get_desc() const { return m_desc; }
+    size_t get_emitter_count() const { return m_emitter_enemy.size(); }
+
+    EventRange<SpawnEvent> spawns_at(uint64_t tick) const;
+    EventRange<uint32_t> fires_at(uint64_t tick) const;     // Emitter slots, in stage order
+
+    // Emitter slot -> (enemy, index among its emitters)
+    uint32_t get_emitter_enemy(uint32_t slot) const { return m_emitter_enemy[slot]; }
+    uint32_t get_emitter_index(uint32_t slot) const { return m_emitter_index[slot]; }
+
+    // The slots of an enemy are contiguous, starting here
+    uint32_t get_first_slot(uint32_t enemy) const { return m_enemy_first_slot[enemy]; }
+
+    uint64_t get_loop_start() const { return m_loop_start; }
+    uint64_t get_loop_period() const { return m_loop_period; }
+
+    // Identifies the stage across processes (session migration)
+    uint64_t get_fingerprint() const { return m_fingerprint; }
+
+private:
+    StageTimeline() = default;
+
+    uint64_t to_schedule_tick(uint64_t tick) const;
+
+    StageDesc               m_desc;
+    std::vector<SpawnEvent> m_spawns;           // Sorted by tick
+    std::vector<uint32_t>   m_fire_offsets;     // Per schedule tick, into m_fire_slots
+    std::vector<uint32_t>   m_fire_slots;
+    std::vector<uint32_t>   m_emitter_enemy;
+    std::vector<uint32_t>   m_emitter_index;
+    std::vector<uint32_t>   m_enemy_first_slot;
+    uint64_t                m_loop_start;       // Ticks after this one repeat every m_loop_period
+    uint64_t                m_loop_period;
+    uint64_t                m_fingerprint;
+};
+
+// The boss stage the server plays without a stage file
+const StageDesc& default_stage_desc();
+std::shared_ptr<const StageTimeline> default_stage_timeline();
+
+// Spawns the enemy and its emitters, the emitter entities are written to `emitter_entities` if not null
+EntityId spawn_stage_enemy(EnemyWorld& world, const StageEnemyDesc& enemy, EntityId* emitter_entities = nullptr);
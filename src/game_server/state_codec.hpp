@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+/*
+    Minimal binary encoding of the simulation state.
+    Values are copied as they are in memory, both sides have to be builds
+    with the same layout (checked through the header of the encoded state).
+*/
+class StateWriter {
+public:
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateWriter can only write trivially copyable types");
+
+        const auto offset = m_buffer.size();
+        m_buffer.resize(offset + sizeof(T));
+        std::memcpy(m_buffer.data() + offset, &value, sizeof(T));
+    }
+
+    template <typename T, typename Alloc>
+    void write_vector(const std::vector<T, Alloc>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateWriter can only write trivially copyable types");
+
+        write(static_cast<uint32_t>(values.size()));
+
+        const auto offset = m_buffer.size();
+        m_buffer.resize(offset + sizeof(T) * values.size());
+
+        if (!values.empty())
+        {
+            std::memcpy(m_buffer.data() + offset, values.data(), sizeof(T) * values.size());
+        }
+    }
+
+    void write_string(const std::string& value) {
+        write(static_cast<uint32_t>(value.size()));
+        m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+    }
+
+    std::vector<uint8_t>& get_buffer() { return m_buffer; }
+    const std::vector<uint8_t>& get_buffer() const { return m_buffer; }
+
+private:
+    std::vector<uint8_t> m_buffer;
+};
+
+// Every read is bounds checked, a failed read leaves the reader failed
+class StateReader {
+public:
+    StateReader(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_offset(0)
+        , m_failed(false)
+    {}
+
+    explicit StateReader(const std::vector<uint8_t>& buffer)
+        : StateReader(buffer.data(), buffer.size())
+    {}
+
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateReader can only read trivially copyable types");
+
+        if (!take(sizeof(T)))
+        {
+            return false;
+        }
+
+        std::memcpy(&value, m_data + m_offset - sizeof(T), sizeof(T));
+
+        return true;
+    }
+
+    template <typename T, typename Alloc>
+    bool read_vector(std::vector<T, Alloc>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateReader can only read trivially copyable types");
+
+        uint32_t count = 0;
+
+        if (!read(count) || count > remaining() / sizeof(T) || !take(sizeof(T) * count))
+        {
+            m_failed = true;
+
+            return false;
+        }
+
+        values.resize(count);
+
+        if (count > 0)
+        {
+            std::memcpy(values.data(), m_data + m_offset - sizeof(T) * count, sizeof(T) * count);
+        }
+
+        return true;
+    }
+
+    bool read_string(std::string& value) {
+        uint32_t size = 0;
+
+        if (!read(size) || !take(size))
+        {
+            return false;
+        }
+
+        value.assign(reinterpret_cast<const char*>(m_data + m_offset - size), size);
+
+        return true;
+    }
+
+    bool failed() const { return m_failed; }
+    size_t remaining() const { return m_size - m_offset; }
+
+private:
+    bool take(size_t size) {
+        if (m_failed || size > remaining())
+        {
+            m_failed = true;
+
+            return false;
+        }
+
+        m_offset += size;
+
+        return true;
+    }
+
+    const uint8_t*  m_data;
+    size_t          m_size;
+    size_t          m_offset;
+    bool            m_failed;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <exception>
+#include <utility>      // std::move
+#include <packet_template/packet_template.hpp>
+#include "input_sequence.hpp"
+#include "resume_token.hpp"
+
+struct ReceivedPacket {
+    Packet                      packet;
+    std::optional<InputStamp>   input_stamp;    // Sequenced ClientInput only
+    std::optional<PongStamp>    pong_stamp;     // ClientInput echoing a frame
+    std::optional<ResumeToken>  resume_token;   // ClientGameRequest resuming a game
+    int64_t                     received_usec;
+};
+
+/*
+    The connection of a game instance to its client, as handle_client sees it.
+
+    SocketTransport is a TCP client, LocalTransport a client in the same
+    process (see local_transport.hpp). Received packets are polled by the
+    game loop, packets are sent by the game loop before the game starts and
+    by the FrameSender afterwards.
+*/
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual void start() = 0;
+    virtual void stop() = 0;
+
+    virtual std::optional<ReceivedPacket> poll_packet() = 0;
+
+    // Blocks as long as the client does not drain, false once the connection is gone
+    virtual bool send_packet(Packet packet) = 0;
+
+    // A ServerGameResponse packet, the client gets the token of its game with it
+    virtual bool send_game_response(Packet packet, const ResumeToken& token) = 0;
+
+    // A FrameSnapshot packet, the client gets the ack with it
+    virtual bool send_frame(Packet packet, const FrameAck& ack) = 0;
+
+    // True if sending never blocks: the FrameSender then sends frames from the game loop with try_send_frame()
+    virtual bool sends_inline() const { return false; }
+
+    // Takes the frame only if the client has room for it right now
+    virtual bool try_send_frame(Packet& packet, const FrameAck& ack) { return send_frame(std::move(packet), ack); }
+
+    virtual std::exception_ptr get_recv_exception() const = 0;
+    virtual bool is_running() const = 0;
+
+    virtual void disconnect() = 0;
+
+    // Socket the session migration passes on, -1 if the connection can not leave the process
+    virtual int get_socket() const { return -1; }
+};
@@ -0,0 +1,133 @@
+#include "worker_pool.hpp"
+
+#include <memory>
+#include <algorithm>    // std::min
+
+namespace {
+    // State of a single parallel_for call, kept alive by the helpers that have not started yet
+    struct ParallelJob {
+        const std::function<void(size_t)>*  fn;
+        size_t                              count;
+        std::atomic<size_t>                 next{0};
+        std::atomic<size_t>                 done{0};
+        std::mutex                          mutex;
+        std::condition_variable             cv;
+    };
+
+    void run_job(ParallelJob& job) {
+        while (true)
+        {
+            const auto index = job.next.fetch_add(1);
+
+            if (index >= job.count)
+            {
+                return;
+            }
+
+            (*job.fn)(index);
+
+            if (job.done.fetch_add(1) + 1 == job.count)
+            {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                job.cv.notify_one();
+            }
+        }
+    }
+}
+
+WorkerPool::WorkerPool(size_t worker_count)
+    : m_running(true)
+{
+    m_workers.reserve(worker_count);
+
+    for (size_t i = 0; i < worker_count; i++)
+    {
+        m_workers.emplace_back(&WorkerPool::worker_loop, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+
+    m_cv.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+void WorkerPool::parallel_for(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto job = std::make_shared<ParallelJob>();
+    job->fn = &fn;
+    job->count = count;
+
+    // The calling thread takes one share of the work itself
+    const auto helper_count = std::min(count - 1, m_workers.size());
+
+    if (helper_count > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (size_t i = 0; i < helper_count; i++)
+            {
+                m_tasks.push([job]() { run_job(*job); });
+            }
+        }
+
+        m_cv.notify_all();
+    }
+
+    run_job(*job);
+
+    // Wait for the indices still running on the workers
+    std::unique_lock<std::mutex> lock(job->mutex);
+
+    job->cv.wait(
+        lock,
+        [&]{
+            return job->done.load() == job->count;
+        }
+    );
+}
+
+void WorkerPool::worker_loop() {
+    while (true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_cv.wait(
+                lock,
+                [&]{
+                    return !m_tasks.empty() || !m_running.load();
+                }
+            );
+
+            if (m_tasks.empty())
+            {
+                // Stopped and nothing left to run
+                return;
+            }
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/*
+    Fixed set of threads shared by every game instance of the server.
+    The calling thread takes part in the work, so a pool of N workers runs
+    a parallel_for on up to N + 1 threads.
+*/
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t worker_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Runs fn(0) .. fn(count - 1) and returns once all of them are done
+    void parallel_for(size_t count, const std::function<void(size_t)>& fn);
+
+    size_t get_worker_count() const { return m_workers.size(); }
+
+private:
+    void worker_loop();
+
+    std::vector<std::thread>            m_workers;
+    std::atomic<bool>                   m_running;
+    std::mutex                          m_mutex;
+    std::condition_variable             m_cv;
+    std::queue<std::function<void()>>   m_tasks;
+};
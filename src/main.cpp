@@ -1,31 +1,247 @@
 #define SDL_MAIN_HANDLED
 
 #include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include "game_server/game_server.hpp"
+#include "game_server/game_server_supervisor.hpp"
+#include "game_server/stage_loader.hpp"
 #include "config_constants.hpp"
 
+namespace {
+    // Digits only, from 1 to MAX_WORKERS
+    bool parse_worker_count(const std::string& text, size_t& worker_count) {
+        if (text.empty() || text.size() > 9 || text.find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+
+        const auto count = std::stoul(text);
+
+        if (count == 0 || count > supervisor_constants::MAX_WORKERS)
+        {
+            return false;
+        }
+
+        worker_count = count;
+
+        return true;
+    }
+
+    void enable_parallel_bullets(GameServerMaster& game_server_master, size_t worker_count) {
+        if (simulation_constants::PARALLEL_BULLET_ENABLED)
+        {
+            game_server_master.enable_parallel_bullets(
+                worker_count,
+                simulation_constants::PARALLEL_BULLET_THRESHOLD
+            );
+        }
+    }
+}
+
+/*
+    Usage: bullet_hell_server [--workers N] [--pin-numa] [--take-over PATH] [--stage PATH] [--overrun catch-up|skip]
+                              [--collision discrete|swept] [--checkpoint PATH]
+
+    --workers N         Fork N worker processes sharing the server port (supervisor mode), 1 to 256
+    --pin-numa          Pin the workers to the NUMA nodes, round robin
+    --take-over PATH    Take the live sessions over from the server listening at PATH, by default
+                        /tmp/bullet_hell_server/handoff.sock. Only the same user may, with the token
+                        the server keeps in PATH.token (single process mode only, the predecessor
+                        exits once drained)
+    --stage PATH        Stage file the instances play, stages/default.lua by default
+                        (the built in default stage if that one is missing)
+    --overrun POLICY    What an instance sends for the ticks it runs late: every frame (catch-up, default)
+                        or only the latest one (skip). Catching up drops the ticks beyond a 100ms burst,
+                        skipping simulates every missed tick (up to 10s)
+    --collision MODE    Bullet hits at the end of each tick only (discrete, default), or anywhere
+                        along the way the bullet and the player moved during it (swept)
+    --checkpoint PATH   Checkpoint the live sessions to PATH every few seconds for crash recovery
+                        (PATH.N for worker N in supervisor mode). The next run resumes the game of a
+                        client that comes back with its resume token, for a few minutes
+*/
 int main(int argc, char* args[]) {
-    // Unused
-    static_cast<void>(argc);
-    static_cast<void>(args);
+    size_t worker_count = 0;
+    bool pin_numa = false;
+    std::string take_over_path;
+    std::string stage_path;
+    auto overrun_policy = OverrunPolicy::CatchUp;
+    auto collision_mode = CollisionMode::Discrete;
+    std::string checkpoint_path;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = args[i];
+
+        if (arg == "--workers" && i + 1 < argc && parse_worker_count(args[i + 1], worker_count))
+        {
+            i++;
+        }
+        else if (arg == "--pin-numa")
+        {
+            pin_numa = true;
+        }
+        else if (arg == "--take-over" && i + 1 < argc)
+        {
+            take_over_path = args[++i];
+        }
+        else if (arg == "--stage" && i + 1 < argc)
+        {
+            stage_path = args[++i];
+        }
+        else if (arg == "--overrun" && i + 1 < argc && (std::string(args[i + 1]) == "catch-up" || std::string(args[i + 1]) == "skip"))
+        {
+            overrun_policy = std::string(args[++i]) == "skip" ? OverrunPolicy::Skip : OverrunPolicy::CatchUp;
+        }
+        else if (arg == "--collision" && i + 1 < argc && (std::string(args[i + 1]) == "discrete" || std::string(args[i + 1]) == "swept"))
+        {
+            collision_mode = std::string(args[++i]) == "swept" ? CollisionMode::Swept : CollisionMode::Discrete;
+        }
+        else if (arg == "--checkpoint" && i + 1 < argc)
+        {
+            checkpoint_path = args[++i];
+        }
+        else
+        {
+            std::cerr << "[main] Unknown argument: " << arg << "\n";
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Every forked worker would inherit the one handoff connection and read from it
+    if (worker_count > 0 && !take_over_path.empty())
+    {
+        std::cerr << "[main] --take-over can not be combined with --workers" << "\n";
+
+        return EXIT_FAILURE;
+    }
 
     std::cout << "[main] Hello" << "\n";
 
+    // Compiled once, before any instance starts
+    std::shared_ptr<const StageTimeline> stage_timeline;
+
+    if (stage_path.empty())
+    {
+        stage_path = std::string(stage_file_constants::DEFAULT_STAGE_PATH);
+
+        if (!std::ifstream(stage_path))
+        {
+            std::cout << "[main] DEBUG: " << stage_path << " not found, playing the built in default stage" << "\n";
+
+            stage_path.clear();
+        }
+    }
+
+    if (stage_path.empty())
+    {
+        stage_timeline = default_stage_timeline();
+    }
+    else
+    {
+        stage_timeline = load_stage_timeline(stage_path);
+    }
+
+    if (!stage_timeline)
+    {
+        std::cerr << "[main] Failed to load the stage" << "\n";
+
+        return EXIT_FAILURE;
+    }
+
     auto game_server_master = std::make_shared<GameServerMaster>(
         socket_constants::SERVER_PORT,
         socket_constants::SERVER_MAX_INSTANCES
     );
+    game_server_master->set_stage_timeline(stage_timeline);
+    game_server_master->set_overrun_policy(overrun_policy);
+    game_server_master->set_collision_mode(collision_mode);
 
-    if (!game_server_master->initialize())
+    // The predecessor releases the server port as soon as we are connected
+    if (!take_over_path.empty() && !game_server_master->take_over(take_over_path))
+    {
+        std::cerr << "[main] Failed to connect to the server to take over" << "\n";
+
+        return EXIT_FAILURE;
+    }
+
+    const auto bind_attempts = take_over_path.empty() ? 1 : handoff_constants::BIND_MAX_ATTEMPTS;
+    auto initialized = false;
+
+    for (uint32_t attempt = 0; attempt < bind_attempts && !initialized; attempt++)
+    {
+        if (attempt > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(handoff_constants::BIND_RETRY_MSEC));
+        }
+
+        initialized = game_server_master->initialize();
+    }
+
+    if (!initialized)
     {
         std::cerr << "[main] Failed to initialize game server master" << "\n";
 
         return EXIT_FAILURE;
     }
 
-    game_server_master->run();
+    if (worker_count == 0)
+    {
+        game_server_master->enable_session_handoff(std::string(handoff_constants::HANDOFF_SOCKET_PATH));
+
+        if (!checkpoint_path.empty())
+        {
+            game_server_master->enable_crash_checkpoints(checkpoint_path);
+        }
+
+        enable_parallel_bullets(*game_server_master, simulation_constants::PARALLEL_BULLET_WORKERS);
+        game_server_master->run();
+    }
+    else
+    {
+        // The listening socket is bound above, the workers inherit it
+        GameServerSupervisor supervisor(worker_count, pin_numa);
+
+        supervisor.run([&](size_t worker_index, WorkerSlot& slot) -> int {
+            const auto cpu_capacity = supervisor.get_worker_cpu_capacity(worker_index);
+
+            game_server_master->set_cpu_capacity(cpu_capacity);
+
+            // Whole cores only, the instance thread takes one of them. 0 would mean every core of the machine
+            const auto worker_cores = static_cast<size_t>(std::floor(cpu_capacity));
+
+            if (worker_cores >= 2)
+            {
+                enable_parallel_bullets(*game_server_master, worker_cores - 1);
+            }
+
+            // The checkpoint thread is started in the worker, threads do not survive the fork
+            if (!checkpoint_path.empty())
+            {
+                game_server_master->enable_crash_checkpoints(checkpoint_path + "." + std::to_string(worker_index));
+            }
+
+            game_server_master->run_async();
+
+            // Publish the instance count until the supervisor stops this worker
+            while (!GameServerSupervisor::stop_requested())
+            {
+                slot.active_instances = game_server_master->get_active_instances();
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(supervisor_constants::POLL_INTERVAL_MSEC));
+            }
+
+            game_server_master->stop();
+
+            return 0;
+        });
+    }
 
     std::cout << "[main] Goodbye" << "\n";
 
     return 0;
-}
\ No newline at end of file
+}
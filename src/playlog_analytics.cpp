@@ -0,0 +1,170 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "playlog_analytics/playlog_store.hpp"
+#include "playlog_analytics/playlog_queries.hpp"
+#include "config_constants.hpp"
+
+namespace {
+    void print_usage() {
+        std::cerr << "Usage: playlog_analytics ingest STORE_DIR [PLAYLOG_FILE_OR_DIR ...]" << "\n"
+                  << "       playlog_analytics deaths STORE_DIR [--stage N] [--cell SIZE]" << "\n"
+                  << "       playlog_analytics density STORE_DIR [--stage N] [--bucket TICKS]" << "\n"
+                  << "       playlog_analytics hits STORE_DIR [--stage N]" << "\n"
+                  << "       [--threads N] applies to all of them" << "\n";
+    }
+
+    double seconds_since(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+/*
+    Offline analytics over the playlogs GameLogger writes.
+
+    `ingest` parses the playlogs (/mnt/data by default) into a columnar
+    store once, the queries then run against the store:
+
+    deaths      Where the games end, a CSV grid over the stage
+    density     Mean bullets on screen over time
+    hits        Game overs per bullet type, the bullet types stand for the patterns
+*/
+int main(int argc, char* args[]) {
+    if (argc < 3)
+    {
+        print_usage();
+
+        return EXIT_FAILURE;
+    }
+
+    const std::string command = args[1];
+    const std::string store_dir = args[2];
+
+    QueryFilter filter;
+    float cell_size = analytics_constants::HEATMAP_CELL_SIZE;
+    uint32_t bucket_ticks = analytics_constants::DENSITY_BUCKET_TICKS;
+    size_t thread_count = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> inputs;
+
+    for (int i = 3; i < argc; i++)
+    {
+        const std::string arg = args[i];
+
+        if (arg == "--stage" && i + 1 < argc)
+        {
+            filter.stage_id = static_cast<uint32_t>(std::stoul(args[++i]));
+        }
+        else if (arg == "--cell" && i + 1 < argc)
+        {
+            cell_size = std::stof(args[++i]);
+        }
+        else if (arg == "--bucket" && i + 1 < argc)
+        {
+            bucket_ticks = static_cast<uint32_t>(std::stoul(args[++i]));
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            thread_count = std::stoul(args[++i]);
+        }
+        else if (command == "ingest" && arg.rfind("--", 0) != 0)
+        {
+            inputs.push_back(arg);
+        }
+        else
+        {
+            std::cerr << "[playlog_analytics] Unknown argument: " << arg << "\n";
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!(cell_size > 0.0f) || bucket_ticks == 0 || thread_count == 0)
+    {
+        std::cerr << "[playlog_analytics] --cell, --bucket and --threads must be positive" << "\n";
+
+        return EXIT_FAILURE;
+    }
+
+    // The calling thread works too
+    WorkerPool worker_pool(thread_count - 1);
+    const auto start = std::chrono::steady_clock::now();
+
+    if (command == "ingest")
+    {
+        if (inputs.empty())
+        {
+            inputs.emplace_back(analytics_constants::DEFAULT_PLAYLOG_DIR);
+        }
+
+        const auto playlogs = PlaylogStore::find_playlogs(inputs);
+        IngestResult result = {};
+
+        if (!PlaylogStore::ingest(playlogs, store_dir, worker_pool, result))
+        {
+            return EXIT_FAILURE;
+        }
+
+        std::cerr << "[playlog_analytics] " << result.files << " files, " << result.sessions << " sessions, "
+                  << result.frames << " frames (" << result.skipped_lines << " lines skipped) in "
+                  << seconds_since(start) << "s" << "\n";
+
+        return 0;
+    }
+
+    PlaylogStore store;
+
+    if (!store.open(store_dir))
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (command == "deaths")
+    {
+        const auto heatmap = query_death_heatmap(store, filter, cell_size);
+
+        // Top row first, as the stage is seen
+        std::cout << "# " << heatmap.deaths << " deaths, cells of " << heatmap.cell_size << " units" << "\n";
+
+        for (uint32_t row = heatmap.rows; row-- > 0; )
+        {
+            for (uint32_t column = 0; column < heatmap.columns; column++)
+            {
+                std::cout << (column > 0 ? "," : "") << heatmap.at(column, row);
+            }
+
+            std::cout << "\n";
+        }
+    }
+    else if (command == "density")
+    {
+        const auto density = query_bullet_density(store, filter, bucket_ticks, worker_pool);
+
+        std::cout << "tick,frames,mean_bullets" << "\n";
+
+        for (size_t bucket = 0; bucket < density.frames.size(); bucket++)
+        {
+            std::cout << bucket * bucket_ticks << "," << density.frames[bucket] << "," << density.mean(bucket) << "\n";
+        }
+    }
+    else if (command == "hits")
+    {
+        std::cout << "bullet,hits" << "\n";
+
+        for (const auto& count : query_hit_counts(store, filter))
+        {
+            std::cout << bullet_name_str(count.bullet_name) << "," << count.hits << "\n";
+        }
+    }
+    else
+    {
+        print_usage();
+
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << "[playlog_analytics] " << store.get_sessions().size() << " sessions queried in " << seconds_since(start) << "s" << "\n";
+
+    return 0;
+}
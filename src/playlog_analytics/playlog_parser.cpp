@@ -0,0 +1,397 @@
+#include "playlog_parser.hpp"
+
+#include <charconv>     // std::from_chars
+#include <packet_template/packet_template.hpp>
+#include "../game_server/game_server_utils.hpp"
+
+namespace {
+    // Forward only reader over one JSON line, a failed read leaves it failed
+    class JsonCursor {
+    public:
+        explicit JsonCursor(std::string_view text)
+            : m_text(text)
+            , m_pos(0)
+            , m_failed(false)
+        {}
+
+        // Consumes `c` if it is the next character
+        bool consume(char c) {
+            skip_whitespace();
+
+            if (!m_failed && m_pos < m_text.size() && m_text[m_pos] == c)
+            {
+                m_pos++;
+
+                return true;
+            }
+
+            return false;
+        }
+
+        bool expect(char c) {
+            if (!consume(c))
+            {
+                m_failed = true;
+            }
+
+            return !m_failed;
+        }
+
+        // The playlogs only hold plain keys and names, an escape is skipped over but not decoded
+        bool read_string(std::string_view& value) {
+            if (!expect('"'))
+            {
+                return false;
+            }
+
+            const auto begin = m_pos;
+
+            while (m_pos < m_text.size() && m_text[m_pos] != '"')
+            {
+                m_pos += m_text[m_pos] == '\\' ? 2 : 1;
+            }
+
+            if (m_pos >= m_text.size())
+            {
+                m_failed = true;
+
+                return false;
+            }
+
+            value = m_text.substr(begin, m_pos - begin);
+            m_pos++;
+
+            return true;
+        }
+
+        bool read_number(double& value) {
+            skip_whitespace();
+
+            const auto* begin = m_text.data() + m_pos;
+            const auto result = std::from_chars(begin, m_text.data() + m_text.size(), value);
+
+            if (m_failed || result.ec != std::errc())
+            {
+                m_failed = true;
+
+                return false;
+            }
+
+            m_pos += result.ptr - begin;
+
+            return true;
+        }
+
+        template <typename T>
+        bool read_number_as(T& value) {
+            double number = 0;
+
+            if (!read_number(number))
+            {
+                return false;
+            }
+
+            value = static_cast<T>(number);
+
+            return true;
+        }
+
+        bool skip_value() {
+            skip_whitespace();
+
+            if (m_failed || m_pos >= m_text.size())
+            {
+                m_failed = true;
+
+                return false;
+            }
+
+            const auto c = m_text[m_pos];
+
+            if (c == '"')
+            {
+                std::string_view ignored;
+
+                return read_string(ignored);
+            }
+
+            if (c == '{' || c == '[')
+            {
+                // Strings inside may hold brackets, so walk them
+                auto depth = 0;
+
+                do
+                {
+                    const auto current = m_text[m_pos];
+
+                    if (current == '"')
+                    {
+                        std::string_view ignored;
+
+                        if (!read_string(ignored))
+                        {
+                            return false;
+                        }
+
+                        continue;
+                    }
+
+                    depth += (current == '{' || current == '[') ? 1 : 0;
+                    depth -= (current == '}' || current == ']') ? 1 : 0;
+                    m_pos++;
+                }
+                while (depth > 0 && m_pos < m_text.size());
+
+                m_failed = depth != 0;
+
+                return !m_failed;
+            }
+
+            // Number, true, false or null
+            while (m_pos < m_text.size() && m_text[m_pos] != ',' && m_text[m_pos] != '}' && m_text[m_pos] != ']')
+            {
+                m_pos++;
+            }
+
+            return true;
+        }
+
+        bool failed() const { return m_failed; }
+
+    private:
+        void skip_whitespace() {
+            while (m_pos < m_text.size() && (m_text[m_pos] == ' ' || m_text[m_pos] == '\t' || m_text[m_pos] == '\r' || m_text[m_pos] == '\n'))
+            {
+                m_pos++;
+            }
+        }
+
+        std::string_view    m_text;
+        size_t              m_pos;
+        bool                m_failed;
+    };
+
+    // Calls on_member(key) for every member, which has to read or skip the value
+    template <typename F>
+    bool for_each_member(JsonCursor& cursor, F&& on_member) {
+        if (!cursor.expect('{'))
+        {
+            return false;
+        }
+
+        if (cursor.consume('}'))
+        {
+            return true;
+        }
+
+        do
+        {
+            std::string_view key;
+
+            if (!cursor.read_string(key) || !cursor.expect(':') || !on_member(key))
+            {
+                return false;
+            }
+        }
+        while (cursor.consume(','));
+
+        return cursor.expect('}');
+    }
+
+    template <typename F>
+    bool for_each_element(JsonCursor& cursor, F&& on_element) {
+        if (!cursor.expect('['))
+        {
+            return false;
+        }
+
+        if (cursor.consume(']'))
+        {
+            return true;
+        }
+
+        do
+        {
+            if (!on_element())
+            {
+                return false;
+            }
+        }
+        while (cursor.consume(','));
+
+        return cursor.expect(']');
+    }
+
+    bool read_pos(JsonCursor& cursor, float& x, float& y) {
+        return for_each_member(cursor, [&](std::string_view key) {
+            if (key == "x") { return cursor.read_number_as(x); }
+            if (key == "y") { return cursor.read_number_as(y); }
+
+            return cursor.skip_value();
+        });
+    }
+}
+
+bool PlaylogParser::parse_header(std::string_view line, PlaylogHeader& header) {
+    JsonCursor cursor(line);
+    auto found = false;
+
+    header = {};
+
+    const auto ok = for_each_member(cursor, [&](std::string_view key) {
+        if (key != "header")
+        {
+            return cursor.skip_value();
+        }
+
+        found = true;
+
+        return for_each_member(cursor, [&](std::string_view header_key) {
+            if (header_key == "instance_id") { return cursor.read_number_as(header.instance_id); }
+
+            return cursor.skip_value();
+        });
+    });
+
+    return ok && found;
+}
+
+bool PlaylogParser::parse_frame(std::string_view line, PlaylogFrame& frame, const PlaylogFrame* previous) {
+    JsonCursor cursor(line);
+    auto found_timestamp = false;
+    float player_radius = 0;
+
+    frame = {};
+    frame.killer_name = NO_BULLET;
+    m_bullets.clear();
+
+    const auto ok = for_each_member(cursor, [&](std::string_view key) {
+        if (key == "timestamp")
+        {
+            found_timestamp = true;
+
+            return cursor.read_number_as(frame.timestamp);
+        }
+
+        if (key == "state") { return cursor.read_number_as(frame.state); }
+
+        if (key == "stage")
+        {
+            return for_each_member(cursor, [&](std::string_view stage_key) {
+                if (stage_key == "id") { return cursor.read_number_as(frame.stage_id); }
+
+                return cursor.skip_value();
+            });
+        }
+
+        // The first player is the one the game is over for
+        if (key == "player_vector")
+        {
+            return for_each_element(cursor, [&] {
+                if (frame.has_player)
+                {
+                    return cursor.skip_value();
+                }
+
+                frame.has_player = true;
+
+                return for_each_member(cursor, [&](std::string_view player_key) {
+                    if (player_key == "pos")    { return read_pos(cursor, frame.player_x, frame.player_y); }
+                    if (player_key == "radius") { return cursor.read_number_as(player_radius); }
+
+                    return cursor.skip_value();
+                });
+            });
+        }
+
+        if (key == "bullet_vector")
+        {
+            return for_each_element(cursor, [&] {
+                Bullet bullet = {};
+                frame.bullet_count++;
+
+                const auto bullet_ok = for_each_member(cursor, [&](std::string_view bullet_key) {
+                    if (bullet_key == "name")   { return cursor.read_number_as(bullet.name); }
+                    if (bullet_key == "pos")    { return read_pos(cursor, bullet.x, bullet.y); }
+                    if (bullet_key == "vel")    { return read_pos(cursor, bullet.vx, bullet.vy); }
+                    if (bullet_key == "radius") { return cursor.read_number_as(bullet.radius); }
+
+                    return cursor.skip_value();
+                });
+
+                m_bullets.push_back(bullet);
+
+                return bullet_ok;
+            });
+        }
+
+        return cursor.skip_value();
+    });
+
+    if (!ok || !found_timestamp)
+    {
+        return false;
+    }
+
+    frame.game_over = (frame.state & static_cast<uint32_t>(GameState::GameOver)) != 0;
+
+    if (frame.game_over && frame.has_player)
+    {
+        find_killer(frame, player_radius, previous);
+    }
+
+    return true;
+}
+
+// The collision that ended the game is still in this frame
+void PlaylogParser::find_killer(PlaylogFrame& frame, float player_radius, const PlaylogFrame* previous) const {
+    auto best_distance = 0.0f;
+
+    // The closest overlapping bullet made it
+    for (const auto& bullet : m_bullets)
+    {
+        const auto dx = bullet.x - frame.player_x;
+        const auto dy = bullet.y - frame.player_y;
+        const auto reach = bullet.radius + player_radius;
+        const auto distance = dx * dx + dy * dy;
+
+        if (distance <= reach * reach && (frame.killer_name == NO_BULLET || distance < best_distance))
+        {
+            frame.killer_name = bullet.name;
+            best_distance = distance;
+        }
+    }
+
+    if (frame.killer_name != NO_BULLET)
+    {
+        return;
+    }
+
+    // Passed through the player within the tick, the first one to touch it made it
+    PlayerSnapshot player = {};
+    player.pos = { frame.player_x, frame.player_y };
+    player.radius = player_radius;
+
+    const auto player_from = previous != nullptr && previous->has_player
+                           ? Vec2{ previous->player_x, previous->player_y }
+                           : player.pos;
+
+    auto best_contact_time = 0.0f;
+
+    for (const auto& bullet : m_bullets)
+    {
+        BulletSnapshot swept = {};
+        swept.pos = { bullet.x, bullet.y };
+        swept.radius = bullet.radius;
+
+        const Vec2 bullet_from = { bullet.x - bullet.vx, bullet.y - bullet.vy };
+        auto contact_time = 0.0f;
+
+        if (detect_swept_collision(player, player_from, swept, bullet_from, contact_time)
+            && (frame.killer_name == NO_BULLET || contact_time < best_contact_time))
+        {
+            frame.killer_name = bullet.name;
+            best_contact_time = contact_time;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+constexpr uint32_t NO_BULLET = UINT32_MAX;
+
+// First line of a playlog
+struct PlaylogHeader {
+    uint64_t    instance_id;
+};
+
+// What the analytics keep of a frame line
+struct PlaylogFrame {
+    uint64_t    timestamp;
+    uint32_t    state;
+    uint32_t    stage_id;
+    bool        has_player;
+    bool        game_over;
+    float       player_x;
+    float       player_y;
+    uint32_t    bullet_count;
+    uint32_t    killer_name;    // Game over frames: name of the bullet that hit the player, else NO_BULLET
+};
+
+/*
+    Reads the JSON lines GameLogger writes (see FrameJsonWriter).
+
+    Only the fields the analytics need are decoded, everything else is
+    skipped without being copied. Keys may come in any order. A parser
+    keeps the bullets of the line it is looking at, one per thread.
+
+    The bullet that ended a game is the closest one on the player. Under
+    swept collision it may have passed through the player during the tick,
+    it is then told with the same swept test the server uses: the bullets
+    moved by their velocity, the player from its position in `previous`.
+*/
+class PlaylogParser {
+public:
+    bool parse_header(std::string_view line, PlaylogHeader& header);
+
+    // `previous`: the frame before in the same playlog, if there is one
+    bool parse_frame(std::string_view line, PlaylogFrame& frame, const PlaylogFrame* previous = nullptr);
+
+private:
+    struct Bullet {
+        uint32_t    name;
+        float       x;
+        float       y;
+        float       vx;
+        float       vy;
+        float       radius;
+    };
+
+    void find_killer(PlaylogFrame& frame, float player_radius, const PlaylogFrame* previous) const;
+
+    std::vector<Bullet> m_bullets;
+};
@@ -0,0 +1,137 @@
+#include "playlog_queries.hpp"
+
+#include <iostream>
+#include <cmath>        // std::floor, std::ceil
+#include <map>
+#include <algorithm>    // std::clamp, std::sort
+#include <packet_template/packet_template.hpp>
+#include "playlog_parser.hpp"
+#include "../game_server/game_server_constants.hpp"
+
+namespace {
+    bool matches(const PlaylogSession& session, const QueryFilter& filter) {
+        return !filter.stage_id.has_value() || session.stage_id == *filter.stage_id;
+    }
+}
+
+DeathHeatmap query_death_heatmap(const PlaylogStore& store, const QueryFilter& filter, float cell_size) {
+    DeathHeatmap heatmap = {};
+    heatmap.cell_size = cell_size;
+    heatmap.columns = static_cast<uint32_t>(std::ceil(game_constants::GAME_WIDTH / cell_size));
+    heatmap.rows = static_cast<uint32_t>(std::ceil(game_constants::GAME_HEIGHT / cell_size));
+    heatmap.counts.assign(static_cast<size_t>(heatmap.columns) * heatmap.rows, 0);
+
+    // Deaths are in the session index, no segment has to be read
+    for (const auto& session : store.get_sessions())
+    {
+        if (!session.died || !matches(session, filter))
+        {
+            continue;
+        }
+
+        const auto column = static_cast<int64_t>(std::floor((session.death_x + game_constants::GAME_WIDTH_HALF) / cell_size));
+        const auto row = static_cast<int64_t>(std::floor((session.death_y + game_constants::GAME_HEIGHT_HALF) / cell_size));
+
+        const auto x = std::clamp<int64_t>(column, 0, heatmap.columns - 1);
+        const auto y = std::clamp<int64_t>(row, 0, heatmap.rows - 1);
+
+        heatmap.counts[y * heatmap.columns + x]++;
+        heatmap.deaths++;
+    }
+
+    return heatmap;
+}
+
+BulletDensity query_bullet_density(const PlaylogStore& store, const QueryFilter& filter, uint32_t bucket_ticks, WorkerPool& worker_pool) {
+    const auto& sessions = store.get_sessions();
+    const auto segment_count = store.get_segment_count();
+
+    // Each segment is scanned into its own buckets, merged afterwards
+    std::vector<BulletDensity> partials(segment_count, BulletDensity{ bucket_ticks, {}, {} });
+
+    worker_pool.parallel_for(segment_count, [&](size_t index) {
+        PlaylogSegment segment;
+
+        if (!store.load_segment(index, segment))
+        {
+            std::cerr << "[PlaylogQueries] ERROR: Segment " << index << " is unreadable, it has been left out" << "\n";
+
+            return;
+        }
+
+        auto& partial = partials[index];
+
+        for (size_t row = 0; row < segment.size(); row++)
+        {
+            if (!matches(sessions[segment.session[row]], filter))
+            {
+                continue;
+            }
+
+            const auto bucket = segment.tick[row] / bucket_ticks;
+
+            if (bucket >= partial.frames.size())
+            {
+                partial.frames.resize(bucket + 1, 0);
+                partial.bullets.resize(bucket + 1, 0);
+            }
+
+            partial.frames[bucket]++;
+            partial.bullets[bucket] += segment.bullet_count[row];
+        }
+    });
+
+    BulletDensity density = { bucket_ticks, {}, {} };
+
+    for (const auto& partial : partials)
+    {
+        if (partial.frames.size() > density.frames.size())
+        {
+            density.frames.resize(partial.frames.size(), 0);
+            density.bullets.resize(partial.frames.size(), 0);
+        }
+
+        for (size_t bucket = 0; bucket < partial.frames.size(); bucket++)
+        {
+            density.frames[bucket] += partial.frames[bucket];
+            density.bullets[bucket] += partial.bullets[bucket];
+        }
+    }
+
+    return density;
+}
+
+std::vector<HitCount> query_hit_counts(const PlaylogStore& store, const QueryFilter& filter) {
+    std::map<uint32_t, uint32_t> hits;
+
+    for (const auto& session : store.get_sessions())
+    {
+        if (session.died && matches(session, filter))
+        {
+            hits[session.killer_name]++;
+        }
+    }
+
+    std::vector<HitCount> counts;
+
+    for (const auto& [bullet_name, count] : hits)
+    {
+        counts.push_back({ bullet_name, count });
+    }
+
+    std::stable_sort(counts.begin(), counts.end(), [](const HitCount& a, const HitCount& b) {
+        return a.hits > b.hits;
+    });
+
+    return counts;
+}
+
+const char* bullet_name_str(uint32_t bullet_name) {
+    if (bullet_name == NO_BULLET)                                   { return "unknown"; }
+    if (bullet_name == static_cast<uint32_t>(BulletName::BigRed))   { return "big_red"; }
+    if (bullet_name == static_cast<uint32_t>(BulletName::WedgeRed)) { return "wedge_red"; }
+    if (bullet_name == static_cast<uint32_t>(BulletName::RiceRed))  { return "rice_red"; }
+    if (bullet_name == static_cast<uint32_t>(BulletName{}))         { return "normal"; }
+
+    return "other";
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "playlog_store.hpp"
+
+struct QueryFilter {
+    std::optional<uint32_t> stage_id;   // All stages if not set
+};
+
+// Deaths per cell of a grid over the stage, row 0 at the bottom
+struct DeathHeatmap {
+    float                   cell_size;
+    uint32_t                columns;
+    uint32_t                rows;
+    std::vector<uint32_t>   counts;     // rows * columns
+    uint32_t                deaths;
+
+    uint32_t at(uint32_t column, uint32_t row) const { return counts[row * columns + column]; }
+};
+
+// Mean bullets on screen per bucket of ticks, over the sessions that lasted into the bucket
+struct BulletDensity {
+    uint32_t                bucket_ticks;
+    std::vector<uint64_t>   bullets;    // Summed over the frames of the bucket
+    std::vector<uint64_t>   frames;
+
+    double mean(size_t bucket) const { return frames[bucket] == 0 ? 0.0 : double(bullets[bucket]) / frames[bucket]; }
+};
+
+// Game overs by the bullet that caused them, the bullet names stand for the patterns firing them
+struct HitCount {
+    uint32_t    bullet_name;    // NO_BULLET: not told from the log
+    uint32_t    hits;
+};
+
+DeathHeatmap query_death_heatmap(const PlaylogStore& store, const QueryFilter& filter, float cell_size);
+BulletDensity query_bullet_density(const PlaylogStore& store, const QueryFilter& filter, uint32_t bucket_ticks, WorkerPool& worker_pool);
+std::vector<HitCount> query_hit_counts(const PlaylogStore& store, const QueryFilter& filter);   // Most hits first
+
+// Name the stage files use for the bullet, see stages/default.lua
+const char* bullet_name_str(uint32_t bullet_name);
@@ -0,0 +1,358 @@
+#include "playlog_store.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>    // std::min, std::sort
+#include "playlog_parser.hpp"
+#include "../game_server/state_codec.hpp"
+#include "../config_constants.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr uint32_t STORE_MAGIC      = 0x53504842;   // "BHPS"
+    constexpr uint32_t STORE_VERSION    = 1;
+
+    constexpr const char* INDEX_FILE    = "sessions.bin";
+
+    std::string segment_file(size_t index) {
+        return "segment_" + std::to_string(index) + ".bin";
+    }
+
+    // Sessions and frames of one segment while it is being ingested
+    struct SegmentBuild {
+        PlaylogSegment              columns;
+        std::vector<PlaylogSession> sessions;
+        std::vector<std::string>    sources;
+        size_t                      frames          = 0;
+        size_t                      skipped_lines   = 0;
+        bool                        failed          = false;
+    };
+
+    void ingest_file(const std::string& path, PlaylogParser& parser, SegmentBuild& build) {
+        std::ifstream file(path);
+
+        if (!file)
+        {
+            std::cerr << "[PlaylogStore] ERROR: Failed to open " << path << "\n";
+
+            return;
+        }
+
+        PlaylogSession session = {};
+        session.killer_name = NO_BULLET;
+        session.first_row = static_cast<uint32_t>(build.columns.size());
+
+        const auto local_session = static_cast<uint32_t>(build.sessions.size());
+
+        std::string line;
+        PlaylogHeader header;
+        PlaylogFrame frame;
+        PlaylogFrame previous = {};
+        auto first_line = true;
+
+        while (std::getline(file, line))
+        {
+            // Written once the game is over, at the top
+            if (first_line && parser.parse_header(line, header))
+            {
+                session.instance_id = header.instance_id;
+                first_line = false;
+
+                continue;
+            }
+
+            first_line = false;
+
+            if (!parser.parse_frame(line, frame, session.row_count > 0 ? &previous : nullptr))
+            {
+                build.skipped_lines++;
+
+                continue;
+            }
+
+            previous = frame;
+
+            if (session.row_count == 0)
+            {
+                session.stage_id = frame.stage_id;
+                session.first_tick = frame.timestamp;
+            }
+
+            session.row_count++;
+            session.last_tick = frame.timestamp;
+
+            if (frame.game_over && !session.died)
+            {
+                session.died = 1;
+                session.death_tick = frame.timestamp;
+                session.death_x = frame.player_x;
+                session.death_y = frame.player_y;
+                session.killer_name = frame.killer_name;
+            }
+
+            auto& columns = build.columns;
+            columns.session.push_back(local_session);
+            columns.tick.push_back(static_cast<uint32_t>(frame.timestamp));
+            columns.bullet_count.push_back(frame.bullet_count);
+            columns.player_x.push_back(frame.player_x);
+            columns.player_y.push_back(frame.player_y);
+        }
+
+        // A playlog without a frame is not a session
+        if (session.row_count > 0)
+        {
+            build.sessions.push_back(session);
+            build.sources.push_back(fs::path(path).filename().string());
+            build.frames += session.row_count;
+        }
+    }
+
+    bool write_file(const fs::path& path, const StateWriter& writer) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const auto& buffer = writer.get_buffer();
+
+        file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+        return static_cast<bool>(file);
+    }
+
+    bool read_file(const fs::path& path, std::vector<uint8_t>& buffer) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        buffer.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+        return static_cast<bool>(file);
+    }
+
+    bool read_magic(StateReader& reader) {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+
+        return reader.read(magic) && reader.read(version) && magic == STORE_MAGIC && version == STORE_VERSION;
+    }
+}
+
+bool PlaylogStore::ingest(
+    const std::vector<std::string>& playlog_paths,
+    const std::string& store_dir,
+    WorkerPool& worker_pool,
+    IngestResult& result
+) {
+    result = {};
+    result.files = playlog_paths.size();
+
+    std::error_code ec;
+    fs::create_directories(store_dir, ec);
+
+    if (ec)
+    {
+        std::cerr << "[PlaylogStore] ERROR: Failed to create " << store_dir << ": " << ec.message() << "\n";
+
+        return false;
+    }
+
+    // Only what a previous ingest left, the directory may hold other files
+    for (const auto& entry : fs::directory_iterator(store_dir, ec))
+    {
+        const auto name = entry.path().filename().string();
+
+        if (name == INDEX_FILE || (name.rfind("segment_", 0) == 0 && entry.path().extension() == ".bin"))
+        {
+            fs::remove(entry.path(), ec);
+        }
+    }
+
+    // Files are dealt round robin, so the segments get a similar share of the playlogs
+    const auto max_segments = (worker_pool.get_worker_count() + 1) * analytics_constants::SEGMENTS_PER_THREAD;
+    const auto segment_count = std::max<size_t>(1, std::min(playlog_paths.size(), max_segments));
+
+    std::vector<SegmentBuild> builds(segment_count);
+
+    worker_pool.parallel_for(segment_count, [&](size_t segment) {
+        PlaylogParser parser;
+
+        for (size_t i = segment; i < playlog_paths.size(); i += segment_count)
+        {
+            ingest_file(playlog_paths[i], parser, builds[segment]);
+        }
+    });
+
+    // Global session indices, in segment order
+    std::vector<PlaylogSession> sessions;
+    std::vector<std::string> sources;
+
+    for (size_t segment = 0; segment < segment_count; segment++)
+    {
+        auto& build = builds[segment];
+        const auto base = static_cast<uint32_t>(sessions.size());
+
+        for (auto& session : build.sessions)
+        {
+            session.segment = static_cast<uint32_t>(segment);
+            sessions.push_back(session);
+        }
+
+        for (auto& local_session : build.columns.session)
+        {
+            local_session += base;
+        }
+
+        sources.insert(sources.end(), build.sources.begin(), build.sources.end());
+
+        result.frames += build.frames;
+        result.skipped_lines += build.skipped_lines;
+    }
+
+    result.sessions = sessions.size();
+
+    worker_pool.parallel_for(segment_count, [&](size_t segment) {
+        const auto& columns = builds[segment].columns;
+
+        StateWriter writer;
+        writer.write(STORE_MAGIC);
+        writer.write(STORE_VERSION);
+        writer.write_vector(columns.session);
+        writer.write_vector(columns.tick);
+        writer.write_vector(columns.bullet_count);
+        writer.write_vector(columns.player_x);
+        writer.write_vector(columns.player_y);
+
+        builds[segment].failed = !write_file(fs::path(store_dir) / segment_file(segment), writer);
+    });
+
+    for (const auto& build : builds)
+    {
+        if (build.failed)
+        {
+            std::cerr << "[PlaylogStore] ERROR: Failed to write a segment to " << store_dir << "\n";
+
+            return false;
+        }
+    }
+
+    // The index goes last, a store without one is incomplete
+    StateWriter writer;
+    writer.write(STORE_MAGIC);
+    writer.write(STORE_VERSION);
+    writer.write(static_cast<uint32_t>(segment_count));
+    writer.write_vector(sessions);
+
+    for (const auto& source : sources)
+    {
+        writer.write_string(source);
+    }
+
+    if (!write_file(fs::path(store_dir) / INDEX_FILE, writer))
+    {
+        std::cerr << "[PlaylogStore] ERROR: Failed to write the session index to " << store_dir << "\n";
+
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<std::string> PlaylogStore::find_playlogs(const std::vector<std::string>& paths) {
+    std::vector<std::string> playlogs;
+
+    auto is_playlog = [](const fs::path& path) {
+        const auto name = path.filename().string();
+        const std::string suffix = "_playlog.json";
+
+        return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+
+    for (const auto& path : paths)
+    {
+        std::error_code ec;
+
+        if (fs::is_directory(path, ec))
+        {
+            for (const auto& entry : fs::recursive_directory_iterator(path, ec))
+            {
+                if (entry.is_regular_file(ec) && is_playlog(entry.path()))
+                {
+                    playlogs.push_back(entry.path().string());
+                }
+            }
+        }
+        else if (fs::is_regular_file(path, ec))
+        {
+            playlogs.push_back(path);
+        }
+    }
+
+    // Same store for the same files, whatever order the directory lists them in
+    std::sort(playlogs.begin(), playlogs.end());
+
+    return playlogs;
+}
+
+bool PlaylogStore::open(const std::string& store_dir) {
+    std::vector<uint8_t> buffer;
+
+    if (!read_file(fs::path(store_dir) / INDEX_FILE, buffer))
+    {
+        std::cerr << "[PlaylogStore] ERROR: No session index in " << store_dir << "\n";
+
+        return false;
+    }
+
+    StateReader reader(buffer);
+    uint32_t segment_count = 0;
+
+    if (!read_magic(reader) || !reader.read(segment_count) || !reader.read_vector(m_sessions))
+    {
+        std::cerr << "[PlaylogStore] ERROR: Unreadable session index in " << store_dir << "\n";
+
+        return false;
+    }
+
+    m_sources.resize(m_sessions.size());
+
+    for (auto& source : m_sources)
+    {
+        if (!reader.read_string(source))
+        {
+            return false;
+        }
+    }
+
+    m_store_dir = store_dir;
+    m_segment_count = segment_count;
+
+    return true;
+}
+
+bool PlaylogStore::load_segment(size_t index, PlaylogSegment& segment) const {
+    std::vector<uint8_t> buffer;
+
+    if (index >= m_segment_count || !read_file(fs::path(m_store_dir) / segment_file(index), buffer))
+    {
+        return false;
+    }
+
+    StateReader reader(buffer);
+
+    const auto ok = read_magic(reader)
+        && reader.read_vector(segment.session)
+        && reader.read_vector(segment.tick)
+        && reader.read_vector(segment.bullet_count)
+        && reader.read_vector(segment.player_x)
+        && reader.read_vector(segment.player_y);
+
+    const auto rows = segment.tick.size();
+    const auto expr_1 = segment.session.size() == rows && segment.bullet_count.size() == rows;
+    const auto expr_2 = segment.player_x.size() == rows && segment.player_y.size() == rows;
+
+    return ok && expr_1 && expr_2;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../game_server/worker_pool.hpp"
+
+// One playlog, kept in the session index
+struct PlaylogSession {
+    uint64_t    instance_id;
+    uint32_t    stage_id;
+    uint32_t    segment;
+    uint32_t    first_row;      // Of its frames in the segment
+    uint32_t    row_count;
+    uint64_t    first_tick;
+    uint64_t    last_tick;
+    uint64_t    death_tick;     // Valid if `died`
+    float       death_x;
+    float       death_y;
+    uint32_t    killer_name;    // NO_BULLET if the bullet could not be told
+    uint32_t    died;
+};
+
+// Frame columns of one segment, a row per logged frame
+struct PlaylogSegment {
+    std::vector<uint32_t>   session;        // Index into the session index
+    std::vector<uint32_t>   tick;
+    std::vector<uint32_t>   bullet_count;
+    std::vector<float>      player_x;
+    std::vector<float>      player_y;
+
+    size_t size() const { return tick.size(); }
+};
+
+struct IngestResult {
+    size_t  files;
+    size_t  sessions;
+    size_t  frames;
+    size_t  skipped_lines;      // Lines that are not a frame, a torn last line for instance
+};
+
+/*
+    Columnar store of many playlogs.
+
+    A store is a directory with a session index (sessions.bin) and segments
+    (segment_N.bin) holding the frame columns of a share of the sessions.
+    A frame is a few numbers in there instead of a JSON line of every
+    entity, and queries scan the segments in parallel.
+*/
+class PlaylogStore {
+public:
+    // Parses the playlogs on the pool into `store_dir`, replacing a previous store there
+    static bool ingest(
+        const std::vector<std::string>& playlog_paths,
+        const std::string& store_dir,
+        WorkerPool& worker_pool,
+        IngestResult& result
+    );
+
+    // Files ending in _playlog.json, directories are searched recursively
+    static std::vector<std::string> find_playlogs(const std::vector<std::string>& paths);
+
+    // Loads the session index
+    bool open(const std::string& store_dir);
+
+    const std::vector<PlaylogSession>& get_sessions() const { return m_sessions; }
+    const std::string& get_source(uint32_t session) const { return m_sources[session]; }
+
+    size_t get_segment_count() const { return m_segment_count; }
+    bool load_segment(size_t index, PlaylogSegment& segment) const;
+
+private:
+    std::string                 m_store_dir;
+    std::vector<PlaylogSession> m_sessions;
+    std::vector<std::string>    m_sources;
+    size_t                      m_segment_count = 0;
+};
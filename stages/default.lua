@@ -0,0 +1,37 @@
+-- The boss stage, the server plays the same one built in when this file is missing
+--
+-- Enemy:   spawn_tick, id, pos, vel, radius (optional), bounce (optional), emitters
+-- Bounce:  moves inside the box at `speed` for the first `active_ticks` of every `cycle` ticks
+-- Emitter: fires every `interval` ticks while tick % cycle > cycle_phase (cycle = 0: always)
+--          and after start_tick. pattern: circle, homing, spiral, random
+--          bullet: big_red, wedge_red, rice_red, normal (bullet_radius overrides the sprite's)
+
+stage = {
+    name = "default",
+
+    enemies = {
+        {
+            spawn_tick = 0,
+            id = 0,
+            pos = { x = 0, y = 120 },
+            vel = { x = 2, y = 2 },
+
+            bounce = {
+                speed = 2,
+                min_x = -GAME_WIDTH_HALF,
+                max_x = GAME_WIDTH_HALF,
+                min_y = 60,
+                max_y = GAME_HEIGHT_HALF,
+                cycle = 360,
+                active_ticks = 120,
+            },
+
+            emitters = {
+                { pattern = "circle", interval = 60, cycle = 360, cycle_phase = 120, count = 8, speed = 2.0, bullet = "big_red" },
+                { pattern = "homing", interval = 30, cycle = 360, cycle_phase = 120, count = 1, speed = 2.5, bullet = "wedge_red" },
+                { pattern = "spiral", interval = 8,  cycle = 360, cycle_phase = 120, count = 7, speed = 2.0, bullet = "rice_red" },
+                { pattern = "random", interval = 60, start_tick = 120, count = 7, speed = 2.0, bullet = "normal" },
+            },
+        },
+    },
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <game_server/admission_controller.hpp>
+
+using namespace std::chrono_literals;
+
+namespace {
+    // Simulated clock, advanced by hand
+    struct FakeClock {
+        AdmissionController::TimePoint now{};
+
+        void advance(AdmissionController::Duration d) { now += d; }
+    };
+
+    // Reports `ticks` ticks of `busy` each, one every 1/60 sec (rounded up)
+    void run_ticks(AdmissionController& admission, FakeClock& clock, uint64_t instance_id, AdmissionController::Duration busy, int ticks) {
+        for (int i = 0; i < ticks; i++)
+        {
+            clock.advance(16667us);
+            admission.record_busy(instance_id, busy, clock.now);
+        }
+    }
+}
+
+/***** AdmissionController ******************************************/
+TEST(AdmissionControllerTest, AcceptsWhileUnderBudget) {
+    FakeClock clock;
+    AdmissionController admission(2.0, 0.5, 100, 1s, 0.05);
+
+    EXPECT_EQ(admission.try_admit(), AdmissionResult::Accepted);
+    EXPECT_DOUBLE_EQ(admission.get_budget(), 1.0);
+    EXPECT_DOUBLE_EQ(admission.get_projected_utilization(), 0.05);
+}
+
+TEST(AdmissionControllerTest, RejectsWhenProjectionExceedsBudget) {
+    FakeClock clock;
+    AdmissionController admission(2.0, 0.5, 100, 1s, 0.05);
+
+    // Each instance keeps a core 30% busy (5 msec out of every 16.6 msec)
+    for (uint64_t id = 0; id < 3; id++)
+    {
+        admission.add_instance(id, clock.now);
+    }
+
+    for (int second = 0; second < 2; second++)
+    {
+        for (uint64_t id = 0; id < 3; id++)
+        {
+            FakeClock instance_clock = clock;
+            run_ticks(admission, instance_clock, id, 5ms, 60);
+        }
+
+        clock.advance(1s);
+    }
+
+    EXPECT_NEAR(admission.get_utilization(), 0.9, 0.01);
+    EXPECT_NEAR(admission.get_instance_estimate(), 0.3, 0.01);
+
+    // 0.9 + 0.3 > 1.0
+    EXPECT_EQ(admission.try_admit(), AdmissionResult::CpuBudget);
+
+    // Once an instance is gone there is room again
+    admission.remove_instance(2);
+    EXPECT_EQ(admission.try_admit(), AdmissionResult::Accepted);
+}
+
+TEST(AdmissionControllerTest, UnmeasuredInstancesCountAsEstimate) {
+    FakeClock clock;
+    AdmissionController admission(1.0, 1.0, 100, 1s, 0.25);
+
+    for (uint64_t id = 0; id < 3; id++)
+    {
+        admission.add_instance(id, clock.now);
+    }
+
+    // Within the first window nothing has been measured
+    run_ticks(admission, clock, 0, 1ms, 10);
+
+    EXPECT_DOUBLE_EQ(admission.get_utilization(), 0.75);
+    EXPECT_EQ(admission.try_admit(), AdmissionResult::Accepted);
+
+    admission.add_instance(3, clock.now);
+    EXPECT_EQ(admission.try_admit(), AdmissionResult::CpuBudget);
+}
+
+TEST(AdmissionControllerTest, UtilizationFollowsTheRollingWindow) {
+    FakeClock clock;
+    AdmissionController admission(4.0, 0.75, 100, 1s, 0.05);
+
+    admission.add_instance(0, clock.now);
+
+    run_ticks(admission, clock, 0, 8ms, 60);
+    EXPECT_NEAR(admission.get_utilization(), 0.48, 0.01);
+
+    // The load drops, the next window reflects it
+    run_ticks(admission, clock, 0, 2ms, 60);
+    EXPECT_NEAR(admission.get_utilization(), 0.12, 0.01);
+}
+
+TEST(AdmissionControllerTest, KeepsTheHardInstanceCap) {
+    FakeClock clock;
+    AdmissionController admission(64.0, 0.75, 2, 1s, 0.01);
+
+    admission.add_instance(0, clock.now);
+    admission.add_instance(1, clock.now);
+
+    EXPECT_EQ(admission.try_admit(), AdmissionResult::InstanceLimit);
+}
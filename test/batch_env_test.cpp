@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <game_server/batch_env.hpp>
+
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    // Same pseudo random actions for every run
+    std::vector<uint8_t> make_actions(size_t instance_count, uint64_t tick) {
+        std::vector<uint8_t> actions(instance_count);
+
+        for (size_t i = 0; i < instance_count; i++)
+        {
+            actions[i] = static_cast<uint8_t>((i * 7 + tick / 13) % 16);
+        }
+
+        return actions;
+    }
+
+    void run(BatchEnv& env, uint64_t ticks) {
+        for (uint64_t tick = 0; tick < ticks; tick++)
+        {
+            env.step(make_actions(env.get_instance_count(), tick).data());
+        }
+    }
+
+    void expect_same_observations(const BatchEnv& a, const BatchEnv& b) {
+        const auto instance_count = a.get_instance_count();
+
+        EXPECT_EQ(std::memcmp(a.get_infos(), b.get_infos(), instance_count * sizeof(EnvInfo)), 0);
+        EXPECT_EQ(std::memcmp(a.get_players(), b.get_players(), instance_count * sizeof(EnvPlayer)), 0);
+
+        for (size_t i = 0; i < instance_count; i++)
+        {
+            const auto& info = a.get_infos()[i];
+
+            EXPECT_EQ(std::memcmp(a.get_enemies() + i * a.get_max_enemies(), b.get_enemies() + i * b.get_max_enemies(), info.enemy_count * sizeof(EnvEnemy)), 0);
+            EXPECT_EQ(std::memcmp(a.get_bullets() + i * a.get_max_bullets(), b.get_bullets() + i * b.get_max_bullets(), info.bullet_count * sizeof(EnvBullet)), 0);
+        }
+    }
+}
+
+/***** BatchEnv *****************************************************/
+TEST(BatchEnvTest, ThreadCountDoesNotChangeTheGames) {
+    constexpr size_t INSTANCES = 100;
+
+    WorkerPool serial_pool(0);
+    WorkerPool parallel_pool(3);
+
+    BatchEnv serial(INSTANCES, serial_pool);
+    BatchEnv parallel(INSTANCES, parallel_pool);
+
+    run(serial, 600);
+    run(parallel, 600);
+
+    // Hit ones stay where they were hit
+    for (size_t i = 0; i < INSTANCES; i++)
+    {
+        const auto& info = serial.get_infos()[i];
+        EXPECT_TRUE(info.done || info.tick == 600u);
+    }
+
+    expect_same_observations(serial, parallel);
+}
+
+TEST(BatchEnvTest, ResetReplaysTheGameOfTheSeed) {
+    WorkerPool worker_pool(2);
+    BatchEnv env(40, worker_pool);
+
+    std::vector<uint32_t> seeds(40, 7);
+    env.reset_all(seeds.data());
+    run(env, 300);
+
+    // Same seed and actions, same game
+    BatchEnv replay(40, worker_pool);
+    replay.reset_all(seeds.data());
+    run(replay, 300);
+
+    expect_same_observations(env, replay);
+
+    // A single reset starts over
+    env.reset(3, 7);
+    EXPECT_EQ(env.get_infos()[3].tick, 0u);
+    EXPECT_EQ(env.get_infos()[3].done, 0u);
+    EXPECT_EQ(env.get_infos()[4].tick, replay.get_infos()[4].tick);
+}
+
+TEST(BatchEnvTest, ActionsMoveTheShip) {
+    WorkerPool worker_pool(0);
+    BatchEnv env(2, worker_pool);
+
+    const auto start = env.get_players()[0];
+    const uint8_t actions[] = { 0x1, 0 };
+
+    env.step(actions);
+
+    const auto held = env.get_players()[0];
+    const auto& idle = env.get_players()[1];
+
+    EXPECT_FLOAT_EQ(std::hypot(held.x - start.x, held.y - start.y), game_constants::PLAYER_SPEED);
+    EXPECT_EQ(idle.x, start.x);
+    EXPECT_EQ(idle.y, start.y);
+
+    // Released again
+    const uint8_t none[] = { 0, 0 };
+    env.step(none);
+
+    EXPECT_EQ(env.get_players()[0].x, held.x);
+}
+
+TEST(BatchEnvTest, KeepsTheClosestBulletsThatFit) {
+    WorkerPool worker_pool(0);
+    BatchEnv env(1, worker_pool, nullptr, 4, 8);
+
+    const uint8_t action = 0;
+    const auto& info = env.get_infos()[0];
+
+    while (info.bullets_total <= 8 && !info.done)
+    {
+        env.step(&action);
+    }
+
+    ASSERT_GT(info.bullets_total, 8u);
+    EXPECT_EQ(info.bullet_count, 8u);
+
+    // None of the dropped ones is closer than a kept one
+    const auto& player = env.get_players()[0];
+    const auto& frame = env.get_session(0).get_frame();
+
+    auto distance = [&](float x, float y) {
+        return (x - player.x) * (x - player.x) + (y - player.y) * (y - player.y);
+    };
+
+    float farthest_kept = 0.0f;
+
+    for (size_t i = 0; i < info.bullet_count; i++)
+    {
+        farthest_kept = std::max(farthest_kept, distance(env.get_bullets()[i].x, env.get_bullets()[i].y));
+    }
+
+    size_t closer = 0;
+
+    for (const auto& bullet : frame.bullet_vector)
+    {
+        closer += distance(bullet.pos.x, bullet.pos.y) <= farthest_kept;
+    }
+
+    EXPECT_EQ(closer, 8u);
+}
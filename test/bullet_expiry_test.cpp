@@ -0,0 +1,188 @@
+#include <gtest/gtest.h>
+#include <game_server/game_server_constants.hpp>
+#include <game_server/game_server_utils.hpp>
+#include <game_server/bullet_updater.hpp>
+#include <game_server/bullet_expiry.hpp>
+
+#include <cstring>
+#include <random>
+
+namespace {
+    // Fired from around the middle, some of them outside, some barely moving or not at all
+    void fire(FrameSnapshot& frame, std::mt19937& gen, uint32_t& bullet_id, size_t count) {
+        std::uniform_real_distribution<float> pos_dist(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> vel_dist(-4.0f, 4.0f);
+        std::uniform_int_distribution<int> kind_dist(0, 9);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            BulletSnapshot bullet = {};
+            bullet.id = bullet_id++;
+            bullet.pos = { pos_dist(gen), pos_dist(gen) };
+            bullet.vel = { vel_dist(gen), vel_dist(gen) };
+            bullet.radius = game_constants::ENEMY_RICE_BULLET_RADIUS;
+
+            switch (kind_dist(gen))
+            {
+                case 0: { bullet.vel = { 0.0f, 0.0f }; break; }
+                case 1: { bullet.vel.x *= 0.001f; bullet.vel.y = 0.0f; break; }
+                case 2: { bullet.pos.y = game_constants::GAME_HEIGHT_HALF + 0.9f; break; }
+                default: break;
+            }
+
+            frame.bullet_vector.push_back(bullet);
+            frame.bullet_count++;
+        }
+    }
+
+    FrameSnapshot make_frame() {
+        FrameSnapshot frame = {};
+
+        // Out of the way, no game over
+        PlayerSnapshot player = {};
+        player.pos = { 10000.0f, 10000.0f };
+        player.lives = 1;
+        frame.player_vector.push_back(player);
+
+        return frame;
+    }
+
+    void expect_same_bullets(const FrameSnapshot& a, const FrameSnapshot& b, uint64_t tick) {
+        ASSERT_EQ(a.bullet_vector.size(), b.bullet_vector.size()) << "tick " << tick;
+        ASSERT_EQ(a.bullet_count, b.bullet_count);
+
+        for (size_t i = 0; i < a.bullet_vector.size(); i++)
+        {
+            ASSERT_EQ(a.bullet_vector[i].id, b.bullet_vector[i].id) << "tick " << tick << ", index " << i;
+            ASSERT_EQ(std::memcmp(&a.bullet_vector[i].pos, &b.bullet_vector[i].pos, sizeof(Vec2)), 0);
+        }
+    }
+}
+
+/***** BulletExpiry *************************************************/
+TEST(BulletExpiryTest, CullsLikeTheFullScan) {
+    std::mt19937 gen(5);
+    uint32_t bullet_id = 0;
+
+    auto scanned = make_frame();
+    auto wheeled = make_frame();
+
+    BulletUpdater bullet_updater;
+    BulletExpiry expiry;
+
+    for (uint64_t tick = 1; tick <= 3000; tick++)
+    {
+        // Same bullets fired into both
+        auto gen_copy = gen;
+        auto id_copy = bullet_id;
+        fire(scanned, gen_copy, id_copy, tick % 7);
+        fire(wheeled, gen, bullet_id, tick % 7);
+
+        bullet_updater.update(scanned);
+        bullet_updater.update(wheeled, expiry);
+
+        expect_same_bullets(scanned, wheeled, tick);
+
+        if (HasFatalFailure())
+        {
+            return;
+        }
+    }
+
+    EXPECT_EQ(expiry.get_tracked_count(), wheeled.bullet_vector.size());
+}
+
+TEST(BulletExpiryTest, ChecksOnlyTheBulletsDueToLeave) {
+    auto frame = make_frame();
+    std::mt19937 gen(9);
+    uint32_t bullet_id = 0;
+
+    fire(frame, gen, bullet_id, 5000);
+
+    BulletUpdater bullet_updater;
+    BulletExpiry expiry;
+    size_t checked = 0;
+    size_t scanned = 0;
+
+    for (int tick = 0; tick < 120; tick++)
+    {
+        bullet_updater.update(frame, expiry);
+        checked += expiry.get_last_checked_count();
+        scanned += frame.bullet_vector.size();
+    }
+
+    // The full scan tests every live bullet every tick
+    EXPECT_LT(checked * 20, scanned);
+}
+
+TEST(BulletExpiryTest, RefiledBulletLeavesOnTime) {
+    auto scanned = make_frame();
+    auto wheeled = make_frame();
+
+    BulletSnapshot bullet = {};
+    bullet.id = 1;
+    bullet.pos = { 0.0f, 0.0f };
+    bullet.vel = { 0.0f, 0.1f };
+    scanned.bullet_vector.push_back(bullet);
+    scanned.bullet_count = 1;
+    wheeled.bullet_vector.push_back(bullet);
+    wheeled.bullet_count = 1;
+
+    BulletUpdater bullet_updater;
+    BulletExpiry expiry;
+
+    bullet_updater.update(scanned);
+    bullet_updater.update(wheeled, expiry);
+
+    // Turns towards the right edge, much faster
+    scanned.bullet_vector[0].vel = { 8.0f, 0.0f };
+    wheeled.bullet_vector[0].vel = { 8.0f, 0.0f };
+    expiry.refile(wheeled, 0);
+
+    for (uint64_t tick = 0; tick < 40; tick++)
+    {
+        bullet_updater.update(scanned);
+        bullet_updater.update(wheeled, expiry);
+
+        expect_same_bullets(scanned, wheeled, tick);
+    }
+
+    EXPECT_TRUE(wheeled.bullet_vector.empty());
+}
+
+TEST(BulletExpiryTest, EstimateIsNeverLate) {
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> pos_dist(-190.0f, 190.0f);
+    std::uniform_real_distribution<float> log_speed_dist(-4.0f, 1.0f);
+    std::uniform_real_distribution<float> angle_dist(0.0f, 6.2831853f);
+
+    for (int i = 0; i < 2000; i++)
+    {
+        BulletSnapshot bullet = {};
+        bullet.pos = { pos_dist(gen), pos_dist(gen) };
+
+        const auto speed = std::pow(10.0f, log_speed_dist(gen));
+        const auto angle = angle_dist(gen);
+        bullet.vel = { speed * std::cos(angle), speed * std::sin(angle) };
+
+        const auto estimate = estimate_exit_ticks(bullet);
+        ASSERT_GE(estimate, 1u);
+
+        // Moved the way the updater moves it
+        uint64_t ticks = 0;
+
+        while (ticks < estimate)
+        {
+            bullet.pos.x += bullet.vel.x;
+            bullet.pos.y += bullet.vel.y;
+            ticks++;
+
+            if (outside(bullet.pos.x, bullet.pos.y))
+            {
+                break;
+            }
+        }
+
+        EXPECT_TRUE(ticks == estimate) << "out after " << ticks << " of " << estimate << " estimated ticks";
+    }
+}
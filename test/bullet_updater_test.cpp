@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <game_server/game_server_constants.hpp>
+#include <game_server/bullet_updater.hpp>
+
+#include <atomic>
+#include <cstring>
+#include <random>
+
+namespace {
+    FrameSnapshot make_frame(size_t bullet_count, uint32_t seed) {
+        FrameSnapshot frame = {};
+
+        PlayerSnapshot player = {};
+        player.pos = { 0.0f, -120.0f };
+        player.radius = game_constants::PLAYER_RADIUS;
+        player.lives = 1;
+        frame.player_vector.push_back(player);
+
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> pos_dist(-250.0f, 250.0f);
+        std::uniform_real_distribution<float> vel_dist(-3.0f, 3.0f);
+
+        for (size_t i = 0; i < bullet_count; i++)
+        {
+            BulletSnapshot bullet = {};
+            bullet.id = static_cast<uint32_t>(i);
+            bullet.pos = { pos_dist(gen), pos_dist(gen) };
+            bullet.vel = { vel_dist(gen), vel_dist(gen) };
+            bullet.radius = game_constants::ENEMY_RICE_BULLET_RADIUS;
+            frame.bullet_vector.push_back(bullet);
+        }
+
+        frame.bullet_count = static_cast<uint32_t>(bullet_count);
+
+        return frame;
+    }
+
+    bool same_bits(const BulletSnapshot& a, const BulletSnapshot& b) {
+        return a.id == b.id
+            && std::memcmp(&a.pos, &b.pos, sizeof(a.pos)) == 0
+            && std::memcmp(&a.vel, &b.vel, sizeof(a.vel)) == 0;
+    }
+}
+
+/***** WorkerPool ***************************************************/
+TEST(WorkerPoolTest, RunsEveryIndexOnce) {
+    WorkerPool pool(4);
+    std::vector<std::atomic<int>> counts(1000);
+
+    pool.parallel_for(counts.size(), [&](size_t i) {
+        counts[i]++;
+    });
+
+    for (const auto& count : counts)
+    {
+        EXPECT_EQ(count.load(), 1);
+    }
+}
+
+/***** BulletUpdater ************************************************/
+TEST(BulletUpdaterTest, ParallelMatchesSerial) {
+    WorkerPool pool(4);
+    BulletUpdater parallel_updater(&pool, 0);
+
+    // Several chunks, the last one partial
+    const auto bullet_count = bullet_constants::PARALLEL_CHUNK_SIZE * 5 + 123;
+
+    auto serial_frame = make_frame(bullet_count, 42);
+    auto parallel_frame = make_frame(bullet_count, 42);
+
+    for (int tick = 0; tick < 30; tick++)
+    {
+        update_bullets_serial(serial_frame);
+        parallel_updater.update(parallel_frame);
+
+        ASSERT_EQ(serial_frame.bullet_vector.size(), parallel_frame.bullet_vector.size());
+        ASSERT_EQ(serial_frame.bullet_count, parallel_frame.bullet_count);
+        ASSERT_EQ(serial_frame.player_vector[0].lives, parallel_frame.player_vector[0].lives);
+        ASSERT_EQ(serial_frame.state, parallel_frame.state);
+
+        for (size_t i = 0; i < serial_frame.bullet_vector.size(); i++)
+        {
+            ASSERT_TRUE(same_bits(serial_frame.bullet_vector[i], parallel_frame.bullet_vector[i]));
+        }
+    }
+}
+
+TEST(BulletUpdaterTest, EngagesAboveThresholdOnly) {
+    WorkerPool pool(2);
+    BulletUpdater updater(&pool, 1000);
+    BulletUpdater serial_updater;
+
+    EXPECT_FALSE(updater.is_parallel(999));
+    EXPECT_TRUE(updater.is_parallel(1000));
+    EXPECT_FALSE(serial_updater.is_parallel(1000000));
+}
+
+TEST(BulletUpdaterTest, SweptCollisionCatchesFastBullets) {
+    // Crosses the player's hitbox between two ticks
+    auto make_tunneling_frame = [] {
+        FrameSnapshot frame = {};
+
+        PlayerSnapshot player = {};
+        player.pos = { 0.0f, -120.0f };
+        player.radius = game_constants::PLAYER_RADIUS;
+        player.lives = 1;
+        frame.player_vector.push_back(player);
+
+        BulletSnapshot bullet = {};
+        bullet.pos = { -18.0f, -120.0f };
+        bullet.vel = { 30.0f, 0.0f };
+        bullet.radius = game_constants::ENEMY_RICE_BULLET_RADIUS;
+        frame.bullet_vector.push_back(bullet);
+        frame.bullet_count = 1;
+
+        return frame;
+    };
+
+    BulletExpiry discrete_expiry;
+    BulletExpiry swept_expiry;
+    BulletUpdater discrete_updater;
+    BulletUpdater swept_updater;
+    swept_updater.set_collision_mode(CollisionMode::Swept);
+
+    auto discrete_frame = make_tunneling_frame();
+    auto swept_frame = make_tunneling_frame();
+
+    discrete_updater.update(discrete_frame, discrete_expiry);
+    swept_updater.update(swept_frame, swept_expiry);
+
+    EXPECT_EQ(discrete_frame.player_vector[0].lives, 1u);
+    EXPECT_EQ(swept_frame.player_vector[0].lives, 0u);
+    EXPECT_EQ(swept_frame.state, GameState::GameOver);
+}
+
+TEST(BulletUpdaterTest, SweptParallelMatchesSerial) {
+    WorkerPool pool(4);
+    BulletUpdater serial_updater;
+    BulletUpdater parallel_updater(&pool, 0);
+    serial_updater.set_collision_mode(CollisionMode::Swept);
+    parallel_updater.set_collision_mode(CollisionMode::Swept);
+
+    const auto bullet_count = bullet_constants::PARALLEL_CHUNK_SIZE * 3 + 7;
+
+    auto serial_frame = make_frame(bullet_count, 11);
+    auto parallel_frame = make_frame(bullet_count, 11);
+
+    BulletExpiry serial_expiry;
+    BulletExpiry parallel_expiry;
+
+    for (int tick = 0; tick < 30; tick++)
+    {
+        // The player moves too
+        const auto player_from = serial_frame.player_vector[0].pos;
+        serial_frame.player_vector[0].pos.x += 2.0f;
+        parallel_frame.player_vector[0].pos.x += 2.0f;
+
+        serial_updater.update(serial_frame, serial_expiry, player_from);
+        parallel_updater.update(parallel_frame, parallel_expiry, player_from);
+
+        ASSERT_EQ(serial_frame.bullet_vector.size(), parallel_frame.bullet_vector.size());
+        ASSERT_EQ(serial_frame.state, parallel_frame.state);
+    }
+}
@@ -0,0 +1,340 @@
+#include <gtest/gtest.h>
+#include <game_server/crash_checkpoint.hpp>
+#include <game_server/game_server.hpp>
+#include <game_server/local_transport.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    std::string temp_path(const std::string& name) {
+        return "/tmp/crash_checkpoint_test_" + std::to_string(getpid()) + "_" + name;
+    }
+
+    void step(GameSession& session, BulletUpdater& bullet_updater, int ticks) {
+        for (int tick = 0; tick < ticks; tick++)
+        {
+            session.step(bullet_updater);
+        }
+    }
+
+    void expect_same_game(const GameSession& a, const GameSession& b) {
+        const auto& frame_a = a.get_frame();
+        const auto& frame_b = b.get_frame();
+
+        EXPECT_EQ(frame_a.timestamp, frame_b.timestamp);
+        ASSERT_EQ(frame_a.bullet_vector.size(), frame_b.bullet_vector.size());
+
+        for (size_t i = 0; i < frame_a.bullet_vector.size(); i++)
+        {
+            EXPECT_EQ(frame_a.bullet_vector[i].id, frame_b.bullet_vector[i].id);
+            EXPECT_EQ(frame_a.bullet_vector[i].pos.x, frame_b.bullet_vector[i].pos.x);
+            EXPECT_EQ(frame_a.bullet_vector[i].pos.y, frame_b.bullet_vector[i].pos.y);
+        }
+    }
+
+    // Polls until a packet of the type arrives
+    std::optional<DeliveredPacket> wait_packet(LocalClient& client, PayloadType payload_type) {
+        for (int attempt = 0; attempt < 2000; attempt++)
+        {
+            while (auto packet_opt = client.poll_packet())
+            {
+                if (packet_opt->packet.header.payload_type == payload_type)
+                {
+                    return packet_opt;
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return std::nullopt;
+    }
+
+    uint64_t wait_frame(LocalClient& client) {
+        auto frame_opt = wait_packet(client, PayloadType::FrameSnapshot);
+
+        return frame_opt ? std::get<FrameSnapshot>(frame_opt->packet.payload).timestamp : 0;
+    }
+
+    // Through the handshake, the ServerGameResponse as the client gets it
+    std::optional<DeliveredPacket> start_game(LocalClient& client, std::optional<ResumeToken> resume_token) {
+        if (!client.send_packet(make_packet<ClientHello>({})) || !wait_packet(client, PayloadType::ServerAccept))
+        {
+            return std::nullopt;
+        }
+
+        const auto sent = resume_token ? client.send_game_request(*resume_token) : client.send_packet(make_packet<ClientGameRequest>({}));
+
+        return sent ? wait_packet(client, PayloadType::ServerGameResponse) : std::nullopt;
+    }
+
+    void wait_for_instances_to_end(GameServerMaster& master) {
+        for (int attempt = 0; attempt < 1000 && master.get_active_instances() > 0; attempt++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+/***** CrashCheckpointer ********************************************/
+TEST(CrashCheckpointTest, RestoredSessionsContinueTheSameGames) {
+    const auto path = temp_path("restore");
+
+    BulletUpdater bullet_updater;
+    GameSession first(11);
+    GameSession second(22);
+
+    step(first, bullet_updater, 300);
+    step(second, bullet_updater, 450);
+
+    CrashCheckpointer checkpointer(path);
+    checkpointer.add_session(7, first);
+    checkpointer.add_session(9, second);
+
+    ASSERT_TRUE(checkpointer.checkpoint());
+
+    std::vector<CheckpointEntry> entries;
+    uint64_t written_unix_msec = 0;
+
+    ASSERT_TRUE(read_checkpoint(path, entries, written_unix_msec));
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].instance_id, 7u);
+    EXPECT_EQ(entries[1].instance_id, 9u);
+    EXPECT_GT(written_unix_msec, 0u);
+
+    GameSession restored_first(0);
+    GameSession restored_second(0);
+
+    StateReader first_reader(entries[0].state);
+    StateReader second_reader(entries[1].state);
+
+    ASSERT_TRUE(restored_first.deserialize(first_reader));
+    ASSERT_TRUE(restored_second.deserialize(second_reader));
+
+    // Same RNG, timers and input state, so the same games from here on
+    step(first, bullet_updater, 300);
+    step(restored_first, bullet_updater, 300);
+    step(second, bullet_updater, 300);
+    step(restored_second, bullet_updater, 300);
+
+    expect_same_game(first, restored_first);
+    expect_same_game(second, restored_second);
+
+    std::remove(path.c_str());
+}
+
+TEST(CrashCheckpointTest, SessionIsCapturedBetweenTwoTicks) {
+    const auto path = temp_path("ticking");
+
+    GameSession session(33);
+    CrashCheckpointer checkpointer(path);
+    auto slot = checkpointer.add_session(1, session);
+
+    std::atomic<bool> running(true);
+    std::atomic<uint64_t> ticks(0);
+
+    // Steps like an instance thread, holding the slot only for the tick
+    std::thread instance([&]() {
+        BulletUpdater bullet_updater;
+
+        while (running)
+        {
+            {
+                std::lock_guard<std::mutex> lock(slot->mutex);
+                session.step(bullet_updater);
+            }
+
+            ticks++;
+        }
+    });
+
+    while (ticks < 100)
+    {
+        std::this_thread::yield();
+    }
+
+    const auto checkpointed = checkpointer.checkpoint();
+    const auto ticks_at_checkpoint = ticks.load();
+
+    // The instance goes on ticking after the checkpoint
+    while (ticks < ticks_at_checkpoint + 100)
+    {
+        std::this_thread::yield();
+    }
+
+    running = false;
+    instance.join();
+
+    ASSERT_TRUE(checkpointed);
+
+    std::vector<CheckpointEntry> entries;
+    uint64_t written_unix_msec = 0;
+
+    ASSERT_TRUE(read_checkpoint(path, entries, written_unix_msec));
+    ASSERT_EQ(entries.size(), 1u);
+
+    GameSession restored(0);
+    StateReader reader(entries[0].state);
+
+    ASSERT_TRUE(restored.deserialize(reader));
+    EXPECT_GE(restored.get_frame().timestamp, 100u);
+    EXPECT_LT(restored.get_frame().timestamp, session.get_frame().timestamp);
+
+    std::remove(path.c_str());
+}
+
+TEST(CrashCheckpointTest, RemovedSessionsAreNotWritten) {
+    const auto path = temp_path("removed");
+
+    GameSession kept(1);
+    GameSession ended(2);
+
+    CrashCheckpointer checkpointer(path);
+    checkpointer.add_session(1, kept);
+    auto ended_slot = checkpointer.add_session(2, ended);
+
+    ASSERT_TRUE(checkpointer.checkpoint());
+
+    checkpointer.remove_session(ended_slot);
+
+    ASSERT_TRUE(checkpointer.checkpoint());
+
+    std::vector<CheckpointEntry> entries;
+    uint64_t written_unix_msec = 0;
+
+    ASSERT_TRUE(read_checkpoint(path, entries, written_unix_msec));
+    ASSERT_EQ(entries.size(), 1u);
+    EXPECT_EQ(entries[0].instance_id, 1u);
+
+    const auto stats = checkpointer.get_stats();
+    EXPECT_EQ(stats.checkpoints, 2u);
+    EXPECT_EQ(stats.failures, 0u);
+    EXPECT_EQ(stats.last_sessions, 1u);
+    EXPECT_GT(stats.last_bytes, 0u);
+    EXPECT_GE(stats.max_pause_usec, stats.last_fork_usec);
+
+    std::remove(path.c_str());
+}
+
+TEST(CrashCheckpointTest, UnwritablePathCountsAsFailure) {
+    GameSession session(5);
+
+    // A directory that does not exist
+    CrashCheckpointer checkpointer(temp_path("missing") + "/checkpoint");
+    checkpointer.add_session(1, session);
+
+    EXPECT_FALSE(checkpointer.checkpoint());
+    EXPECT_EQ(checkpointer.get_stats().failures, 1u);
+    EXPECT_EQ(checkpointer.get_stats().checkpoints, 0u);
+}
+
+TEST(CrashCheckpointTest, RejectsDamagedCheckpoints) {
+    const auto path = temp_path("damaged");
+
+    GameSession session(8);
+    CrashCheckpointer checkpointer(path);
+    checkpointer.add_session(1, session);
+
+    ASSERT_TRUE(checkpointer.checkpoint());
+
+    std::vector<CheckpointEntry> entries;
+    uint64_t written_unix_msec = 0;
+
+    EXPECT_FALSE(read_checkpoint(temp_path("none"), entries, written_unix_msec));
+
+    // Cut off in the middle of the session
+    const auto size = checkpointer.get_stats().last_bytes;
+    ASSERT_EQ(truncate(path.c_str(), static_cast<off_t>(size / 2)), 0);
+
+    EXPECT_FALSE(read_checkpoint(path, entries, written_unix_msec));
+
+    std::remove(path.c_str());
+}
+
+/***** Crash recovery ***********************************************/
+TEST(CrashRecoveryTest, ClientResumesItsGameAfterARestart) {
+    const auto path = temp_path("resume");
+    ResumeToken token = {};
+    uint64_t checkpointed_timestamp = 0;
+
+    // The run that goes down, its last checkpoint stays behind
+    {
+        GameServerMaster master(0, 4);
+        master.enable_crash_checkpoints(path, 20);
+        master.run_local();
+
+        auto client = master.connect_local();
+        ASSERT_NE(client, nullptr);
+
+        const auto response_opt = start_game(*client, std::nullopt);
+        ASSERT_TRUE(response_opt.has_value());
+        ASSERT_TRUE(response_opt->resume_token.has_value());
+        token = *response_opt->resume_token;
+
+        while (checkpointed_timestamp < 30)
+        {
+            checkpointed_timestamp = wait_frame(*client);
+            ASSERT_GT(checkpointed_timestamp, 0u);
+        }
+
+        // A checkpoint started after that frame
+        const auto checkpoints = master.get_checkpoint_stats().checkpoints;
+
+        for (int attempt = 0; attempt < 1000 && master.get_checkpoint_stats().checkpoints < checkpoints + 2; attempt++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ASSERT_GE(master.get_checkpoint_stats().checkpoints, checkpoints + 2);
+
+        client->disconnect();
+        master.stop();
+        wait_for_instances_to_end(master);
+    }
+
+    GameServerMaster master(0, 4);
+    master.enable_crash_checkpoints(path, 20);
+    master.run_local();
+
+    ASSERT_EQ(master.get_recovered_sessions(), 1u);
+
+    // A wrong secret gets a new game
+    auto stranger = master.connect_local();
+    ASSERT_NE(stranger, nullptr);
+
+    auto forged = token;
+    forged.secret++;
+
+    const auto stranger_response_opt = start_game(*stranger, forged);
+    ASSERT_TRUE(stranger_response_opt.has_value());
+    ASSERT_TRUE(stranger_response_opt->resume_token.has_value());
+    EXPECT_NE(*stranger_response_opt->resume_token, token);
+    EXPECT_LT(wait_frame(*stranger), checkpointed_timestamp);
+    EXPECT_EQ(master.get_recovered_sessions(), 1u);
+
+    // The client of the game continues from the checkpoint
+    auto client = master.connect_local();
+    ASSERT_NE(client, nullptr);
+
+    const auto response_opt = start_game(*client, token);
+    ASSERT_TRUE(response_opt.has_value());
+    ASSERT_TRUE(response_opt->resume_token.has_value());
+    EXPECT_EQ(*response_opt->resume_token, token);
+    EXPECT_GT(wait_frame(*client), checkpointed_timestamp);
+    EXPECT_EQ(master.get_recovered_sessions(), 0u);
+
+    stranger->disconnect();
+    client->disconnect();
+    master.stop();
+    wait_for_instances_to_end(master);
+
+    std::remove(path.c_str());
+    std::remove((path + ".recovered").c_str());
+}
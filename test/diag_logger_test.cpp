@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <game_server/diag_logger.hpp>
+#include <game_server/game_server_constants.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    size_t count_of(const std::string& text, const std::string& part) {
+        size_t count = 0;
+
+        for (auto pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + part.size()))
+        {
+            count++;
+        }
+
+        return count;
+    }
+
+    // Captures what the logger writes during a test
+    class DiagLoggerTest : public ::testing::Test {
+    protected:
+        void SetUp() override {
+            DiagLogger::instance().flush();
+            DiagLogger::instance().set_output(m_out, m_err);
+        }
+
+        void TearDown() override {
+            DiagLogger::instance().flush();
+            DiagLogger::instance().set_output(std::cout, std::cerr);
+        }
+
+        std::ostringstream m_out;
+        std::ostringstream m_err;
+    };
+}
+
+/***** DiagLogger ***************************************************/
+TEST_F(DiagLoggerTest, LinesAreFormattedAndSplitByLevel) {
+    if (DIAG_LOG_LEVEL > 0)
+    {
+        GTEST_SKIP() << "Debug lines are compiled out";
+    }
+
+    const int value = 42;
+
+    DIAG_DEBUG("DiagFormat", "value " << value);
+    DIAG_INFO("DiagFormat", "ready");
+    DIAG_ERROR("DiagFormat", "failed");
+
+    DiagLogger::instance().flush();
+
+    EXPECT_NE(m_out.str().find("[DiagFormat] DEBUG: value 42\n"), std::string::npos);
+    EXPECT_NE(m_out.str().find("[DiagFormat] INFO: ready\n"), std::string::npos);
+    EXPECT_NE(m_err.str().find("[DiagFormat] ERROR: failed\n"), std::string::npos);
+    EXPECT_EQ(m_out.str().find("failed"), std::string::npos);
+}
+
+TEST_F(DiagLoggerTest, CallSiteIsRateLimited) {
+    constexpr uint32_t LINES = 25;
+    constexpr auto LIMIT = diag_log_constants::RATE_LIMIT_PER_WINDOW;
+
+    for (uint32_t i = 0; i < LINES; i++)
+    {
+        DIAG_ERROR("DiagRate", "overrun " << i);
+    }
+
+    DiagLogger::instance().flush();
+
+    EXPECT_EQ(count_of(m_err.str(), "[DiagRate] ERROR: overrun "), LIMIT);
+    EXPECT_NE(m_err.str().find("[DiagRate] ERROR: " + std::to_string(LINES - LIMIT) + " messages suppressed\n"), std::string::npos);
+
+    // Counted once
+    DiagLogger::instance().flush();
+
+    EXPECT_EQ(count_of(m_err.str(), "messages suppressed"), 1u);
+}
+
+TEST_F(DiagLoggerTest, LinesOfEveryThreadAreWritten) {
+    constexpr int THREADS = 4;
+
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([t]() {
+            DIAG_ERROR("DiagThreads", "from thread " << t);
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // The threads are gone, their lines are not
+    DiagLogger::instance().flush();
+
+    for (int t = 0; t < THREADS; t++)
+    {
+        EXPECT_EQ(count_of(m_err.str(), "[DiagThreads] ERROR: from thread " + std::to_string(t) + "\n"), 1u);
+    }
+}
+
+TEST_F(DiagLoggerTest, FullBufferDropsLinesInsteadOfWaiting) {
+    const std::string line(diag_log_constants::THREAD_BUFFER_BYTES / 2, 'x');
+    const auto dropped_before = DiagLogger::instance().get_dropped_count();
+
+    for (int i = 0; i < 5; i++)
+    {
+        DIAG_ERROR("DiagFull", line);
+    }
+
+    DiagLogger::instance().flush();
+
+    EXPECT_GT(DiagLogger::instance().get_dropped_count(), dropped_before);
+    EXPECT_GE(count_of(m_err.str(), "[DiagFull] ERROR: "), 1u);
+    EXPECT_NE(m_err.str().find("lines dropped"), std::string::npos);
+}
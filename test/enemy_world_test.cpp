@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <game_server/game_server_constants.hpp>
+#include <game_server/enemy_world.hpp>
+
+namespace {
+    FrameSnapshot make_frame() {
+        FrameSnapshot frame = {};
+
+        PlayerSnapshot player = {};
+        player.pos = { 0.0f, -120.0f };
+        player.radius = game_constants::PLAYER_RADIUS;
+        frame.player_vector.push_back(player);
+
+        return frame;
+    }
+
+    EntityDesc make_enemy(uint32_t enemy_id, Vec2 pos) {
+        EntityDesc desc = {};
+        desc.mask = component::TRANSFORM | component::BODY;
+        desc.transform = { pos, { 0.0f, 0.0f } };
+        desc.body = { enemy_id, EnemyName::Default, game_constants::ENEMY_RADIUS };
+
+        return desc;
+    }
+
+    // Same layout as the private EnemyWorld::Location
+    struct StateLocation {
+        uint32_t archetype;
+        uint32_t row;
+        uint32_t generation;
+    };
+
+    // One enemy archetype with two rows, in slots 0 and 1
+    struct EnemyState {
+        size_t                      body_count  = 2;
+        std::vector<StateLocation>  locations   = { { 0, 0, 0 }, { 0, 1, 0 } };
+        std::vector<uint32_t>       free_ids    = {};
+    };
+
+    std::vector<uint8_t> write_state(const EnemyState& state) {
+        StateWriter writer;
+        writer.write(uint32_t{1});
+        writer.write(component::TRANSFORM | component::BODY);
+        writer.write_vector(std::vector<EntityId>{ { 0, 0 }, { 1, 0 } });
+        writer.write_vector(std::vector<Transform>(2));
+        writer.write_vector(std::vector<EnemyBody>(state.body_count));
+        writer.write_vector(std::vector<BounceMotion>{});
+        writer.write_vector(std::vector<Emitter>{});
+        writer.write_vector(std::vector<Follow>{});
+        writer.write_vector(state.locations);
+        writer.write_vector(state.free_ids);
+
+        return writer.get_buffer();
+    }
+
+    bool read_state(const EnemyState& state) {
+        const auto buffer = write_state(state);
+        StateReader reader(buffer);
+        EnemyWorld world;
+
+        return world.deserialize(reader);
+    }
+}
+
+/***** EnemyWorld ***************************************************/
+TEST(EnemyWorldTest, GroupsEntitiesByArchetype) {
+    EnemyWorld world;
+
+    spawn_default_enemy(world, 0, { 0.0f, 120.0f });
+    spawn_default_enemy(world, 1, { 50.0f, 120.0f });
+
+    // Enemy archetype and emitter archetype
+    ASSERT_EQ(world.get_archetypes().size(), 2u);
+    EXPECT_EQ(world.size(), 10u);
+    EXPECT_EQ(world.get_archetypes()[0].size(), 2u);
+    EXPECT_EQ(world.get_archetypes()[1].size(), 8u);
+}
+
+TEST(EnemyWorldTest, DestroyKeepsColumnsPacked) {
+    EnemyWorld world;
+    FrameSnapshot frame = make_frame();
+
+    const auto a = world.spawn(make_enemy(10, { 1.0f, 1.0f }));
+    const auto b = world.spawn(make_enemy(11, { 2.0f, 2.0f }));
+    const auto c = world.spawn(make_enemy(12, { 3.0f, 3.0f }));
+
+    world.destroy(a);
+
+    EXPECT_FALSE(world.alive(a));
+    EXPECT_TRUE(world.alive(b));
+    EXPECT_TRUE(world.alive(c));
+
+    world.write_enemies(frame);
+    ASSERT_EQ(frame.enemy_vector.size(), 2u);
+
+    // The last row has been moved into the hole
+    EXPECT_EQ(frame.enemy_vector[0].id, 12u);
+    EXPECT_FLOAT_EQ(frame.enemy_vector[0].pos.x, 3.0f);
+    EXPECT_EQ(frame.enemy_vector[1].id, 11u);
+
+    // Slots are recycled, the old handle does not resolve to the new entity
+    const auto d = world.spawn(make_enemy(13, { 4.0f, 4.0f }));
+
+    EXPECT_EQ(d.index, a.index);
+    EXPECT_NE(d, a);
+    EXPECT_TRUE(world.alive(d));
+    EXPECT_FALSE(world.alive(a));
+
+    world.destroy(a);
+    EXPECT_TRUE(world.alive(d));
+}
+
+TEST(EnemyWorldTest, EmittersDieWithTheirParent) {
+    EnemyWorld world;
+
+    const auto enemy = spawn_default_enemy(world, 0, { 0.0f, 120.0f });
+    world.destroy(enemy);
+    world.update_follow();
+
+    EXPECT_EQ(world.size(), 0u);
+}
+
+TEST(EnemyWorldTest, FollowerOfADestroyedParentIgnoresItsSuccessor) {
+    EnemyWorld world;
+
+    const auto parent = world.spawn(make_enemy(1, { 1.0f, 1.0f }));
+
+    EntityDesc follower = {};
+    follower.mask = component::TRANSFORM | component::FOLLOW;
+    follower.transform = { { 0.0f, 0.0f }, { 0.0f, 0.0f } };
+    follower.follow = { parent };
+
+    const auto child = world.spawn(follower);
+
+    // The parent's slot goes to a new entity before the follow system runs
+    world.destroy(parent);
+    world.spawn(make_enemy(2, { 9.0f, 9.0f }));
+    world.update_follow();
+
+    EXPECT_FALSE(world.alive(child));
+    EXPECT_EQ(world.size(), 1u);
+}
+
+TEST(EnemyWorldTest, DefaultEnemyFiresItsPatterns) {
+    EnemyWorld world;
+    FrameSnapshot frame = make_frame();
+    std::mt19937 gen(0);
+    uint32_t bullet_id = 0;
+
+    spawn_default_enemy(world, 0, { 0.0f, 120.0f });
+
+    // Moving phase, nothing is fired
+    frame.timestamp = 60;
+    update_enemies(world, frame, gen, bullet_id);
+    EXPECT_TRUE(frame.bullet_vector.empty());
+
+    // Circle (8), homing (1), spiral (7 or 8) and random (7)
+    frame.timestamp = 360 + 240;
+    update_enemies(world, frame, gen, bullet_id);
+    EXPECT_GE(frame.bullet_vector.size(), 23u);
+    EXPECT_EQ(frame.bullet_count, frame.bullet_vector.size());
+    EXPECT_EQ(bullet_id, frame.bullet_vector.size());
+
+    ASSERT_EQ(frame.enemy_vector.size(), 1u);
+    EXPECT_EQ(frame.enemy_count, 1u);
+}
+
+TEST(EnemyWorldTest, BounceTurnsAroundAtTheEdges) {
+    EnemyWorld world;
+    FrameSnapshot frame = make_frame();
+
+    EntityDesc desc = make_enemy(0, { game_constants::GAME_WIDTH_HALF + 1.0f, 100.0f });
+    desc.mask |= component::BOUNCE;
+    desc.transform.vel = { 2.0f, 0.0f };
+    desc.bounce = { 2.0f, -game_constants::GAME_WIDTH_HALF, game_constants::GAME_WIDTH_HALF, 0.0f, 200.0f, 360, 120 };
+    world.spawn(desc);
+
+    world.update_motion(0);
+    world.write_enemies(frame);
+
+    EXPECT_FLOAT_EQ(frame.enemy_vector[0].vel.x, -2.0f);
+    EXPECT_FLOAT_EQ(frame.enemy_vector[0].pos.x, game_constants::GAME_WIDTH_HALF - 1.0f);
+}
+
+TEST(EnemyWorldTest, RoundTripsThroughItsState) {
+    EnemyWorld world;
+    const auto enemy = spawn_default_enemy(world, 0, { 0.0f, 120.0f });
+    world.destroy(world.spawn(make_enemy(1, { 1.0f, 1.0f })));
+
+    StateWriter writer;
+    world.serialize(writer);
+
+    EnemyWorld restored;
+    StateReader reader(writer.get_buffer());
+    ASSERT_TRUE(restored.deserialize(reader));
+
+    EXPECT_EQ(restored.size(), world.size());
+    EXPECT_TRUE(restored.alive(enemy));
+}
+
+TEST(EnemyWorldTest, RejectsAStateItsSystemsCannotRun) {
+    EXPECT_TRUE(read_state({}));
+
+    // A column shorter than the archetype
+    EnemyState short_column;
+    short_column.body_count = 1;
+    EXPECT_FALSE(read_state(short_column));
+
+    // A row past the end of the archetype
+    EnemyState row_out_of_range;
+    row_out_of_range.locations[1].row = 5;
+    EXPECT_FALSE(read_state(row_out_of_range));
+
+    // An archetype that does not exist
+    EnemyState unknown_archetype;
+    unknown_archetype.locations[1].archetype = 3;
+    EXPECT_FALSE(read_state(unknown_archetype));
+
+    // A free slot that is not there, or that is still taken
+    EnemyState free_out_of_range;
+    free_out_of_range.free_ids = { 7 };
+    EXPECT_FALSE(read_state(free_out_of_range));
+
+    EnemyState free_but_alive;
+    free_but_alive.free_ids = { 1 };
+    EXPECT_FALSE(read_state(free_but_alive));
+
+    // A slot that is neither taken nor free
+    EnemyState lost_slot;
+    lost_slot.locations.push_back({ UINT32_MAX, UINT32_MAX, 1 });
+    EXPECT_FALSE(read_state(lost_slot));
+}
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+#include <game_server/frame_json_writer.hpp>
+#include <game_server/game_session.hpp>
+
+/***** FrameJsonWriter **********************************************/
+TEST(FrameJsonWriterTest, MatchesFrameToJsonStr) {
+    BulletUpdater bullet_updater;
+    GameSession session(42);
+    FrameJsonWriter writer;
+
+    // Empty, then growing numbers of bullets
+    for (int tick = 0; tick < 600; tick++)
+    {
+        const auto& frame = session.get_frame();
+        ASSERT_EQ(writer.write(frame), frame_to_json_str(frame)) << "tick " << tick;
+
+        session.step(bullet_updater);
+    }
+}
+
+TEST(FrameJsonWriterTest, ReusesItsBuffer) {
+    BulletUpdater bullet_updater;
+    GameSession session(42);
+
+    for (int tick = 0; tick < 300; tick++)
+    {
+        session.step(bullet_updater);
+    }
+
+    // Starts small, grows once
+    FrameJsonWriter writer(16);
+    const auto first = writer.write(session.get_frame());
+    const auto second = writer.write(session.get_frame());
+
+    EXPECT_EQ(first.data(), second.data());
+    EXPECT_EQ(first, second);
+}
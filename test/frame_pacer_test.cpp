@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <game_server/frame_pacer.hpp>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include <string>
+
+namespace {
+    constexpr int64_t PERIOD_NSEC = 2 * 1000 * 1000;    // 2ms, 500 ticks a second
+
+    // Between the pacer's clock read and the test's, only a preemption of that length fails a check
+    constexpr int64_t CLOCK_SLACK_NSEC = 5 * PERIOD_NSEC;
+
+    void sleep_nsec(int64_t nsec) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nsec));
+    }
+}
+
+/***** FramePacer ***************************************************/
+TEST(FramePacerTest, SendIntervalsStayOnTheDeadlineGrid) {
+    constexpr int TICKS = 250;
+
+    FramePacer pacer(PERIOD_NSEC, 0, 0);
+    std::vector<int64_t> send_times;
+    uint64_t grid_ticks = 0;
+    int64_t max_off_grid_nsec = 0;
+
+    const auto start = FramePacer::now_nsec();
+    pacer.start();
+
+    for (int tick = 0; tick < TICKS; tick++)
+    {
+        // Some work of varying length, well within the tick
+        sleep_nsec((tick % 5) * 100 * 1000);
+
+        const auto pace = pacer.wait();
+        const auto now = FramePacer::now_nsec();
+        send_times.push_back(now);
+
+        // The deadline this wait was for is the next one on the grid, however late the ones before woke up
+        const auto deadline = now - pace.late_nsec - start;
+        const auto off_grid = deadline - static_cast<int64_t>(grid_ticks + 1) * PERIOD_NSEC;
+
+        EXPECT_GE(off_grid, 0) << "tick " << tick;
+        max_off_grid_nsec = std::max(max_off_grid_nsec, off_grid);
+
+        grid_ticks += pace.ticks + pace.dropped;
+    }
+
+    std::vector<int64_t> intervals;
+
+    for (size_t i = 1; i < send_times.size(); i++)
+    {
+        intervals.push_back(send_times[i] - send_times[i - 1]);
+    }
+
+    std::sort(intervals.begin(), intervals.end());
+
+    const auto p50 = intervals[intervals.size() / 2];
+    const auto p99 = intervals[intervals.size() * 99 / 100];
+
+    RecordProperty("interval_p50_usec", std::to_string(p50 / 1000));
+    RecordProperty("interval_p99_usec", std::to_string(p99 / 1000));
+
+    EXPECT_NEAR(static_cast<double>(p50), static_cast<double>(PERIOD_NSEC), PERIOD_NSEC * 0.5);
+
+    // Late wake ups do not add up, every deadline stays where the grid puts it
+    EXPECT_GE(grid_ticks, static_cast<uint64_t>(TICKS));
+    EXPECT_LT(max_off_grid_nsec, CLOCK_SLACK_NSEC);
+    EXPECT_GE(send_times.back() - start, TICKS * PERIOD_NSEC);
+}
+
+TEST(FramePacerTest, ReportsMissedDeadlinesAsTicksToCatchUp) {
+    FramePacer pacer(PERIOD_NSEC, 0, 100);
+    pacer.start();
+
+    // Three and a half ticks of work
+    sleep_nsec(PERIOD_NSEC * 7 / 2);
+
+    const auto late = pacer.wait();
+    EXPECT_GE(late.ticks, 3u);
+    EXPECT_EQ(late.ticks, 1 + late.late_nsec / PERIOD_NSEC);
+    EXPECT_EQ(late.dropped, 0u);
+
+    // Back on time
+    const auto on_time = pacer.wait();
+    EXPECT_EQ(on_time.ticks, 1u);
+    EXPECT_LT(on_time.late_nsec, PERIOD_NSEC);
+}
+
+TEST(FramePacerTest, DropsTicksBeyondTheCatchUpLimit) {
+    const auto max_ticks = get_max_catch_up_ticks(OverrunPolicy::CatchUp);
+    FramePacer pacer(PERIOD_NSEC, 0, max_ticks);
+
+    const auto start = FramePacer::now_nsec();
+    pacer.start();
+
+    sleep_nsec(PERIOD_NSEC * (max_ticks + 4));
+
+    const auto late = pacer.wait();
+    EXPECT_EQ(late.ticks, 1 + max_ticks);
+    EXPECT_GT(late.dropped, 0u);
+    EXPECT_EQ(late.ticks - 1 + late.dropped, late.late_nsec / PERIOD_NSEC);
+
+    // The grid is kept, dropped ticks included: the next deadline is the one after the missed ones
+    const auto on_time = pacer.wait();
+    const auto deadline = FramePacer::now_nsec() - on_time.late_nsec - start;
+    const auto expected = static_cast<int64_t>(1 + late.ticks + late.dropped) * PERIOD_NSEC;
+
+    EXPECT_GE(deadline, expected);
+    EXPECT_LT(deadline, expected + CLOCK_SLACK_NSEC);
+}
+
+TEST(FramePacerTest, SkipSimulatesEveryMissedTick) {
+    FramePacer pacer(PERIOD_NSEC, 0, get_max_catch_up_ticks(OverrunPolicy::Skip));
+    pacer.start();
+
+    // A stall far beyond the catch up limit
+    sleep_nsec(PERIOD_NSEC * (pacing_constants::MAX_CATCH_UP_TICKS + 20));
+
+    const auto late = pacer.wait();
+    EXPECT_GT(late.ticks, 1 + pacing_constants::MAX_CATCH_UP_TICKS);
+    EXPECT_EQ(late.ticks, 1 + late.late_nsec / PERIOD_NSEC);
+    EXPECT_EQ(late.dropped, 0u);
+}
+
+TEST(FramePacerTest, SpinWakesUpOnTheDeadline) {
+    FramePacer pacer(PERIOD_NSEC, PERIOD_NSEC / 4, 0);
+    std::vector<int64_t> lateness;
+
+    pacer.start();
+
+    for (int tick = 0; tick < 100; tick++)
+    {
+        lateness.push_back(pacer.wait().late_nsec);
+    }
+
+    std::sort(lateness.begin(), lateness.end());
+
+    RecordProperty("lateness_p50_usec", std::to_string(lateness[50] / 1000));
+
+    EXPECT_GE(lateness.front(), 0);
+    EXPECT_LT(lateness[50], PERIOD_NSEC / 4);
+}
@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+#include <game_server/frame_sender.hpp>
+#include <game_server/game_server_constants.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+    // A client whose socket takes nothing until it is released
+    class BlockingTransport : public Transport {
+    public:
+        void start() override {}
+        void stop() override {}
+
+        std::optional<ReceivedPacket> poll_packet() override { return std::nullopt; }
+
+        bool send_packet(Packet packet) override {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_in_send = true;
+            m_cv.notify_all();
+
+            m_cv.wait(lock, [this] { return m_released || m_disconnected; });
+
+            m_in_send = false;
+
+            if (m_disconnected)
+            {
+                return false;
+            }
+
+            m_sent.push_back(std::move(packet));
+
+            return true;
+        }
+
+        bool send_game_response(Packet packet, const ResumeToken&) override {
+            return send_packet(std::move(packet));
+        }
+
+        bool send_frame(Packet packet, const FrameAck& ack) override {
+            if (!send_packet(std::move(packet)))
+            {
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_acks.push_back(ack);
+
+            return true;
+        }
+
+        std::exception_ptr get_recv_exception() const override { return nullptr; }
+        bool is_running() const override { return true; }
+
+        void disconnect() override {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_disconnected = true;
+            m_cv.notify_all();
+        }
+
+        void release() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_released = true;
+            m_cv.notify_all();
+        }
+
+        // Until the send thread is stuck in send_packet()
+        bool wait_in_send() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            return m_cv.wait_for(lock, std::chrono::seconds(2), [this] { return m_in_send; });
+        }
+
+        bool is_disconnected() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_disconnected;
+        }
+
+        std::vector<Packet> get_sent() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_sent;
+        }
+
+        // One per frame sent
+        std::vector<FrameAck> get_acks() {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            return m_acks;
+        }
+
+    private:
+        std::mutex              m_mutex;
+        std::condition_variable m_cv;
+        bool                    m_in_send = false;
+        bool                    m_released = false;
+        bool                    m_disconnected = false;
+        std::vector<Packet>     m_sent;
+        std::vector<FrameAck>   m_acks;
+    };
+
+    // Acknowledges an input of the same number
+    FrameAck make_ack(uint64_t timestamp) {
+        return { static_cast<uint32_t>(timestamp) };
+    }
+
+    Packet make_frame(uint64_t timestamp) {
+        FrameSnapshot frame = {};
+        frame.timestamp = timestamp;
+
+        return make_packet<FrameSnapshot>(frame);
+    }
+
+    uint64_t timestamp_of(const Packet& packet) {
+        return std::get<FrameSnapshot>(packet.payload).timestamp;
+    }
+
+    bool wait_until(const std::function<bool()>& condition) {
+        for (int attempt = 0; attempt < 2000; attempt++)
+        {
+            if (condition())
+            {
+                return true;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return false;
+    }
+
+    // One tick of the game loop, a frame whenever one is due
+    void tick(FrameSender& sender, uint64_t timestamp) {
+        if (sender.is_frame_due(timestamp))
+        {
+            sender.send_frame(make_frame(timestamp), make_ack(timestamp));
+        }
+    }
+}
+
+/***** FrameSender **************************************************/
+TEST(FrameSenderTest, CoalescesFramesWhileTheClientIsBlocked) {
+    BlockingTransport transport;
+    auto stats = std::make_shared<InstanceStats>();
+    FrameSender sender(transport, stats);
+    sender.start();
+
+    sender.send_frame(make_frame(1), make_ack(1));
+    ASSERT_TRUE(transport.wait_in_send());
+
+    // Each one replaces the pending frame
+    sender.send_frame(make_frame(2), make_ack(2));
+    sender.send_frame(make_frame(3), make_ack(3));
+    sender.send_frame(make_frame(4), make_ack(4));
+
+    EXPECT_EQ(stats->frames_coalesced, 2u);
+    EXPECT_EQ(stats->send_queue_depth, 2u);
+
+    transport.release();
+    sender.stop();
+
+    const auto sent = transport.get_sent();
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_EQ(timestamp_of(sent[0]), 1u);
+    EXPECT_EQ(timestamp_of(sent[1]), 4u);
+
+    // The ack went with its frame
+    const auto acks = transport.get_acks();
+    ASSERT_EQ(acks.size(), 2u);
+    EXPECT_EQ(acks[0].last_input_sequence, 1u);
+    EXPECT_EQ(acks[1].last_input_sequence, 4u);
+
+    EXPECT_EQ(stats->frames_sent, 2u);
+    EXPECT_EQ(stats->send_queue_depth, 0u);
+    EXPECT_EQ(stats->max_send_queue_depth, 2u);
+    EXPECT_FALSE(sender.is_connection_lost());
+}
+
+TEST(FrameSenderTest, ControlPacketsAreQueuedInOrderAheadOfTheFrame) {
+    BlockingTransport transport;
+    auto stats = std::make_shared<InstanceStats>();
+    FrameSender sender(transport, stats);
+    sender.start();
+
+    sender.send_frame(make_frame(1), make_ack(1));
+    ASSERT_TRUE(transport.wait_in_send());
+
+    sender.send_frame(make_frame(2), make_ack(2));
+    sender.send_control(make_packet<ServerGoodbye>({}));
+    sender.send_control(make_packet<ServerGoodbye>({}));
+
+    // In flight, the pending frame and both control packets
+    EXPECT_EQ(stats->max_send_queue_depth, 4u);
+
+    transport.release();
+    sender.stop();
+
+    const auto sent = transport.get_sent();
+    ASSERT_EQ(sent.size(), 4u);
+    EXPECT_EQ(timestamp_of(sent[0]), 1u);
+    EXPECT_EQ(sent[1].header.payload_type, PayloadType::ServerGoodbye);
+    EXPECT_EQ(sent[2].header.payload_type, PayloadType::ServerGoodbye);
+    EXPECT_EQ(timestamp_of(sent[3]), 2u);
+    EXPECT_EQ(stats->frames_coalesced, 0u);
+}
+
+TEST(FrameSenderTest, RateStepsDownAndRecovers) {
+    BlockingTransport transport;
+    auto stats = std::make_shared<InstanceStats>();
+    FrameSender sender(transport, stats);
+    sender.start();
+
+    const auto full_rate = game_constants::TARGET_FPS;
+    const auto lowest_rate = full_rate / send_constants::SNAPSHOT_RATE_DIVISORS[send_constants::SNAPSHOT_RATE_LEVELS - 1];
+
+    EXPECT_EQ(sender.get_snapshot_rate_hz(), full_rate);
+
+    // A client that takes nothing, one level down per window
+    uint64_t timestamp = 0;
+
+    for (size_t window = 0; window < send_constants::SNAPSHOT_RATE_LEVELS; window++)
+    {
+        for (uint32_t i = 0; i < send_constants::RATE_WINDOW_TICKS; i++)
+        {
+            tick(sender, timestamp++);
+        }
+    }
+
+    EXPECT_EQ(sender.get_snapshot_rate_hz(), lowest_rate);
+    EXPECT_EQ(stats->snapshot_rate_hz, lowest_rate);
+    EXPECT_EQ(stats->rate_changes, send_constants::SNAPSHOT_RATE_LEVELS - 1);
+
+    // Keeping up again: every frame is gone before the next one
+    transport.release();
+    ASSERT_TRUE(wait_until([&] { return stats->send_queue_depth == 0; }));
+
+    const auto max_ticks = send_constants::RATE_WINDOW_TICKS * send_constants::RATE_RECOVERY_WINDOWS
+                         * (send_constants::SNAPSHOT_RATE_LEVELS + 1);
+
+    for (uint32_t i = 0; i < max_ticks && sender.get_snapshot_rate_hz() != full_rate; i++)
+    {
+        tick(sender, timestamp++);
+
+        ASSERT_TRUE(wait_until([&] { return stats->send_queue_depth == 0; }));
+    }
+
+    EXPECT_EQ(sender.get_snapshot_rate_hz(), full_rate);
+    EXPECT_EQ(stats->rate_changes, 2 * (send_constants::SNAPSHOT_RATE_LEVELS - 1));
+
+    sender.stop();
+}
+
+TEST(FrameSenderTest, StopCutsAClientThatNeverDrains) {
+    BlockingTransport transport;
+    auto stats = std::make_shared<InstanceStats>();
+    FrameSender sender(transport, stats);
+    sender.start();
+
+    sender.send_frame(make_frame(1), make_ack(1));
+    ASSERT_TRUE(transport.wait_in_send());
+
+    sender.send_control(make_packet<ServerGoodbye>({}));
+
+    const auto start = std::chrono::steady_clock::now();
+    sender.stop();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_GE(elapsed, std::chrono::milliseconds(send_constants::STOP_TIMEOUT_MSEC));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(send_constants::STOP_TIMEOUT_MSEC * 4));
+
+    EXPECT_TRUE(sender.is_connection_lost());
+    EXPECT_TRUE(transport.is_disconnected());
+
+    // Dropped, not sent to a dead connection
+    EXPECT_TRUE(transport.get_sent().empty());
+    EXPECT_EQ(stats->frames_sent, 0u);
+    EXPECT_EQ(stats->send_queue_depth, 0u);
+}
@@ -57,3 +57,47 @@ TEST(GameLoggerTest, WritesLogToCacheAndData) {
     fs::remove_all(tmp_cache);
     fs::remove_all(tmp_data);
 }
+
+TEST(GameLoggerTest, WritesHeaderFirst) {
+    fs::path tmp_cache = fs::temp_directory_path() / "log_cache_header";
+    fs::path tmp_data  = fs::temp_directory_path() / "log_data_header";
+
+    fs::create_directories(tmp_cache);
+    fs::create_directories(tmp_data);
+
+    {
+        GameLogger logger(tmp_cache.string(), tmp_data.string());
+
+        logger.async_log("test message 1");
+
+        // Known only at the end of the game
+        logger.set_header("test header");
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    fs::path logfile;
+
+    for (auto& entry : fs::directory_iterator(tmp_data))
+    {
+        if (entry.is_regular_file())
+        {
+            logfile = entry.path();
+            break;
+        }
+    }
+
+    ASSERT_FALSE(logfile.empty());
+
+    std::ifstream ifs(logfile);
+    std::string line;
+
+    std::getline(ifs, line);
+    EXPECT_EQ(line, "test header");
+
+    std::getline(ifs, line);
+    EXPECT_EQ(line, "test message 1");
+
+    fs::remove_all(tmp_cache);
+    fs::remove_all(tmp_data);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include <game_server/game_server_supervisor.hpp>
+
+#include <algorithm>
+#include <thread>
+
+/***** parse_cpu_list ***********************************************/
+TEST(ParseCpuListTest, ExpandsRangesAndSingleCpus) {
+    EXPECT_EQ(GameServerSupervisor::parse_cpu_list("0-3,8-11"), (std::vector<int>{ 0, 1, 2, 3, 8, 9, 10, 11 }));
+    EXPECT_EQ(GameServerSupervisor::parse_cpu_list("5"), (std::vector<int>{ 5 }));
+    EXPECT_EQ(GameServerSupervisor::parse_cpu_list("0,2-3,7"), (std::vector<int>{ 0, 2, 3, 7 }));
+}
+
+TEST(ParseCpuListTest, SkipsEmptyAndInvalidRanges) {
+    EXPECT_TRUE(GameServerSupervisor::parse_cpu_list("").empty());
+    EXPECT_EQ(GameServerSupervisor::parse_cpu_list("0-1,,3"), (std::vector<int>{ 0, 1, 3 }));
+    EXPECT_EQ(GameServerSupervisor::parse_cpu_list("x-2,4"), (std::vector<int>{ 4 }));
+
+    // A reversed range has no CPU
+    EXPECT_TRUE(GameServerSupervisor::parse_cpu_list("3-1").empty());
+}
+
+/***** get_worker_cpu_capacity **************************************/
+TEST(WorkerCpuCapacityTest, SharesTheMachineWithoutPinning) {
+    const auto hardware_threads = static_cast<double>(std::max(1u, std::thread::hardware_concurrency()));
+
+    GameServerSupervisor supervisor(4, false);
+
+    EXPECT_DOUBLE_EQ(supervisor.get_worker_cpu_capacity(0), hardware_threads / 4);
+    EXPECT_DOUBLE_EQ(supervisor.get_worker_cpu_capacity(3), hardware_threads / 4);
+}
+
+TEST(WorkerCpuCapacityTest, SharesTheNodeAmongItsWorkers) {
+    // Workers 0 and 2 on node 0, worker 1 alone on node 1
+    GameServerSupervisor supervisor(3, std::vector<std::vector<int>>{ { 0, 1, 2, 3 }, { 4, 5, 6, 7 } });
+
+    EXPECT_DOUBLE_EQ(supervisor.get_worker_cpu_capacity(0), 2.0);
+    EXPECT_DOUBLE_EQ(supervisor.get_worker_cpu_capacity(1), 4.0);
+    EXPECT_DOUBLE_EQ(supervisor.get_worker_cpu_capacity(2), 2.0);
+}
+
+TEST(WorkerCpuCapacityTest, MoreWorkersThanCpusGetAFraction) {
+    GameServerSupervisor supervisor(4, std::vector<std::vector<int>>{ { 0, 1 } });
+
+    EXPECT_DOUBLE_EQ(supervisor.get_worker_cpu_capacity(0), 0.5);
+}
@@ -147,3 +147,57 @@ TEST(DetectCollisionTest, CollidesCorrectly) {
 
     EXPECT_FALSE(detect_collision(player, bullet2));
 }
+
+/***** detect_swept_collision ***************************************/
+TEST(DetectSweptCollisionTest, FindsTheEarliestContact) {
+    PlayerSnapshot player = {};
+    player.radius = 5.0f;
+
+    // Straight through the player in one tick, 40 to the left to 40 to the right
+    BulletSnapshot bullet = {};
+    bullet.pos = { 40.0f, 0.0f };
+    bullet.radius = 5.0f;
+
+    float contact_time = -1.0f;
+
+    EXPECT_FALSE(detect_collision(player, bullet));
+    ASSERT_TRUE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { -40.0f, 0.0f }, contact_time));
+    EXPECT_FLOAT_EQ(contact_time, 30.0f / 80.0f);
+
+    // Passes by with a gap of 1
+    bullet.pos = { 40.0f, 11.0f };
+    EXPECT_FALSE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { -40.0f, 11.0f }, contact_time));
+
+    // The player moves into its way
+    player.pos = { 0.0f, 4.0f };
+    ASSERT_TRUE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { -40.0f, 11.0f }, contact_time));
+    EXPECT_GT(contact_time, 0.0f);
+    EXPECT_LT(contact_time, 1.0f);
+
+    // Overlapping from the start
+    ASSERT_TRUE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { 3.0f, 0.0f }, contact_time));
+    EXPECT_FLOAT_EQ(contact_time, 0.0f);
+}
+
+TEST(DetectSweptCollisionTest, MissesWhatItDoesNotReach) {
+    PlayerSnapshot player = {};
+    player.radius = 5.0f;
+
+    BulletSnapshot bullet = {};
+    bullet.radius = 5.0f;
+    float contact_time = -1.0f;
+
+    // Stops short of the player
+    bullet.pos = { -20.0f, 0.0f };
+    EXPECT_FALSE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { -40.0f, 0.0f }, contact_time));
+
+    // Moving away
+    bullet.pos = { 40.0f, 0.0f };
+    EXPECT_FALSE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { 20.0f, 0.0f }, contact_time));
+
+    // Moving together
+    player.pos = { 10.0f, 0.0f };
+    bullet.pos = { 30.0f, 0.0f };
+    EXPECT_FALSE(detect_swept_collision(player, { 0.0f, 0.0f }, bullet, { 20.0f, 0.0f }, contact_time));
+    EXPECT_FLOAT_EQ(contact_time, -1.0f);
+}
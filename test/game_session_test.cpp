@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <game_server/game_session.hpp>
+
+#include <cstring>
+#include <cmath>
+
+namespace {
+    void expect_same_frame(const FrameSnapshot& a, const FrameSnapshot& b) {
+        EXPECT_EQ(a.timestamp, b.timestamp);
+        EXPECT_EQ(a.state, b.state);
+        ASSERT_EQ(a.bullet_vector.size(), b.bullet_vector.size());
+        ASSERT_EQ(a.enemy_vector.size(), b.enemy_vector.size());
+
+        EXPECT_EQ(std::memcmp(&a.player_vector[0].pos, &b.player_vector[0].pos, sizeof(a.player_vector[0].pos)), 0);
+
+        for (size_t i = 0; i < a.bullet_vector.size(); i++)
+        {
+            EXPECT_EQ(a.bullet_vector[i].id, b.bullet_vector[i].id);
+            EXPECT_EQ(std::memcmp(&a.bullet_vector[i].pos, &b.bullet_vector[i].pos, sizeof(a.bullet_vector[i].pos)), 0);
+            EXPECT_EQ(std::memcmp(&a.bullet_vector[i].vel, &b.bullet_vector[i].vel, sizeof(a.bullet_vector[i].vel)), 0);
+        }
+
+        for (size_t i = 0; i < a.enemy_vector.size(); i++)
+        {
+            EXPECT_EQ(std::memcmp(&a.enemy_vector[i].pos, &b.enemy_vector[i].pos, sizeof(a.enemy_vector[i].pos)), 0);
+        }
+    }
+
+    ClientInput make_input(uint8_t pressed, uint8_t released) {
+        ClientInput input = {};
+        input.game_input.arrows.pressed = pressed;
+        input.game_input.arrows.released = released;
+
+        return input;
+    }
+
+    InputStamp make_stamp(uint32_t sequence, uint32_t tick_offset, uint16_t client_tick = 0) {
+        InputStamp stamp = {};
+        stamp.sequence = sequence;
+        stamp.tick_offset = static_cast<uint16_t>(tick_offset);
+        stamp.client_tick = client_tick;
+
+        return stamp;
+    }
+
+    float distance_moved(const GameSession& session, const Vec2& start) {
+        const auto& pos = session.get_frame().player_vector[0].pos;
+
+        return std::hypot(pos.x - start.x, pos.y - start.y);
+    }
+}
+
+/***** GameSession **************************************************/
+TEST(GameSessionTest, RestoredSessionContinuesIdentically) {
+    BulletUpdater bullet_updater;
+    GameSession original(1234);
+
+    // Past the first random shots
+    for (int tick = 0; tick < 500; tick++)
+    {
+        original.step(bullet_updater);
+    }
+
+    StateWriter writer;
+    original.serialize(writer);
+
+    GameSession restored(0);
+    StateReader reader(writer.get_buffer());
+    ASSERT_TRUE(restored.deserialize(reader));
+
+    expect_same_frame(original.get_frame(), restored.get_frame());
+
+    // Same RNG state, same pattern timers, same bullet ids
+    for (int tick = 0; tick < 500; tick++)
+    {
+        original.step(bullet_updater);
+        restored.step(bullet_updater);
+    }
+
+    expect_same_frame(original.get_frame(), restored.get_frame());
+}
+
+TEST(GameSessionTest, RejectsTruncatedState) {
+    GameSession session(1);
+
+    StateWriter writer;
+    session.serialize(writer);
+
+    auto buffer = writer.get_buffer();
+    buffer.resize(buffer.size() / 2);
+
+    GameSession restored(0);
+    StateReader reader(buffer);
+    EXPECT_FALSE(restored.deserialize(reader));
+}
+
+TEST(GameSessionTest, RejectsForeignState) {
+    std::vector<uint8_t> buffer(256, 0xAB);
+
+    GameSession restored(0);
+    StateReader reader(buffer);
+    EXPECT_FALSE(restored.deserialize(reader));
+}
+
+/***** Input sequencing *********************************************/
+TEST(GameSessionTest, SubTickPressMovesForTheHeldFraction) {
+    BulletUpdater bullet_updater;
+    GameSession held(1);
+    GameSession tapped(1);
+    const auto start = held.get_frame().player_vector[0].pos;
+
+    // Held for the whole tick, and pressed then released half way through
+    held.apply_input(make_input(0x1, 0), make_stamp(1, 0));
+
+    tapped.apply_input(make_input(0x1, 0), make_stamp(1, 0));
+    tapped.apply_input(make_input(0, 0x1), make_stamp(2, input_constants::TICK_OFFSET_ONE / 2));
+
+    held.step(bullet_updater);
+    tapped.step(bullet_updater);
+
+    ASSERT_GT(distance_moved(held, start), 0.0f);
+    EXPECT_NEAR(distance_moved(tapped, start), distance_moved(held, start) / 2, 1e-4f);
+    EXPECT_EQ(tapped.get_last_input_sequence(), 2u);
+}
+
+TEST(GameSessionTest, AppliesInputsInSequenceOrder) {
+    BulletUpdater bullet_updater;
+    GameSession in_order(1);
+    GameSession reordered(1);
+
+    in_order.apply_input(make_input(0x1, 0), make_stamp(1, 0));
+    in_order.apply_input(make_input(0, 0x1), make_stamp(2, 0));
+
+    // The release arrives first, the press must not stick
+    reordered.apply_input(make_input(0, 0x1), make_stamp(2, 0));
+    reordered.apply_input(make_input(0x1, 0), make_stamp(1, 0));
+
+    in_order.step(bullet_updater);
+    reordered.step(bullet_updater);
+
+    expect_same_frame(in_order.get_frame(), reordered.get_frame());
+    EXPECT_EQ(reordered.get_last_input_sequence(), 2u);
+
+    // Stale and duplicate inputs are ignored
+    reordered.apply_input(make_input(0x1, 0), make_stamp(1, 0));
+    reordered.step(bullet_updater);
+    in_order.step(bullet_updater);
+
+    expect_same_frame(in_order.get_frame(), reordered.get_frame());
+}
+
+TEST(GameSessionTest, AppliesOneClientTickPerStep) {
+    BulletUpdater bullet_updater;
+    GameSession held(1);
+    GameSession batched(1);
+    const auto start = held.get_frame().player_vector[0].pos;
+
+    held.apply_input(make_input(0x1, 0), make_stamp(1, 0));
+    held.step(bullet_updater);
+
+    const auto full_tick = distance_moved(held, start);
+    ASSERT_GT(full_tick, 0.0f);
+
+    // Held for half of client tick 10 and a quarter of client tick 11, both arriving before one step
+    batched.apply_input(make_input(0x1, 0), make_stamp(1, 0, 10));
+    batched.apply_input(make_input(0, 0x1), make_stamp(2, input_constants::TICK_OFFSET_ONE / 2, 10));
+    batched.apply_input(make_input(0x1, 0), make_stamp(3, 0, 11));
+    batched.apply_input(make_input(0, 0x1), make_stamp(4, input_constants::TICK_OFFSET_ONE / 4, 11));
+
+    batched.step(bullet_updater);
+    EXPECT_NEAR(distance_moved(batched, start), full_tick / 2, 1e-4f);
+    EXPECT_EQ(batched.get_last_input_sequence(), 2u);
+
+    // The second tick's inputs waited for this step
+    batched.step(bullet_updater);
+    EXPECT_NEAR(distance_moved(batched, start), full_tick * 3 / 4, 1e-4f);
+    EXPECT_EQ(batched.get_last_input_sequence(), 4u);
+
+    batched.step(bullet_updater);
+    EXPECT_NEAR(distance_moved(batched, start), full_tick * 3 / 4, 1e-4f);
+}
+
+TEST(GameSessionTest, DoesNotHoldInputsBackIndefinitely) {
+    BulletUpdater bullet_updater;
+    GameSession session(1);
+
+    const auto queued = static_cast<uint32_t>(input_constants::MAX_QUEUED_TICKS) + 3;
+
+    for (uint32_t sequence = 1; sequence <= queued; sequence++)
+    {
+        session.apply_input(make_input(0, 0), make_stamp(sequence, 0, static_cast<uint16_t>(sequence)));
+    }
+
+    // The ticks beyond the limit go at once, one tick per step after that
+    session.step(bullet_updater);
+    EXPECT_EQ(session.get_last_input_sequence(), queued - input_constants::MAX_QUEUED_TICKS + 1);
+
+    session.step(bullet_updater);
+    EXPECT_EQ(session.get_last_input_sequence(), queued - input_constants::MAX_QUEUED_TICKS + 2);
+}
+
+TEST(GameSessionTest, NumbersUnsequencedInputs) {
+    BulletUpdater bullet_updater;
+    GameSession session(1);
+
+    session.apply_input(make_input(0x1, 0));
+    session.apply_input(make_input(0, 0x1));
+    session.step(bullet_updater);
+
+    EXPECT_EQ(session.get_last_input_sequence(), 2u);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <game_server/latency_estimator.hpp>
+
+namespace {
+    // Client clock runs `offset` ahead, both directions take `one_way`, the client holds the frame `hold`
+    PongStamp make_pong(uint64_t tick, int64_t send_usec, int64_t one_way, int64_t offset, int64_t hold) {
+        PongStamp pong = {};
+        pong.frame_tick = tick;
+        pong.client_recv_usec = send_usec + one_way + offset;
+        pong.client_send_usec = pong.client_recv_usec + hold;
+
+        return pong;
+    }
+}
+
+/***** LatencyEstimator *********************************************/
+TEST(LatencyEstimatorTest, EstimatesRoundTripAndOffset) {
+    LatencyEstimator estimator;
+
+    const int64_t one_way = 20000;
+    const int64_t offset = 5000000;
+    const int64_t hold = 3000;
+
+    for (uint64_t tick = 0; tick < 300; tick += latency_constants::PING_INTERVAL_TICKS)
+    {
+        const int64_t send_usec = 1000000 + static_cast<int64_t>(tick) * 16667;
+        estimator.record_ping(tick, send_usec);
+
+        const auto pong = make_pong(tick, send_usec, one_way, offset, hold);
+        const auto recv_usec = pong.client_send_usec - offset + one_way;
+
+        EXPECT_TRUE(estimator.on_pong(pong, recv_usec));
+    }
+
+    const auto estimate = estimator.get_estimate();
+
+    EXPECT_EQ(estimate.rtt_usec, 2 * one_way);
+    EXPECT_EQ(estimate.clock_offset_usec, offset);
+    EXPECT_EQ(estimate.samples, 10u);
+}
+
+TEST(LatencyEstimatorTest, JitterFollowsVaryingRoundTrips) {
+    LatencyEstimator steady;
+    LatencyEstimator varying;
+
+    for (uint64_t i = 0; i < 20; i++)
+    {
+        const auto tick = i * latency_constants::PING_INTERVAL_TICKS;
+        const int64_t send_usec = static_cast<int64_t>(tick) * 16667;
+        const int64_t one_way = (i % 2 == 0) ? 10000 : 30000;
+
+        steady.record_ping(tick, send_usec);
+        varying.record_ping(tick, send_usec);
+
+        const auto steady_pong = make_pong(tick, send_usec, 20000, 0, 0);
+        steady.on_pong(steady_pong, steady_pong.client_send_usec + 20000);
+
+        const auto varying_pong = make_pong(tick, send_usec, one_way, 0, 0);
+        varying.on_pong(varying_pong, varying_pong.client_send_usec + one_way);
+    }
+
+    EXPECT_LT(steady.get_estimate().jitter_usec, 1000);
+    EXPECT_GT(varying.get_estimate().jitter_usec, 10000);
+}
+
+TEST(LatencyEstimatorTest, IgnoresUnknownAndTooFrequentEchoes) {
+    LatencyEstimator estimator;
+
+    estimator.record_ping(10, 0);
+    estimator.record_ping(11, 16667);
+
+    // Never sent
+    EXPECT_FALSE(estimator.on_pong(make_pong(12, 0, 1000, 0, 0), 2000));
+
+    EXPECT_TRUE(estimator.on_pong(make_pong(10, 0, 1000, 0, 0), 2000));
+
+    // Within the ping interval of the previous sample
+    EXPECT_FALSE(estimator.on_pong(make_pong(11, 16667, 1000, 0, 0), 18667));
+    EXPECT_EQ(estimator.get_estimate().samples, 1u);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <game_server/spsc_queue.hpp>
+#include <game_server/local_transport.hpp>
+#include <game_server/frame_sender.hpp>
+#include <game_server/game_server.hpp>
+
+#include <string>
+#include <thread>
+#include <chrono>
+
+namespace {
+    Packet make_frame(uint64_t timestamp, size_t bullet_count) {
+        FrameSnapshot frame = {};
+        frame.timestamp = timestamp;
+        frame.bullet_vector.resize(bullet_count);
+        frame.bullet_count = static_cast<uint32_t>(bullet_count);
+
+        return make_packet<FrameSnapshot>(frame);
+    }
+
+    // Polls until a packet of the type arrives
+    std::optional<DeliveredPacket> wait_packet(LocalClient& client, PayloadType payload_type) {
+        for (int attempt = 0; attempt < 2000; attempt++)
+        {
+            while (auto packet_opt = client.poll_packet())
+            {
+                if (packet_opt->packet.header.payload_type == payload_type)
+                {
+                    return packet_opt;
+                }
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return std::nullopt;
+    }
+}
+
+/***** SpscQueue ****************************************************/
+TEST(SpscQueueTest, KeepsOrderAcrossThreads) {
+    constexpr uint64_t COUNT = 200000;
+
+    SpscQueue<uint64_t> queue(64);
+
+    std::thread producer([&] {
+        for (uint64_t i = 0; i < COUNT; i++)
+        {
+            while (!queue.try_push(uint64_t(i)))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    uint64_t value = 0;
+
+    while (expected < COUNT)
+    {
+        if (queue.try_pop(value))
+        {
+            ASSERT_EQ(value, expected);
+            expected++;
+        }
+    }
+
+    producer.join();
+
+    EXPECT_FALSE(queue.try_pop(value));
+}
+
+TEST(SpscQueueTest, FullQueueLeavesTheValueAlone) {
+    SpscQueue<std::string> queue(3);
+    ASSERT_EQ(queue.capacity(), 4u);
+
+    for (int i = 0; i < 4; i++)
+    {
+        EXPECT_TRUE(queue.try_push(std::string(64, 'a' + i)));
+    }
+
+    std::string rejected(64, 'z');
+    EXPECT_FALSE(queue.try_push(rejected));
+    EXPECT_EQ(rejected, std::string(64, 'z'));
+
+    std::string oldest;
+    EXPECT_TRUE(queue.try_pop(oldest));
+    EXPECT_EQ(oldest, std::string(64, 'a'));
+    EXPECT_TRUE(queue.try_push(rejected));
+}
+
+/***** LocalTransport ***********************************************/
+TEST(LocalTransportTest, FramesArriveWithoutCopyingTheirBullets) {
+    auto [transport, client] = make_local_connection();
+    auto stats = std::make_shared<InstanceStats>();
+
+    FrameSender frame_sender(*transport, stats);
+    frame_sender.start();
+
+    auto packet = make_frame(1, 1000);
+    const auto* bullets = std::get<FrameSnapshot>(packet.payload).bullet_vector.data();
+
+    frame_sender.send_frame(std::move(packet), { 7 });
+
+    // Sent on the calling thread, no send thread in between
+    auto received = client->poll_packet();
+    ASSERT_TRUE(received.has_value());
+
+    const auto& frame = std::get<FrameSnapshot>(received->packet.payload);
+    EXPECT_EQ(frame.timestamp, 1u);
+    EXPECT_EQ(frame.bullet_vector.data(), bullets);
+
+    ASSERT_TRUE(received->frame_ack.has_value());
+    EXPECT_EQ(received->frame_ack->last_input_sequence, 7u);
+    EXPECT_EQ(stats->frames_sent, 1u);
+}
+
+TEST(LocalTransportTest, LatestFrameWaitsWhileTheClientIsBehind) {
+    auto [transport, client] = make_local_connection();
+    auto stats = std::make_shared<InstanceStats>();
+
+    FrameSender frame_sender(*transport, stats);
+    frame_sender.start();
+
+    const auto capacity = local_transport_constants::TO_CLIENT_CAPACITY;
+
+    for (uint64_t tick = 1; tick <= capacity + 3; tick++)
+    {
+        frame_sender.send_frame(make_frame(tick, 0), {});
+    }
+
+    // The queue filled up, the frames after it replaced each other
+    EXPECT_EQ(stats->frames_sent, capacity);
+    EXPECT_EQ(stats->frames_coalesced, 2u);
+
+    for (uint64_t tick = 1; tick <= capacity; tick++)
+    {
+        EXPECT_EQ(std::get<FrameSnapshot>(client->poll_packet()->packet.payload).timestamp, tick);
+    }
+
+    // The latest one goes out on the next chance
+    frame_sender.stop();
+    EXPECT_EQ(std::get<FrameSnapshot>(client->poll_packet()->packet.payload).timestamp, capacity + 3);
+}
+
+TEST(LocalTransportTest, EmbeddedServerPlaysAGame) {
+    GameServerMaster master(0, 4);
+    master.run_local();
+
+    auto client = master.connect_local();
+    ASSERT_NE(client, nullptr);
+
+    ASSERT_TRUE(client->send_packet(make_packet<ClientHello>({})));
+    ASSERT_TRUE(wait_packet(*client, PayloadType::ServerAccept).has_value());
+
+    ASSERT_TRUE(client->send_packet(make_packet<ClientGameRequest>({})));
+    ASSERT_TRUE(wait_packet(*client, PayloadType::ServerGameResponse).has_value());
+
+    ClientInput input = {};
+    input.game_input.arrows.pressed = 1;
+    ASSERT_TRUE(client->send_packet(make_packet<ClientInput>(input), InputStamp{ 1, 0, 0 }));
+
+    // Frames keep coming, one tick after another, and acknowledge the input once it is applied
+    uint64_t last_timestamp = 0;
+    uint32_t last_ack = 0;
+
+    for (int i = 0; i < 5; i++)
+    {
+        auto frame_opt = wait_packet(*client, PayloadType::FrameSnapshot);
+        ASSERT_TRUE(frame_opt.has_value());
+        ASSERT_TRUE(frame_opt->frame_ack.has_value());
+
+        const auto timestamp = std::get<FrameSnapshot>(frame_opt->packet.payload).timestamp;
+        EXPECT_GT(timestamp, last_timestamp);
+        last_timestamp = timestamp;
+        last_ack = frame_opt->frame_ack->last_input_sequence;
+    }
+
+    EXPECT_EQ(last_ack, 1u);
+
+    ASSERT_TRUE(client->send_packet(make_packet<ClientGoodbye>({})));
+    ASSERT_TRUE(wait_packet(*client, PayloadType::ServerGoodbye).has_value());
+
+    // The instance is gone once it has disconnected
+    for (int attempt = 0; attempt < 1000 && master.get_active_instances() > 0; attempt++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_FALSE(client->is_connected());
+    EXPECT_EQ(master.get_active_instances(), 0u);
+
+    master.stop();
+}
@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+#include <game_server/packet_receiver.hpp>
+#include <game_server/payload_limits.hpp>
+#include <game_server/game_server_constants.hpp>
+#include <packet_stream/packet_stream.hpp>
+
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+
+namespace {
+    std::optional<ReceivedPacket> wait_for_packet(PacketReceiver& receiver) {
+        for (int attempt = 0; attempt < 200; attempt++)
+        {
+            if (auto packet_opt = receiver.poll_packet())
+            {
+                return packet_opt;
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        return std::nullopt;
+    }
+
+    bool wait_for_stop(PacketReceiver& receiver) {
+        for (int attempt = 0; attempt < 200 && receiver.is_running(); attempt++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+
+        return !receiver.is_running();
+    }
+
+    // Magic and version as this build stamps them
+    PacketHeader make_header(PayloadType payload_type, uint32_t payload_size) {
+        auto header = make_packet<ClientGoodbye>({}).header;
+        header.payload_type = payload_type;
+        header.payload_size = payload_size;
+
+        return header;
+    }
+
+    void write_header(int fd, const PacketHeader& header) {
+        ASSERT_EQ(write(fd, &header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+    }
+
+    void write_header(int fd, PayloadType payload_type, uint32_t payload_size) {
+        write_header(fd, make_header(payload_type, payload_size));
+    }
+}
+
+/***** Receive buffer pool ******************************************/
+TEST(ReceiveBufferPoolTest, BudgetCapsBlocksPerConnection) {
+    ReceiveBufferPool pool(64, 3);
+    ReceiveBudget budget_a(pool, 2);
+    ReceiveBudget budget_b(pool, 2);
+
+    auto* a1 = budget_a.acquire();
+    auto* a2 = budget_a.acquire();
+    ASSERT_NE(a1, nullptr);
+    ASSERT_NE(a2, nullptr);
+    EXPECT_EQ(budget_a.acquire(), nullptr);
+
+    // One block left in the pool
+    auto* b1 = budget_b.acquire();
+    ASSERT_NE(b1, nullptr);
+    EXPECT_EQ(budget_b.acquire(), nullptr);
+    EXPECT_EQ(pool.get_available(), 0u);
+
+    budget_a.release(a1);
+    EXPECT_NE(budget_b.acquire(), nullptr);
+
+    budget_a.release(a2);
+    EXPECT_EQ(budget_a.get_in_use(), 0u);
+}
+
+/***** Packet receiver **********************************************/
+TEST(PacketReceiverTest, DecodesClientInput) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    ClientInput input{};
+    input.game_input.arrows.pressed = 0x5;
+
+    write_header(fds[1], PayloadType::ClientInput, sizeof(input));
+    ASSERT_EQ(write(fds[1], &input, sizeof(input)), static_cast<ssize_t>(sizeof(input)));
+
+    auto packet_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(packet_opt.has_value());
+    ASSERT_EQ(packet_opt->packet.header.payload_type, PayloadType::ClientInput);
+    EXPECT_EQ(std::get<ClientInput>(packet_opt->packet.payload).game_input.arrows.pressed, 0x5);
+
+    // The block went back to the pool
+    EXPECT_EQ(pool.get_available(), 1u);
+
+    receiver.stop();
+    close(fds[1]);
+}
+
+TEST(PacketReceiverTest, DecodesWhatThePacketLibrarySerializes) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    // Bytes as the library puts them on the wire, not the structs of this build
+    PacketStreamServer library_stream(std::make_shared<ClientConnection>(fds[1]));
+
+    ClientInput input{};
+    input.game_input.arrows.pressed = 0x9;
+    input.game_input.arrows.released = 0x2;
+
+    ASSERT_TRUE(library_stream.send_packet(make_packet<ClientHello>({})));
+    ASSERT_TRUE(library_stream.send_packet(make_packet<ClientInput>(input)));
+    ASSERT_TRUE(library_stream.send_packet(make_packet<ClientGoodbye>({})));
+
+    auto hello_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(hello_opt.has_value());
+    EXPECT_EQ(hello_opt->packet.header.payload_type, PayloadType::ClientHello);
+
+    auto input_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(input_opt.has_value());
+    ASSERT_EQ(input_opt->packet.header.payload_type, PayloadType::ClientInput);
+    EXPECT_FALSE(input_opt->input_stamp.has_value());
+
+    const auto& arrows = std::get<ClientInput>(input_opt->packet.payload).game_input.arrows;
+    EXPECT_EQ(arrows.pressed, 0x9);
+    EXPECT_EQ(arrows.released, 0x2);
+
+    auto goodbye_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(goodbye_opt.has_value());
+    EXPECT_EQ(goodbye_opt->packet.header.payload_type, PayloadType::ClientGoodbye);
+
+    EXPECT_EQ(receiver.get_recv_exception(), nullptr);
+
+    receiver.stop();
+}
+
+TEST(PacketReceiverTest, RejectsOversizedPayloadFromHeader) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    // Only the header is sent, the claim alone ends the connection
+    write_header(fds[1], PayloadType::ClientInput, 10 * 1024 * 1024);
+
+    ASSERT_TRUE(wait_for_stop(receiver));
+    EXPECT_NE(receiver.get_recv_exception(), nullptr);
+    EXPECT_EQ(pool.get_available(), 1u);
+
+    close(fds[1]);
+}
+
+TEST(PacketReceiverTest, RejectsServerPayloadType) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    write_header(fds[1], PayloadType::FrameSnapshot, 16);
+
+    ASSERT_TRUE(wait_for_stop(receiver));
+    EXPECT_NE(receiver.get_recv_exception(), nullptr);
+
+    close(fds[1]);
+}
+
+TEST(PacketReceiverTest, RejectsForeignHeader) {
+    for (const auto corrupt : { &PacketHeader::magic, &PacketHeader::version })
+    {
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+        ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+        PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+        receiver.start();
+
+        // A valid type and size, but not from a client of this build
+        auto header = make_header(PayloadType::ClientGoodbye, sizeof(ClientGoodbye));
+        header.*corrupt ^= 0xA5A5A5A5u;
+
+        write_header(fds[1], header);
+
+        ASSERT_TRUE(wait_for_stop(receiver));
+        EXPECT_NE(receiver.get_recv_exception(), nullptr);
+        EXPECT_FALSE(receiver.poll_packet().has_value());
+        EXPECT_EQ(pool.get_available(), 1u);
+
+        close(fds[1]);
+    }
+}
+
+TEST(PacketReceiverTest, DecodesInputStamp) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    ClientInput input{};
+    InputStamp stamp{};
+    stamp.sequence = 42;
+    stamp.tick_offset = 1000;
+    stamp.client_tick = 7;
+
+    write_header(fds[1], PayloadType::ClientInput, sizeof(input) + sizeof(stamp));
+    ASSERT_EQ(write(fds[1], &input, sizeof(input)), static_cast<ssize_t>(sizeof(input)));
+    ASSERT_EQ(write(fds[1], &stamp, sizeof(stamp)), static_cast<ssize_t>(sizeof(stamp)));
+
+    auto packet_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(packet_opt.has_value());
+    ASSERT_TRUE(packet_opt->input_stamp.has_value());
+    EXPECT_EQ(packet_opt->input_stamp->sequence, 42u);
+    EXPECT_EQ(packet_opt->input_stamp->tick_offset, 1000);
+    EXPECT_EQ(packet_opt->input_stamp->client_tick, 7);
+
+    receiver.stop();
+    close(fds[1]);
+}
+
+TEST(PacketReceiverTest, DecodesResumeToken) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    ClientGameRequest request{};
+    const ResumeToken token = { 3, 0x1234567890ABCDEFull };
+
+    // A new game, then the game of the token
+    write_header(fds[1], PayloadType::ClientGameRequest, sizeof(request));
+    ASSERT_EQ(write(fds[1], &request, sizeof(request)), static_cast<ssize_t>(sizeof(request)));
+
+    write_header(fds[1], PayloadType::ClientGameRequest, sizeof(request) + sizeof(token));
+    ASSERT_EQ(write(fds[1], &request, sizeof(request)), static_cast<ssize_t>(sizeof(request)));
+    ASSERT_EQ(write(fds[1], &token, sizeof(token)), static_cast<ssize_t>(sizeof(token)));
+
+    auto new_game_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(new_game_opt.has_value());
+    EXPECT_FALSE(new_game_opt->resume_token.has_value());
+
+    auto resume_opt = wait_for_packet(receiver);
+    ASSERT_TRUE(resume_opt.has_value());
+    ASSERT_EQ(resume_opt->packet.header.payload_type, PayloadType::ClientGameRequest);
+    ASSERT_TRUE(resume_opt->resume_token.has_value());
+    EXPECT_EQ(*resume_opt->resume_token, token);
+
+    receiver.stop();
+    close(fds[1]);
+}
+
+TEST(PacketReceiverTest, StopDoesNotWaitOutThePoll) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    PacketReceiver receiver(std::make_shared<ClientConnection>(fds[0]), pool);
+    receiver.start();
+
+    // Into the wait for the next header
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    const auto start = std::chrono::steady_clock::now();
+    receiver.stop();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_LT(elapsed, std::chrono::milliseconds(receive_constants::POLL_TIMEOUT_MSEC / 2));
+    EXPECT_EQ(receiver.get_recv_exception(), nullptr);
+
+    // The socket is still open for a successor
+    ClientInput input{};
+    write_header(fds[1], PayloadType::ClientInput, sizeof(input));
+    ASSERT_EQ(write(fds[1], &input, sizeof(input)), static_cast<ssize_t>(sizeof(input)));
+
+    PacketHeader header{};
+    EXPECT_EQ(read(fds[0], &header, sizeof(header)), static_cast<ssize_t>(sizeof(header)));
+    EXPECT_EQ(header.payload_type, PayloadType::ClientInput);
+
+    close(fds[1]);
+}
@@ -0,0 +1,265 @@
+#include <gtest/gtest.h>
+#include <game_server/frame_json_writer.hpp>
+#include <game_server/game_server_constants.hpp>
+#include <playlog_analytics/playlog_parser.hpp>
+#include <playlog_analytics/playlog_store.hpp>
+#include <playlog_analytics/playlog_queries.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace {
+    FrameSnapshot make_frame(uint64_t timestamp, uint32_t stage_id, Vec2 player_pos, uint32_t bullet_count) {
+        FrameSnapshot frame = {};
+        frame.timestamp = timestamp;
+        frame.stage.id = stage_id;
+
+        PlayerSnapshot player = {};
+        player.pos = player_pos;
+        player.radius = game_constants::PLAYER_RADIUS;
+        player.lives = 1;
+        frame.player_vector.push_back(player);
+        frame.player_count = 1;
+
+        // Far from the player
+        for (uint32_t i = 0; i < bullet_count; i++)
+        {
+            BulletSnapshot bullet = {};
+            bullet.id = i;
+            bullet.pos = { player_pos.x + 100.0f, player_pos.y + 10.0f * i };
+            bullet.radius = game_constants::ENEMY_NORMAL_BULLET_RADIUS;
+            frame.bullet_vector.push_back(bullet);
+        }
+
+        frame.bullet_count = bullet_count;
+
+        return frame;
+    }
+
+    // The last frame ends the game with a bullet of `killer` on the player
+    void write_playlog(const fs::path& path, uint64_t instance_id, uint32_t stage_id, Vec2 death_pos, BulletName killer, uint64_t ticks) {
+        FrameJsonWriter writer;
+        std::ofstream file(path);
+
+        file << "{\"header\":{\"instance_id\":" << instance_id << ",\"rtt_usec\":0}}" << "\n";
+
+        for (uint64_t tick = 1; tick <= ticks; tick++)
+        {
+            auto frame = make_frame(tick, stage_id, death_pos, static_cast<uint32_t>(tick % 10));
+
+            if (tick == ticks)
+            {
+                BulletSnapshot bullet = {};
+                bullet.name = killer;
+                bullet.pos = { death_pos.x + 1.0f, death_pos.y };
+                bullet.radius = game_constants::ENEMY_RICE_BULLET_RADIUS;
+                frame.bullet_vector.push_back(bullet);
+                frame.bullet_count++;
+
+                frame.player_vector[0].lives = 0;
+                frame.state = GameState::GameOver;
+            }
+
+            file << writer.write(frame) << "\n";
+        }
+    }
+
+    fs::path make_temp_dir(const std::string& name) {
+        const auto dir = fs::temp_directory_path() / name;
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+
+        return dir;
+    }
+}
+
+/***** PlaylogParser ************************************************/
+TEST(PlaylogParserTest, ReadsTheFramesGameLoggerWrites) {
+    FrameJsonWriter writer;
+    PlaylogParser parser;
+
+    auto frame = make_frame(42, 3, { 12.5f, -80.0f }, 5);
+    PlaylogFrame parsed;
+
+    ASSERT_TRUE(parser.parse_frame(writer.write(frame), parsed));
+    EXPECT_EQ(parsed.timestamp, 42u);
+    EXPECT_EQ(parsed.stage_id, 3u);
+    EXPECT_FLOAT_EQ(parsed.player_x, 12.5f);
+    EXPECT_FLOAT_EQ(parsed.player_y, -80.0f);
+    EXPECT_EQ(parsed.bullet_count, 5u);
+    EXPECT_FALSE(parsed.game_over);
+    EXPECT_EQ(parsed.killer_name, NO_BULLET);
+
+    // Not a frame, and a line torn in the middle
+    EXPECT_FALSE(parser.parse_frame("{\"header\":{\"instance_id\":1}}", parsed));
+    EXPECT_FALSE(parser.parse_frame(std::string(writer.write(frame)).substr(0, 60), parsed));
+}
+
+TEST(PlaylogParserTest, TellsTheBulletThatEndedTheGame) {
+    const auto dir = make_temp_dir("playlog_parser_test");
+    write_playlog(dir / "a_playlog.json", 7, 0, { 0.0f, -100.0f }, BulletName::WedgeRed, 3);
+
+    std::ifstream file(dir / "a_playlog.json");
+    std::string line;
+    PlaylogParser parser;
+    PlaylogHeader header;
+    PlaylogFrame frame;
+
+    ASSERT_TRUE(std::getline(file, line));
+    ASSERT_TRUE(parser.parse_header(line, header));
+    EXPECT_EQ(header.instance_id, 7u);
+
+    while (std::getline(file, line))
+    {
+        ASSERT_TRUE(parser.parse_frame(line, frame));
+    }
+
+    EXPECT_TRUE(frame.game_over);
+    EXPECT_EQ(frame.killer_name, static_cast<uint32_t>(BulletName::WedgeRed));
+}
+
+TEST(PlaylogParserTest, TellsABulletThatPassedThroughThePlayer) {
+    FrameJsonWriter writer;
+    PlaylogParser parser;
+    PlaylogFrame previous;
+    PlaylogFrame parsed;
+
+    // A fast bullet crossed the player within the tick and is past it now
+    auto frame = make_frame(10, 0, { 0.0f, -100.0f }, 3);
+
+    BulletSnapshot fast = {};
+    fast.name = BulletName::WedgeRed;
+    fast.pos = { 0.0f, -40.0f };
+    fast.vel = { 0.0f, 80.0f };
+    fast.radius = game_constants::ENEMY_WEDGE_BULLET_RADIUS;
+    frame.bullet_vector.push_back(fast);
+    frame.bullet_count++;
+
+    frame.player_vector[0].lives = 0;
+    frame.state = GameState::GameOver;
+
+    ASSERT_TRUE(parser.parse_frame(writer.write(frame), parsed));
+    EXPECT_TRUE(parsed.game_over);
+    EXPECT_EQ(parsed.killer_name, static_cast<uint32_t>(BulletName::WedgeRed));
+
+    // The player moved through a bullet that stood still
+    ASSERT_TRUE(parser.parse_frame(writer.write(make_frame(20, 0, { -30.0f, -100.0f }, 0)), previous));
+
+    frame = make_frame(21, 0, { 30.0f, -100.0f }, 2);
+
+    BulletSnapshot still = {};
+    still.name = BulletName::RiceRed;
+    still.pos = { 0.0f, -100.0f };
+    still.radius = game_constants::ENEMY_RICE_BULLET_RADIUS;
+    frame.bullet_vector.push_back(still);
+    frame.bullet_count++;
+
+    frame.player_vector[0].lives = 0;
+    frame.state = GameState::GameOver;
+
+    // Only the frame before tells where the player came from
+    ASSERT_TRUE(parser.parse_frame(writer.write(frame), parsed));
+    EXPECT_EQ(parsed.killer_name, NO_BULLET);
+
+    ASSERT_TRUE(parser.parse_frame(writer.write(frame), parsed, &previous));
+    EXPECT_EQ(parsed.killer_name, static_cast<uint32_t>(BulletName::RiceRed));
+}
+
+/***** PlaylogStore *************************************************/
+TEST(PlaylogStoreTest, QueriesMatchTheIngestedPlaylogs) {
+    const auto logs = make_temp_dir("playlog_store_logs");
+    const auto store_dir = make_temp_dir("playlog_store");
+
+    // Stage 1: two deaths in the lower left corner, one in the upper right. Stage 2: one
+    write_playlog(logs / "1_playlog.json", 1, 1, { -180.0f, -200.0f }, BulletName::RiceRed, 120);
+    write_playlog(logs / "2_playlog.json", 2, 1, { -185.0f, -205.0f }, BulletName::RiceRed, 90);
+    write_playlog(logs / "3_playlog.json", 3, 1, { 150.0f, 200.0f }, BulletName::BigRed, 60);
+    write_playlog(logs / "4_playlog.json", 4, 2, { 0.0f, 0.0f }, BulletName::BigRed, 30);
+
+    // Not a playlog
+    std::ofstream(logs / "notes.txt") << "hello" << "\n";
+
+    const auto playlogs = PlaylogStore::find_playlogs({ logs.string() });
+    ASSERT_EQ(playlogs.size(), 4u);
+
+    WorkerPool worker_pool(2);
+    IngestResult result = {};
+
+    ASSERT_TRUE(PlaylogStore::ingest(playlogs, store_dir.string(), worker_pool, result));
+    EXPECT_EQ(result.sessions, 4u);
+    EXPECT_EQ(result.frames, 300u);
+    EXPECT_EQ(result.skipped_lines, 0u);
+
+    PlaylogStore store;
+    ASSERT_TRUE(store.open(store_dir.string()));
+    ASSERT_EQ(store.get_sessions().size(), 4u);
+
+    QueryFilter stage_1;
+    stage_1.stage_id = 1;
+
+    // Deaths
+    const auto heatmap = query_death_heatmap(store, stage_1, 32.0f);
+    EXPECT_EQ(heatmap.deaths, 3u);
+
+    const auto lower_left = heatmap.at(
+        static_cast<uint32_t>((-180.0f + game_constants::GAME_WIDTH_HALF) / 32.0f),
+        static_cast<uint32_t>((-200.0f + game_constants::GAME_HEIGHT_HALF) / 32.0f)
+    );
+    EXPECT_EQ(lower_left, 2u);
+
+    // Hits
+    const auto hits = query_hit_counts(store, stage_1);
+    ASSERT_EQ(hits.size(), 2u);
+    EXPECT_STREQ(bullet_name_str(hits[0].bullet_name), "rice_red");
+    EXPECT_EQ(hits[0].hits, 2u);
+    EXPECT_EQ(query_hit_counts(store, {}).size(), 2u);
+
+    // Density: ticks 1..59 of every stage 1 session hold tick % 10 bullets
+    const auto density = query_bullet_density(store, stage_1, 60, worker_pool);
+    ASSERT_EQ(density.frames.size(), 3u);
+    EXPECT_EQ(density.frames[0], 3u * 59u);
+    EXPECT_EQ(density.frames[1], 60u + 31u + 1u);
+    EXPECT_EQ(density.frames[2], 1u);
+
+    uint64_t bullets = 0;
+
+    for (uint64_t tick = 1; tick < 60; tick++)
+    {
+        bullets += tick % 10;
+    }
+
+    EXPECT_EQ(density.bullets[0], 3 * bullets);
+}
+
+TEST(PlaylogStoreTest, ReingestReplacesTheStore) {
+    const auto logs = make_temp_dir("playlog_reingest_logs");
+    const auto store_dir = make_temp_dir("playlog_reingest");
+
+    for (int i = 0; i < 12; i++)
+    {
+        write_playlog(logs / (std::to_string(i) + "_playlog.json"), i, 0, { 0.0f, 0.0f }, BulletName::BigRed, 10);
+    }
+
+    // A torn last line, as a crash would leave it
+    std::ofstream(logs / "0_playlog.json", std::ios::app) << "{\"timestamp\":11,\"sta";
+
+    WorkerPool worker_pool(3);
+    IngestResult result = {};
+
+    ASSERT_TRUE(PlaylogStore::ingest(PlaylogStore::find_playlogs({ logs.string() }), store_dir.string(), worker_pool, result));
+    EXPECT_EQ(result.sessions, 12u);
+    EXPECT_EQ(result.skipped_lines, 1u);
+
+    ASSERT_TRUE(PlaylogStore::ingest({ (logs / "3_playlog.json").string() }, store_dir.string(), worker_pool, result));
+
+    PlaylogStore store;
+    ASSERT_TRUE(store.open(store_dir.string()));
+    ASSERT_EQ(store.get_sessions().size(), 1u);
+    EXPECT_EQ(store.get_sessions()[0].instance_id, 3u);
+    EXPECT_EQ(store.get_source(0), "3_playlog.json");
+    EXPECT_EQ(store.get_segment_count(), 1u);
+    EXPECT_FALSE(fs::exists(store_dir / "segment_1.bin"));
+}
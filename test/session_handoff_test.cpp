@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <game_server/session_handoff.hpp>
+
+#include <future>
+#include <string>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+namespace {
+    // A fresh directory of this user only, as mkdtemp() creates it
+    std::string make_private_dir() {
+        char dir[] = "/tmp/handoff_test.XXXXXX";
+
+        return mkdtemp(dir) != nullptr ? std::string(dir) : std::string();
+    }
+
+    void remove_dir(const std::string& dir) {
+        unlink((dir + "/handoff.sock").c_str());
+        unlink((dir + "/handoff.sock.token").c_str());
+        rmdir(dir.c_str());
+    }
+
+    // Connects without the token, as any process of the host could
+    int connect_raw(const std::string& path) {
+        sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        path.copy(addr.sun_path, sizeof(addr.sun_path) - 1);
+
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            close(fd);
+
+            return -1;
+        }
+
+        return fd;
+    }
+}
+
+/***** Session handoff **********************************************/
+TEST(SessionHandoffTest, PassesStateAndSocket) {
+    int channel[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, channel), 0);
+
+    // Stands in for the client socket
+    int client[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, client), 0);
+
+    const std::vector<uint8_t> state = { 1, 2, 3, 4, 5 };
+    ASSERT_TRUE(send_session(channel[0], client[0], state));
+    ASSERT_TRUE(send_handoff_end(channel[0]));
+
+    int received_fd = -1;
+    std::vector<uint8_t> received_state;
+
+    ASSERT_TRUE(recv_session(channel[1], received_fd, received_state));
+    ASSERT_GE(received_fd, 0);
+    EXPECT_EQ(received_state, state);
+
+    // The received descriptor is the same connection
+    const char byte = 'x';
+    ASSERT_EQ(write(received_fd, &byte, 1), 1);
+
+    char echoed = 0;
+    ASSERT_EQ(read(client[1], &echoed, 1), 1);
+    EXPECT_EQ(echoed, 'x');
+    close(received_fd);
+
+    // End of the handoff
+    ASSERT_TRUE(recv_session(channel[1], received_fd, received_state));
+    EXPECT_EQ(received_fd, -1);
+
+    close(channel[0]);
+    close(channel[1]);
+    close(client[0]);
+    close(client[1]);
+}
+
+TEST(SessionHandoffTest, AcceptsOnlyAPeerWithTheToken) {
+    const auto dir = make_private_dir();
+    ASSERT_FALSE(dir.empty());
+
+    const auto path = dir + "/handoff.sock";
+
+    HandoffToken token = {};
+    const int listen_fd = open_handoff_listener(path, token);
+    ASSERT_GE(listen_fd, 0);
+
+    struct stat st = {};
+    ASSERT_EQ(stat(path.c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600u);
+    ASSERT_EQ(stat((path + ".token").c_str(), &st), 0);
+    EXPECT_EQ(st.st_mode & 0777, 0600u);
+
+    auto accepted = std::async(std::launch::async, [&] { return accept_handoff(listen_fd, token); });
+
+    // A stranger with a wrong token is turned away
+    const int stranger_fd = connect_raw(path);
+    ASSERT_GE(stranger_fd, 0);
+
+    const HandoffToken wrong = {};
+    ASSERT_EQ(write(stranger_fd, wrong.data(), wrong.size()), static_cast<ssize_t>(wrong.size()));
+
+    char byte = 0;
+    EXPECT_EQ(read(stranger_fd, &byte, 1), 0);
+
+    // The successor reads the token next to the socket
+    const int successor_fd = connect_handoff(path);
+    ASSERT_GE(successor_fd, 0);
+
+    const int peer_fd = accepted.get();
+    ASSERT_GE(peer_fd, 0);
+
+    ASSERT_TRUE(send_handoff_end(peer_fd));
+
+    int client_fd = 0;
+    std::vector<uint8_t> state;
+    ASSERT_TRUE(recv_session(successor_fd, client_fd, state));
+    EXPECT_EQ(client_fd, -1);
+
+    close(stranger_fd);
+    close(successor_fd);
+    close(peer_fd);
+    close(listen_fd);
+    remove_dir(dir);
+}
+
+TEST(SessionHandoffTest, RefusesADirectoryOthersMayEnter) {
+    const auto dir = make_private_dir();
+    ASSERT_FALSE(dir.empty());
+    ASSERT_EQ(chmod(dir.c_str(), 0755), 0);
+
+    HandoffToken token = {};
+    EXPECT_LT(open_handoff_listener(dir + "/handoff.sock", token), 0);
+
+    remove_dir(dir);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <game_server/session_memory.hpp>
+#include <game_server/game_session.hpp>
+
+#include <vector>
+
+/***** SessionMemory ************************************************/
+TEST(SessionMemoryTest, CountsPoolAllocations) {
+    SessionMemory memory(1024 * 1024);
+    const auto baseline = memory.get_usage().in_use;
+
+    {
+        std::pmr::vector<uint8_t> values(memory.pool());
+        values.resize(100000);
+
+        EXPECT_GE(memory.get_usage().in_use, baseline + 100000);
+    }
+
+    // Freed, the high water mark stays
+    EXPECT_LT(memory.get_usage().in_use, baseline + 100000);
+    EXPECT_GE(memory.get_usage().high_water, baseline + 100000);
+}
+
+TEST(SessionMemoryTest, ScratchIsRewoundEveryTick) {
+    SessionMemory memory(1024 * 1024);
+    const auto baseline = memory.get_usage().in_use;
+
+    for (int tick = 0; tick < 100; tick++)
+    {
+        std::pmr::vector<uint32_t> scratch(memory.scratch());
+        scratch.resize(64);
+
+        memory.end_tick();
+    }
+
+    // Small ticks stay within the first scratch block
+    EXPECT_EQ(memory.get_usage().in_use, baseline);
+}
+
+TEST(SessionMemoryTest, EnforcesCap) {
+    SessionMemory memory(256 * 1024);
+
+    std::pmr::vector<uint8_t> values(memory.pool());
+    EXPECT_THROW(values.resize(512 * 1024), SessionMemoryExceeded);
+
+    // External bytes count against the same cap
+    EXPECT_THROW(memory.set_external_bytes(512 * 1024), SessionMemoryExceeded);
+    EXPECT_NO_THROW(memory.set_external_bytes(1024));
+    EXPECT_GE(memory.get_usage().in_use, 1024u);
+}
+
+TEST(SessionMemoryTest, RunawaySessionHitsItsCap) {
+    BulletUpdater bullet_updater;
+
+    // Enough for the enemies, not for the bullets a long game piles up
+    GameSession session(7, nullptr, 52 * 1024);
+
+    EXPECT_THROW(
+        {
+            for (int tick = 0; tick < 3600; tick++)
+            {
+                session.step(bullet_updater);
+            }
+        },
+        SessionMemoryExceeded
+    );
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <game_server/socket_transport.hpp>
+#include <game_server/payload_limits.hpp>
+
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+#include <sys/socket.h>
+
+namespace {
+    bool read_exact(int fd, void* data, size_t size) {
+        auto* bytes = static_cast<uint8_t*>(data);
+
+        while (size > 0)
+        {
+            const auto n = read(fd, bytes, size);
+
+            if (n <= 0)
+            {
+                return false;
+            }
+
+            bytes += n;
+            size -= static_cast<size_t>(n);
+        }
+
+        return true;
+    }
+}
+
+/***** SocketTransport **********************************************/
+TEST(SocketTransportTest, FrameArrivesWithItsAck) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    SocketTransport transport(std::make_shared<ClientConnection>(fds[0]), pool);
+
+    FrameSnapshot frame = {};
+    frame.timestamp = 3;
+    frame.bullet_vector.resize(2);
+    frame.bullet_count = 2;
+
+    auto packet = make_packet<FrameSnapshot>(frame);
+    const auto frame_size = packet.header.payload_size;
+
+    ASSERT_TRUE(transport.send_frame(std::move(packet), { 42 }));
+
+    // As the client reads it: the header counts the ack, which follows the serialized frame
+    PacketHeader header{};
+    ASSERT_TRUE(read_exact(fds[1], &header, sizeof(header)));
+    EXPECT_EQ(header.payload_type, PayloadType::FrameSnapshot);
+    ASSERT_EQ(header.payload_size, frame_size + sizeof(FrameAck));
+
+    std::vector<uint8_t> payload(header.payload_size);
+    ASSERT_TRUE(read_exact(fds[1], payload.data(), payload.size()));
+
+    FrameAck ack{};
+    std::memcpy(&ack, payload.data() + frame_size, sizeof(ack));
+    EXPECT_EQ(ack.last_input_sequence, 42u);
+
+    // Nothing else on the stream
+    ASSERT_TRUE(transport.send_packet(make_packet<ServerGoodbye>({})));
+    ASSERT_TRUE(read_exact(fds[1], &header, sizeof(header)));
+    EXPECT_EQ(header.payload_type, PayloadType::ServerGoodbye);
+
+    close(fds[1]);
+}
+
+TEST(SocketTransportTest, GameResponseArrivesWithItsToken) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+
+    ReceiveBufferPool pool(payload_limits::RECEIVE_BLOCK_SIZE, 1);
+    SocketTransport transport(std::make_shared<ClientConnection>(fds[0]), pool);
+
+    auto packet = make_packet<ServerGameResponse>({});
+    const auto response_size = packet.header.payload_size;
+
+    ASSERT_TRUE(transport.send_game_response(std::move(packet), { 5, 77 }));
+
+    PacketHeader header{};
+    ASSERT_TRUE(read_exact(fds[1], &header, sizeof(header)));
+    EXPECT_EQ(header.payload_type, PayloadType::ServerGameResponse);
+    ASSERT_EQ(header.payload_size, response_size + sizeof(ResumeToken));
+
+    std::vector<uint8_t> payload(header.payload_size);
+    ASSERT_TRUE(read_exact(fds[1], payload.data(), payload.size()));
+
+    ResumeToken token{};
+    std::memcpy(&token, payload.data() + response_size, sizeof(token));
+    EXPECT_EQ(token.instance_id, 5u);
+    EXPECT_EQ(token.secret, 77u);
+
+    close(fds[1]);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <game_server/game_server_constants.hpp>
+#include <game_server/game_session.hpp>
+#include <game_server/stage_timeline.hpp>
+
+#include <cstring>
+
+namespace {
+    StageDesc make_stage(uint32_t interval, uint32_t start_tick) {
+        StageEnemyDesc enemy;
+        enemy.body = { 0, EnemyName::Default, game_constants::ENEMY_RADIUS };
+        enemy.transform = { { 0, 120 }, { 0, 0 } };
+        enemy.emitters = {
+            { EmitterPattern::Circle, interval, 0, 0, start_tick, 4, 2.0f, BulletName::BigRed, game_constants::ENEMY_BIG_BULLET_RADIUS },
+        };
+
+        StageDesc stage;
+        stage.name = "test";
+        stage.enemies.push_back(enemy);
+
+        return stage;
+    }
+
+    std::vector<uint32_t> to_vector(EventRange<uint32_t> range) {
+        return { range.begin(), range.end() };
+    }
+}
+
+/***** StageTimeline ************************************************/
+TEST(StageTimelineTest, DefaultStageMatchesPerTickEmitterScan) {
+    const uint32_t seed = 99;
+    BulletUpdater session_bullets;
+    BulletUpdater reference_bullets;
+    GameSession session(seed);
+
+    // The enemy tick as it was before timelines: every emitter tests its schedule every tick
+    EnemyWorld world;
+    spawn_default_enemy(world, 0, { 0, 120 });
+
+    auto frame = session.get_frame();
+    std::mt19937 gen(seed);
+    uint32_t bullet_id = 0;
+
+    for (int tick = 0; tick < 2000; tick++)
+    {
+        session.step(session_bullets);
+
+        frame.timestamp++;
+        update_enemies(world, frame, gen, bullet_id);
+        reference_bullets.update(frame);
+
+        const auto& actual = session.get_frame();
+        ASSERT_EQ(actual.bullet_vector.size(), frame.bullet_vector.size()) << "tick " << frame.timestamp;
+        ASSERT_EQ(actual.enemy_vector.size(), frame.enemy_vector.size());
+
+        for (size_t i = 0; i < frame.bullet_vector.size(); i++)
+        {
+            ASSERT_EQ(actual.bullet_vector[i].id, frame.bullet_vector[i].id);
+            ASSERT_EQ(actual.bullet_vector[i].name, frame.bullet_vector[i].name);
+            ASSERT_EQ(std::memcmp(&actual.bullet_vector[i].pos, &frame.bullet_vector[i].pos, sizeof(Vec2)), 0);
+            ASSERT_EQ(std::memcmp(&actual.bullet_vector[i].vel, &frame.bullet_vector[i].vel, sizeof(Vec2)), 0);
+        }
+
+        ASSERT_EQ(std::memcmp(&actual.enemy_vector[0].pos, &frame.enemy_vector[0].pos, sizeof(Vec2)), 0);
+    }
+}
+
+TEST(StageTimelineTest, RejectsInvalidStages) {
+    std::string error;
+
+    EXPECT_EQ(StageTimeline::compile(StageDesc{ "empty", {} }, error), nullptr);
+    EXPECT_NE(error.find("no enemies"), std::string::npos);
+
+    auto outside = make_stage(10, 0);
+    outside.enemies[0].transform.pos = { 0, game_constants::GAME_HEIGHT_HALF + 1 };
+    EXPECT_EQ(StageTimeline::compile(outside, error), nullptr);
+    EXPECT_NE(error.find("outside the stage"), std::string::npos);
+
+    EXPECT_EQ(StageTimeline::compile(make_stage(0, 0), error), nullptr);
+    EXPECT_NE(error.find("emitter 0: interval"), std::string::npos);
+
+    auto too_many = make_stage(10, 0);
+    too_many.enemies[0].emitters[0].count = stage_constants::MAX_PATTERN_BULLETS + 1;
+    EXPECT_EQ(StageTimeline::compile(too_many, error), nullptr);
+
+    // Two coprime intervals that only line up after far too long
+    auto long_loop = make_stage(7919, 0);
+    long_loop.enemies[0].emitters.push_back(long_loop.enemies[0].emitters[0]);
+    long_loop.enemies[0].emitters[1].interval = 7907;
+    EXPECT_EQ(StageTimeline::compile(long_loop, error), nullptr);
+    EXPECT_NE(error.find("repeat"), std::string::npos);
+}
+
+TEST(StageTimelineTest, LaterTicksMapBackIntoTheLoop) {
+    std::string error;
+    const auto timeline = StageTimeline::compile(make_stage(7, 100), error);
+    ASSERT_NE(timeline, nullptr) << error;
+
+    EXPECT_EQ(timeline->get_loop_start(), 100u);
+    EXPECT_EQ(timeline->get_loop_period(), 7u);
+
+    for (uint64_t tick = 0; tick < 100000; tick++)
+    {
+        const auto due = tick % 7 == 0 && tick > 100;
+
+        ASSERT_EQ(timeline->fires_at(tick).empty(), !due) << "tick " << tick;
+    }
+}
+
+TEST(StageTimelineTest, SpawnsLaterEnemiesOnTheirTick) {
+    auto stage = make_stage(10, 0);
+    auto late = stage.enemies[0];
+    late.spawn_tick = 50;
+    late.body.id = 1;
+    stage.enemies.push_back(late);
+
+    std::string error;
+    const auto timeline = StageTimeline::compile(stage, error);
+    ASSERT_NE(timeline, nullptr) << error;
+
+    EXPECT_EQ(timeline->spawns_at(0).end() - timeline->spawns_at(0).begin(), 1);
+    EXPECT_EQ(timeline->spawns_at(50).begin()->enemy, 1u);
+    EXPECT_EQ(timeline->get_first_slot(1), 1u);
+
+    // The late enemy fires from the tick after its spawn
+    EXPECT_EQ(to_vector(timeline->fires_at(50)), std::vector<uint32_t>({ 0 }));
+    EXPECT_EQ(to_vector(timeline->fires_at(60)), std::vector<uint32_t>({ 0, 1 }));
+
+    BulletUpdater bullet_updater;
+    GameSession session(1, timeline);
+
+    for (int tick = 0; tick < 50; tick++)
+    {
+        EXPECT_EQ(session.get_frame().enemy_vector.size(), 1u);
+        session.step(bullet_updater);
+    }
+
+    EXPECT_EQ(session.get_frame().enemy_vector.size(), 2u);
+}
+
+TEST(StageTimelineTest, RestoreRequiresTheSameStage) {
+    std::string error;
+    const auto timeline = StageTimeline::compile(make_stage(10, 0), error);
+    ASSERT_NE(timeline, nullptr) << error;
+
+    BulletUpdater bullet_updater;
+    GameSession session(1, timeline);
+    session.step(bullet_updater);
+
+    StateWriter writer;
+    session.serialize(writer);
+
+    GameSession same_stage(0, timeline);
+    StateReader same_reader(writer.get_buffer());
+    EXPECT_TRUE(same_stage.deserialize(same_reader));
+
+    GameSession default_stage(0);
+    StateReader default_reader(writer.get_buffer());
+    EXPECT_FALSE(default_stage.deserialize(default_reader));
+}